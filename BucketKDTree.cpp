@@ -0,0 +1,209 @@
+#include "BucketKDTree.h"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+using namespace std;
+
+static inline float coordenada(const Punto2D& p, int eje) {
+    return (eje == 0) ? p.x : p.y;
+}
+
+// Rama pendiente: nodo interno (o hoja) y distancia al cuadrado a su plano
+struct Pendiente {
+    size_t indice;
+    int profundidad;
+    float distanciaPlano;
+};
+
+static constexpr int ALTURA_MAXIMA = 64;
+
+// ============ CONSTRUCCION
+// Complejidad: O(n log(n / B)). Cada nivel divide el rango por la mitad con
+// nth_element; el corte queda en cortes[indice] y [inicio, medio) <= corte <= [medio, fin).
+void BucketKDTree::buildRec(vector<Punto2D>& puntos, size_t inicio, size_t fin,
+                            size_t indice, int profundidad) {
+    size_t internos = (size_t(1) << altura) - 1;
+
+    if (profundidad == altura) {
+        // Hoja: los puntos ya estan en su posicion final, copiarlos a SoA
+        inicioHoja[indice - internos] = inicio;
+        for (size_t i = inicio; i < fin; i++) {
+            xs[i] = puntos[i].x;
+            ys[i] = puntos[i].y;
+        }
+        return;
+    }
+
+    int eje = profundidad % 2;
+    size_t medio = inicio + (fin - inicio) / 2;
+    if (inicio < fin) {
+        nth_element(puntos.begin() + inicio, puntos.begin() + medio, puntos.begin() + fin,
+                    [eje](const Punto2D& a, const Punto2D& b) {
+                        return coordenada(a, eje) < coordenada(b, eje);
+                    });
+        cortes[indice] = (medio < fin) ? coordenada(puntos[medio], eje) : 0.f;
+    }
+
+    buildRec(puntos, inicio, medio, 2 * indice + 1, profundidad + 1);
+    buildRec(puntos, medio, fin, 2 * indice + 2, profundidad + 1);
+}
+
+BucketKDTree::BucketKDTree(vector<Punto2D> puntos, int tamanoHoja)
+    : tamanoHoja(max(1, min(tamanoHoja, HOJA_MAXIMA))) {
+    size_t n = puntos.size();
+    size_t hojasMinimas = (n + this->tamanoHoja - 1) / this->tamanoHoja;
+    while ((size_t(1) << altura) < hojasMinimas) altura++;
+
+    size_t hojas = size_t(1) << altura;
+    cortes.assign(hojas - 1, 0.f);
+    inicioHoja.assign(hojas + 1, n);
+    xs.resize(n);
+    ys.resize(n);
+
+    buildRec(puntos, 0, n, 0, 0);
+}
+
+// ============ VECINO MAS CERCANO
+// Descenso por los cortes sin recursion; en cada hoja un solo kernel SIMD
+// evalua las distancias del bloque y devuelve el minimo.
+Punto2D BucketKDTree::nearest(const Punto2D& objetivo) const {
+    if (xs.empty()) return {0.f, 0.f};
+
+    const float q[2] = {objetivo.x, objetivo.y};
+    const size_t internos = cortes.size();
+    float mejorDistancia = numeric_limits<float>::infinity();
+    size_t mejor = 0;
+
+    Pendiente pila[ALTURA_MAXIMA];
+    int tope = 0;
+    pila[tope++] = {0, 0, 0.f};
+
+    while (tope > 0) {
+        Pendiente actual = pila[--tope];
+        if (actual.distanciaPlano >= mejorDistancia) continue;
+
+        size_t i = actual.indice;
+        for (int prof = actual.profundidad; prof < altura; prof++) {
+            float diff = q[prof & 1] - cortes[i];
+            size_t lado = (diff >= 0.f);
+            if (diff * diff < mejorDistancia) {
+                pila[tope++] = {2 * i + 2 - lado, prof + 1, diff * diff};
+            }
+            i = 2 * i + 1 + lado;
+        }
+
+        size_t hoja = i - internos;
+        size_t inicio = inicioHoja[hoja];
+        size_t fin = inicioHoja[hoja + 1];
+        if (inicio == fin) continue;
+
+        float d;
+        size_t local = kernels->masCercano(xs.data() + inicio, ys.data() + inicio, fin - inicio,
+                                           q[0], q[1], &d);
+        if (d < mejorDistancia) {
+            mejorDistancia = d;
+            mejor = inicio + local;
+        }
+    }
+
+    return {xs[mejor], ys[mejor]};
+}
+
+// ============ K VECINOS MAS CERCANOS
+vector<Punto2D> BucketKDTree::kNearest(const Punto2D& objetivo, int k) const {
+    vector<Punto2D> resultado;
+    if (xs.empty() || k <= 0) return resultado;
+
+    const float q[2] = {objetivo.x, objetivo.y};
+    const size_t internos = cortes.size();
+    vector<pair<float, Punto2D>> pq;  // max-heap de tamano k
+    pq.reserve(k);
+    float distancias[HOJA_MAXIMA];
+
+    Pendiente pila[ALTURA_MAXIMA];
+    int tope = 0;
+    pila[tope++] = {0, 0, 0.f};
+
+    while (tope > 0) {
+        Pendiente actual = pila[--tope];
+        if (pq.size() == (size_t)k && actual.distanciaPlano >= pq.front().first) continue;
+
+        size_t i = actual.indice;
+        for (int prof = actual.profundidad; prof < altura; prof++) {
+            float diff = q[prof & 1] - cortes[i];
+            size_t lado = (diff >= 0.f);
+            if (pq.size() < (size_t)k || diff * diff < pq.front().first) {
+                pila[tope++] = {2 * i + 2 - lado, prof + 1, diff * diff};
+            }
+            i = 2 * i + 1 + lado;
+        }
+
+        size_t hoja = i - internos;
+        size_t inicio = inicioHoja[hoja];
+        size_t cantidad = inicioHoja[hoja + 1] - inicio;
+        kernels->distancias(xs.data() + inicio, ys.data() + inicio, cantidad, q[0], q[1], distancias);
+
+        for (size_t j = 0; j < cantidad; j++) {
+            float d = distancias[j];
+            if (pq.size() < (size_t)k) {
+                pq.push_back({d, {xs[inicio + j], ys[inicio + j]}});
+                push_heap(pq.begin(), pq.end());
+            } else if (d < pq.front().first) {
+                pop_heap(pq.begin(), pq.end());
+                pq.back() = {d, {xs[inicio + j], ys[inicio + j]}};
+                push_heap(pq.begin(), pq.end());
+            }
+        }
+    }
+
+    sort_heap(pq.begin(), pq.end());
+    resultado.reserve(pq.size());
+    for (const auto& item : pq) resultado.push_back(item.second);
+    return resultado;
+}
+
+// ============ BUSQUEDA POR RANGO
+vector<Punto2D> BucketKDTree::rangeSearch(const Rectangulo& rectangulo) const {
+    vector<Punto2D> resultado;
+    if (xs.empty()) return resultado;
+
+    const float minimo[2] = {rectangulo.xmin, rectangulo.ymin};
+    const float maximo[2] = {rectangulo.xmax, rectangulo.ymax};
+    const size_t internos = cortes.size();
+    uint32_t indices[HOJA_MAXIMA];
+
+    Pendiente pila[ALTURA_MAXIMA];
+    int tope = 0;
+    pila[tope++] = {0, 0, 0.f};
+
+    while (tope > 0) {
+        Pendiente actual = pila[--tope];
+        size_t i = actual.indice;
+        int prof = actual.profundidad;
+
+        // Bajar mientras haya un unico hijo que visitar; el derecho queda apilado
+        bool descartado = false;
+        for (; prof < altura; prof++) {
+            float corte = cortes[i];
+            bool izquierda = minimo[prof & 1] <= corte;
+            bool derecha = maximo[prof & 1] >= corte;
+            if (izquierda && derecha) pila[tope++] = {2 * i + 2, prof + 1, 0.f};
+            if (izquierda) i = 2 * i + 1;
+            else if (derecha) i = 2 * i + 2;
+            else { descartado = true; break; }
+        }
+        if (descartado) continue;
+
+        size_t hoja = i - internos;
+        size_t inicio = inicioHoja[hoja];
+        size_t cantidad = inicioHoja[hoja + 1] - inicio;
+        size_t encontrados = kernels->enRectangulo(xs.data() + inicio, ys.data() + inicio, cantidad,
+                                                   rectangulo, indices);
+        for (size_t j = 0; j < encontrados; j++) {
+            resultado.push_back({xs[inicio + indices[j]], ys[inicio + indices[j]]});
+        }
+    }
+
+    return resultado;
+}
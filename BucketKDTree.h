@@ -0,0 +1,46 @@
+#pragma once
+#include "KDTree.h"
+#include "SimdKernels.h"
+#include <cstddef>
+#include <vector>
+
+// KD-tree estatico con hojas agrupadas (buckets) en estructura de arreglos.
+//
+// Los nodos internos solo guardan el valor de corte (arbol perfecto en orden
+// Eytzinger, eje = profundidad % 2). La particion se detiene cuando cada hoja
+// tiene como mucho B puntos; esos puntos quedan contiguos en x[] / y[] y se
+// recorren con los kernels SIMD de SimdKernels.h (AVX2 / SSE / escalar segun la
+// CPU) en vez de bajar nodo a nodo con distanciaCuadrado.
+class BucketKDTree {
+public:
+    static constexpr int HOJA_DEFECTO = 32;
+    static constexpr int HOJA_MAXIMA = 256;
+
+    BucketKDTree() = default;
+    // tamanoHoja se limita a [1, HOJA_MAXIMA]
+    explicit BucketKDTree(std::vector<Punto2D> puntos, int tamanoHoja = HOJA_DEFECTO);
+
+    Punto2D nearest(const Punto2D& objetivo) const;
+    std::vector<Punto2D> kNearest(const Punto2D& objetivo, int k) const;
+    std::vector<Punto2D> rangeSearch(const Rectangulo& rectangulo) const;
+
+    std::size_t size() const { return xs.size(); }
+    int leafSize() const { return tamanoHoja; }
+    std::size_t leafCount() const { return inicioHoja.empty() ? 0 : inicioHoja.size() - 1; }
+
+    // Permite fijar un nivel SIMD concreto (benchmarks); por defecto kernelsActivos()
+    void setKernels(const KernelsDistancia& nuevos) { kernels = &nuevos; }
+    const KernelsDistancia& getKernels() const { return *kernels; }
+
+private:
+    int tamanoHoja = HOJA_DEFECTO;
+    int altura = 0;                       // niveles internos; hay 2^altura hojas
+    std::vector<float> cortes;            // 2^altura - 1 valores de corte (Eytzinger)
+    std::vector<std::size_t> inicioHoja;  // hoja j = [inicioHoja[j], inicioHoja[j + 1])
+    std::vector<float> xs;
+    std::vector<float> ys;
+    const KernelsDistancia* kernels = &kernelsActivos();
+
+    void buildRec(std::vector<Punto2D>& puntos, std::size_t inicio, std::size_t fin,
+                  std::size_t indice, int profundidad);
+};
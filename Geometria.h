@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+
+// Tipos geometricos de los KD-trees.
+//  - Punto2D / Rectangulo: el caso 2D float (KDTree, StaticKDTree, BucketKDTree,
+//    visualizador), con campos con nombre.
+//  - PuntoND / CajaND: coordenadas de tipo T en D dimensiones (KDTreeND).
+// Todos ofrecen el acceso por eje p[e], caja.inferior(e) y caja.superior(e);
+// con e constante de compilacion el acceso se reduce al campo concreto.
+
+// Contenedor para coordenadas 2D
+struct Punto2D {
+    float x;
+    float y;
+
+    // Operador de comparación necesario para std::pair en heap
+    bool operator<(const Punto2D& other) const {
+        if (x != other.x) return x < other.x;
+        return y < other.y;
+    }
+
+    float& operator[](std::size_t eje) { return (eje == 0) ? x : y; }
+    const float& operator[](std::size_t eje) const { return (eje == 0) ? x : y; }
+};
+
+// Rectangulo para busqueda por rango
+struct Rectangulo {
+    float xmin, xmax;
+    float ymin, ymax;
+
+    float& inferior(std::size_t eje) { return (eje == 0) ? xmin : ymin; }
+    float& superior(std::size_t eje) { return (eje == 0) ? xmax : ymax; }
+    const float& inferior(std::size_t eje) const { return (eje == 0) ? xmin : ymin; }
+    const float& superior(std::size_t eje) const { return (eje == 0) ? xmax : ymax; }
+};
+
+template <class T, std::size_t D>
+struct PuntoND {
+    T coordenadas[D];
+
+    T& operator[](std::size_t eje) { return coordenadas[eje]; }
+    const T& operator[](std::size_t eje) const { return coordenadas[eje]; }
+
+    // Orden lexicografico (desempate en los heaps de k-NN)
+    bool operator<(const PuntoND& otro) const {
+        for (std::size_t e = 0; e < D; e++) {
+            if (coordenadas[e] != otro.coordenadas[e]) return coordenadas[e] < otro.coordenadas[e];
+        }
+        return false;
+    }
+};
+
+// Caja alineada con los ejes: [minimo[e], maximo[e]] en cada eje
+template <class T, std::size_t D>
+struct CajaND {
+    T minimo[D];
+    T maximo[D];
+
+    T& inferior(std::size_t eje) { return minimo[eje]; }
+    T& superior(std::size_t eje) { return maximo[eje]; }
+    const T& inferior(std::size_t eje) const { return minimo[eje]; }
+    const T& superior(std::size_t eje) const { return maximo[eje]; }
+};
+
+// Tipos de punto y caja de KDTreeND<T, D>. En 2D float son Punto2D y
+// Rectangulo, asi KDTree = KDTreeND<float, 2> no necesita conversiones.
+template <class T, std::size_t D>
+struct GeometriaKD {
+    using Punto = PuntoND<T, D>;
+    using Caja = CajaND<T, D>;
+};
+
+template <>
+struct GeometriaKD<float, 2> {
+    using Punto = Punto2D;
+    using Caja = Rectangulo;
+};
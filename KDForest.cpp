@@ -0,0 +1,141 @@
+#include "KDForest.h"
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+static inline float distanciaCuadrado(const Punto2D& a, const Punto2D& b) {
+    float dx = a.x - b.x;
+    float dy = a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+// Distancia al cuadrado desde p a la caja envolvente de un arbol (0 si esta dentro)
+static inline float distanciaCaja(const Punto2D& p, const Rectangulo& caja) {
+    float dx = std::max(std::max(caja.xmin - p.x, p.x - caja.xmax), 0.f);
+    float dy = std::max(std::max(caja.ymin - p.y, p.y - caja.ymax), 0.f);
+    return dx * dx + dy * dy;
+}
+
+// ============ CONSTRUCCION
+KDForest::KDForest(std::vector<Punto2D> puntos) : total(puntos.size()) {
+    size_t inicio = 0;
+    for (size_t nivel = 0; (total >> nivel) != 0; nivel++) {
+        arboles.emplace_back();
+        if (((total >> nivel) & 1) == 0) continue;
+
+        size_t cantidad = size_t(1) << nivel;
+        arboles[nivel].build(std::vector<Punto2D>(puntos.begin() + inicio,
+                                                  puntos.begin() + inicio + cantidad));
+        inicio += cantidad;
+    }
+}
+
+// ============ INSERCION
+// Contador binario: los niveles 0..j-1 estan ocupados y j libre; sus 2^j - 1
+// puntos mas el nuevo forman el arbol de 2^j puntos del nivel j.
+void KDForest::insert(const Punto2D& punto) {
+    acarreo.clear();
+    acarreo.push_back(punto);
+
+    size_t nivel = 0;
+    while (nivel < arboles.size() && arboles[nivel].size() != 0) {
+        std::vector<Punto2D> puntosNivel = arboles[nivel].points();
+        acarreo.insert(acarreo.end(), puntosNivel.begin(), puntosNivel.end());
+        arboles[nivel].clear();
+        nivel++;
+    }
+    if (nivel == arboles.size()) arboles.emplace_back();
+
+    arboles[nivel].build(acarreo);
+    total++;
+}
+
+// ============ CONSULTAS
+// Los arboles se visitan de mayor a menor (el mayor tiene la mitad de los
+// puntos y suele dar el mejor radio inicial); un arbol cuya caja envolvente
+// queda mas lejos que el mejor candidato no se consulta.
+Punto2D KDForest::nearest(const Punto2D& objetivo) const {
+    Punto2D mejor = {0.f, 0.f};
+    float mejorDistancia = std::numeric_limits<float>::infinity();
+
+    for (size_t i = arboles.size(); i-- > 0;) {
+        const KDNode* raiz = arboles[i].getRoot();
+        if (raiz == nullptr || distanciaCaja(objetivo, raiz->caja) >= mejorDistancia) continue;
+
+        Punto2D candidato = arboles[i].nearest(objetivo);
+        float distancia = distanciaCuadrado(objetivo, candidato);
+        if (distancia < mejorDistancia) {
+            mejorDistancia = distancia;
+            mejor = candidato;
+        }
+    }
+    return mejor;
+}
+
+std::vector<Punto2D> KDForest::kNearest(const Punto2D& objetivo, int k) const {
+    std::vector<std::pair<float, Punto2D>> candidatos;
+    if (k <= 0) return {};
+
+    // Cota: distancia del k-esimo candidato una vez reunidos k
+    float cota = std::numeric_limits<float>::infinity();
+    for (size_t i = arboles.size(); i-- > 0;) {
+        const KDNode* raiz = arboles[i].getRoot();
+        if (raiz == nullptr || distanciaCaja(objetivo, raiz->caja) >= cota) continue;
+
+        for (const Punto2D& p : arboles[i].kNearest(objetivo, k)) {
+            candidatos.push_back({distanciaCuadrado(objetivo, p), p});
+        }
+        if (candidatos.size() >= (size_t)k) {
+            std::nth_element(candidatos.begin(), candidatos.begin() + (k - 1), candidatos.end());
+            candidatos.resize(k);
+            cota = candidatos[k - 1].first;
+        }
+    }
+
+    std::sort(candidatos.begin(), candidatos.end());
+    if (candidatos.size() > (size_t)k) candidatos.resize(k);
+
+    std::vector<Punto2D> resultado;
+    resultado.reserve(candidatos.size());
+    for (const auto& c : candidatos) resultado.push_back(c.second);
+    return resultado;
+}
+
+std::vector<Punto2D> KDForest::rangeSearch(const Rectangulo& rectangulo) const {
+    std::vector<Punto2D> resultado;
+    for (const KDTree& arbol : arboles) {
+        if (arbol.getRoot() == nullptr) continue;
+        std::vector<Punto2D> parcial = arbol.rangeSearch(rectangulo);
+        resultado.insert(resultado.end(), parcial.begin(), parcial.end());
+    }
+    return resultado;
+}
+
+size_t KDForest::rangeCount(const Rectangulo& rectangulo) const {
+    size_t cuenta = 0;
+    for (const KDTree& arbol : arboles) cuenta += arbol.rangeCount(rectangulo);
+    return cuenta;
+}
+
+// ============ ACCESO
+std::vector<Punto2D> KDForest::points() const {
+    std::vector<Punto2D> resultado;
+    resultado.reserve(total);
+    for (const KDTree& arbol : arboles) {
+        std::vector<Punto2D> parcial = arbol.points();
+        resultado.insert(resultado.end(), parcial.begin(), parcial.end());
+    }
+    return resultado;
+}
+
+void KDForest::clear() {
+    arboles.clear();
+    acarreo.clear();
+    total = 0;
+}
+
+size_t KDForest::treeCount() const {
+    size_t ocupados = 0;
+    for (const KDTree& arbol : arboles) ocupados += (arbol.size() != 0);
+    return ocupados;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "KDTree.h"
+#include <cstddef>
+#include <vector>
+
+// Bosque de KD-trees estaticos por el metodo logaritmico (Bentley-Saxe).
+//
+// arboles[i] esta vacio o contiene exactamente 2^i puntos en un KDTree
+// construido con particion en la mediana (perfectamente balanceado). insert
+// funciona como un contador binario: el punto nuevo y todos los niveles
+// ocupados consecutivos desde el 0 se funden en un unico arbol en el primer
+// nivel libre. Cada punto se reconstruye O(log n) veces, cada vez en
+// O(log n) amortizado: insert O(log^2 n) amortizado sin degradarse con
+// ningun orden de llegada. Las consultas recorren los O(log n) arboles y
+// combinan sus resultados.
+class KDForest {
+public:
+    KDForest() = default;
+    // Reparte los puntos segun los bits de n: un arbol por bit activo
+    explicit KDForest(std::vector<Punto2D> puntos);
+
+    void insert(const Punto2D& punto);
+
+    Punto2D nearest(const Punto2D& objetivo) const;
+    std::vector<Punto2D> kNearest(const Punto2D& objetivo, int k) const;
+    std::vector<Punto2D> rangeSearch(const Rectangulo& rectangulo) const;
+    std::size_t rangeCount(const Rectangulo& rectangulo) const;
+
+    std::size_t size() const { return total; }
+    std::vector<Punto2D> points() const;
+    void clear();
+
+    // Niveles ocupados (arboles no vacios) y acceso a cada nivel
+    std::size_t treeCount() const;
+    std::size_t levels() const { return arboles.size(); }
+    const KDTree& tree(std::size_t nivel) const { return arboles[nivel]; }
+
+private:
+    std::vector<KDTree> arboles;      // arboles[i]: vacio o 2^i puntos
+    std::vector<Punto2D> acarreo;     // buffer reutilizado al fundir niveles
+    std::size_t total = 0;
+};
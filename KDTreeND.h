@@ -0,0 +1,2352 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Geometria.h"
+#include "LatencyHistogram.h"
+#include "NodeArena.h"
+#include "ThreadPool.h"
+#include "TraversalStack.h"
+
+// KD-tree generico de solo cabecera: coordenadas T (float, double o int32) en
+// D dimensiones (1 a 8). El eje de cada nivel es profundidad % D; los
+// recorridos avanzan D niveles por vuelta con el eje como constante de
+// compilacion (p[eje] se resuelve al campo concreto, sin modulo ni
+// seleccion en tiempo de ejecucion) y las distancias se desenrollan eje a eje.
+// KDTree (KDTree.h) es KDTreeND<float, 2>.
+
+// Estadisticas del auto-balanceo (ver KDTreeND::setBalanceAlpha)
+struct EstadisticasBalance {
+    std::size_t reconstrucciones = 0;    // subarboles reconstruidos
+    std::size_t nodosReconstruidos = 0;  // suma de sus tamanos
+    int altura = 0;                      // altura actual del arbol
+    int alturaPermitida = 0;             // cota vigente: log_{1/alpha}(n) + 1 + holgura (0 sin balanceo)
+};
+
+// Resultado de una consulta aproximada (ver KDTreeND::nearestApprox)
+struct InformeAproximado {
+    bool exacto = true;              // ninguna rama se descarto solo por epsilon ni por el presupuesto:
+                                     // el resultado es el exacto
+    std::size_t nodosVisitados = 0;  // nodos cuya distancia se evaluo
+};
+
+// Contadores del recorrido de una consulta (ver KDTreeND::nearest(objetivo, stats)).
+// Se acumulan entre llamadas con el mismo QueryStats (profundidadMaxima guarda
+// el maximo): para medir una sola consulta, empezar con QueryStats{}.
+struct QueryStats {
+    std::size_t nodosVisitados = 0;     // nodos cuyo punto se examino
+    std::size_t subarbolesPodados = 0;  // ramas no vacias descartadas sin entrar
+    std::size_t distancias = 0;         // evaluaciones geometricas: distancias punto-punto y
+                                        // punto-caja (nearest / kNearest), pruebas contra el
+                                        // rectangulo (rangeSearch), comparaciones de punto (remove)
+    int profundidadMaxima = -1;         // nivel mas profundo alcanzado (-1: ninguno)
+};
+
+// Rango del atributo en las consultas filtradas (ver KDTreeND::nearest(objetivo, filtro)):
+// solo cuentan los puntos con minimo <= atributo <= maximo
+struct FiltroAtributo {
+    float minimo;
+    float maximo;
+};
+
+template <class T, std::size_t D>
+struct KDNodeND {
+    using Punto = typename GeometriaKD<T, D>::Punto;
+    using Caja = typename GeometriaKD<T, D>::Caja;
+
+    Punto punto;          // coordenadas del nodo
+    std::uint32_t id;     // identificador del punto (indice en los datos de la aplicacion)
+    float atributo;       // valor numerico del punto para las consultas filtradas (0 si no se dio)
+    KDNodeND* izquierdo;  // hijo izquierdo
+    KDNodeND* derecho;    // hijo derecho
+    int nivel;            // nivel en el arbol (0 = raiz, 1, 2, ...)
+    int tamano;           // nodos en el subarbol (incluido este)
+    Caja caja;            // caja envolvente ajustada de los puntos del subarbol
+    int muertos;          // lapidas en el subarbol (borrado perezoso)
+    float atributoMin;    // rango del atributo en el subarbol (lapidas incluidas, como la caja)
+    float atributoMax;
+    bool borrado;         // lapida: el punto ya no pertenece al arbol
+
+    KDNodeND(const Punto& p, std::uint32_t ident, int lvl, float atrib = 0)
+        : punto(p), id(ident), atributo(atrib), izquierdo(nullptr), derecho(nullptr), nivel(lvl),
+          tamano(1), muertos(0), atributoMin(atrib), atributoMax(atrib), borrado(false) {
+        for (std::size_t e = 0; e < D; e++) caja.inferior(e) = caja.superior(e) = p[e];
+    }
+};
+
+
+template <class T, std::size_t D>
+class PersistentKDTreeND;
+template <class T, std::size_t D>
+class NeighborIteratorND;
+
+template <class T, std::size_t D>
+class KDTreeND {
+    // Las versiones persistentes (PersistentKDTree.h) comparten nodos y recorridos
+    friend class PersistentKDTreeND<T, D>;
+    // El iterador de vecinos (NeighborIterator.h) usa las mismas distancias
+    friend class NeighborIteratorND<T, D>;
+
+    static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value ||
+                      std::is_same<T, std::int32_t>::value,
+                  "KDTreeND admite coordenadas float, double o int32");
+    static_assert(D >= 1 && D <= 8, "KDTreeND admite de 1 a 8 dimensiones");
+
+public:
+    using Punto = typename GeometriaKD<T, D>::Punto;
+    using Caja = typename GeometriaKD<T, D>::Caja;
+    using Nodo = KDNodeND<T, D>;
+    // Distancias al cuadrado: en el tipo de la coordenada; int64 para int32
+    // (exactas mientras D * (2 * max |coordenada|)^2 < 2^63)
+    using Distancia = std::conditional_t<std::is_integral<T>::value, std::int64_t, T>;
+    static constexpr std::size_t DIMENSIONES = D;
+
+    // Cada punto lleva un id de 32 bits que las consultas *Id devuelven en vez
+    // de copiar el punto: la aplicacion une sus datos por indice en O(1).
+    // build() asigna a cada punto su posicion en la entrada e insert(p) el
+    // siguiente id libre. El id desempata las coordenadas repetidas al repartir
+    // los puntos (ver precede): el arbol no exige que sean unicos, pero las
+    // copias de un mismo par (punto, id) se encadenan en un solo camino.
+    // SIN_ID: resultado de nearestId en un arbol vacio.
+    static constexpr std::uint32_t SIN_ID = 0xFFFFFFFFu;
+
+    KDTreeND() : root(nullptr) {}
+
+    // Los nodos viven en la arena del arbol: destruir o reasignar el arbol
+    // libera todos sus bloques de una vez. No copiable, si movible.
+    KDTreeND(const KDTreeND&) = delete;
+    KDTreeND& operator=(const KDTreeND&) = delete;
+    KDTreeND(KDTreeND&& otro) noexcept;
+    KDTreeND& operator=(KDTreeND&& otro) noexcept;
+
+    // Construccion en bloque: arbol balanceado por particion en la mediana
+    explicit KDTreeND(std::vector<Punto> puntos) : root(nullptr) { build(std::move(puntos)); }
+
+    // Con balanceo activo (alpha < 1), O(log n) amortizado en cualquier orden de llegada.
+    // Sin id explicito usa el siguiente libre (mayor id asignado + 1) y lo devuelve.
+    std::uint32_t insert(const Punto& punto);
+    void insert(const Punto& punto, std::uint32_t id);
+
+    // Auto-balanceo (arbol chivo expiatorio): si insert deja el nodo nuevo a
+    // profundidad mayor que log_{1/alpha}(n), el ancestro mas cercano cuyo
+    // subarbol supera log_{1/alpha}(tamano) se reconstruye con particion en la
+    // mediana; si remove deja menos de alpha * (maximo historico) puntos se
+    // reconstruye el arbol completo. Cuando los pares (punto, id) repetidos
+    // impiden alcanzar la cota (ninguna mediana los separa) se acumula una
+    // holgura en vez de reconstruir en cada insercion, y un subarbol con un solo
+    // par no se reconstruye. alpha se limita a [0.55, 1]; alpha = 1 desactiva
+    // el balanceo.
+    static constexpr float ALPHA_DEFECTO = 0.75f;
+    void setBalanceAlpha(float alpha);
+    float balanceAlpha() const { return alpha; }
+    EstadisticasBalance balanceStats() const;
+
+    // Punto con su id: entrada de buildWithIds y de las reconstrucciones
+    struct PuntoId {
+        Punto punto;
+        std::uint32_t id;
+        float atributo = 0;  // ver insert(punto, id, atributo)
+    };
+
+    // Reemplaza el contenido del arbol por un arbol balanceado construido con
+    // particion en la mediana. O(n log n), profundidad ceil(log2(n + 1)).
+    // El punto puntos[i] recibe el id i.
+    void build(std::vector<Punto> puntos);
+    // Igual, con los ids elegidos por el llamador (el proximo insert(p) recibe
+    // el mayor + 1). Sirve a quien ya genera los pares sin pasar por Punto.
+    void buildWithIds(std::vector<PuntoId> puntos);
+
+    // Igual que build(), pero los subarboles izquierdo/derecho de cada nivel se
+    // construyen como tareas independientes en un pool con robo de trabajo.
+    // Los rangos con menos de umbralSerial puntos se construyen en serie.
+    static constexpr std::size_t UMBRAL_SERIAL = 1 << 14;
+    void buildParallel(std::vector<Punto> puntos, ThreadPool& pool,
+                       std::size_t umbralSerial = UMBRAL_SERIAL);
+    // hilos = 0 usa todos los nucleos disponibles
+    void buildParallel(std::vector<Punto> puntos, unsigned hilos = 0,
+                       std::size_t umbralSerial = UMBRAL_SERIAL);
+    void buildParallelWithIds(std::vector<PuntoId> puntos, ThreadPool& pool,
+                              std::size_t umbralSerial = UMBRAL_SERIAL);
+
+    Nodo* getRoot() const { return root; }
+
+    // Numero de puntos almacenados (sin contar lapidas)
+    std::size_t size() const { return nodos.size() - tombstones(); }
+
+    // Copia de todos los puntos del arbol (sin orden definido)
+    std::vector<Punto> points() const;
+
+    // Vacia el arbol liberando todos los bloques de la arena
+    void clear();
+
+    // Busqueda de vecino mas cercano: devuelve el punto del arbol mas cercano al objetivo
+    Punto nearest(const Punto& objetivo) const;
+    std::uint32_t nearestId(const Punto& objetivo) const;
+
+    // Busqueda por rango: devuelve todos los puntos dentro de la caja
+    std::vector<Punto> rangeSearch(const Caja& rectangulo) const;
+    std::vector<std::uint32_t> rangeSearchIds(const Caja& rectangulo) const;
+
+    // Cuenta los puntos dentro de la caja sin materializarlos. Si la caja
+    // contiene por completo la celda de un nodo, suma el tamano del subarbol
+    // en O(1) sin visitarlo: O(n^(1-1/D)) en un arbol balanceado.
+    std::size_t rangeCount(const Caja& rectangulo) const;
+
+    // Visitantes: llaman a f(punto) o f(punto, id) por cada punto encontrado,
+    // sin orden definido y sin reservar memoria (la pila del recorrido vive en
+    // TraversalStack). Si f devuelve bool, false detiene la busqueda.
+    //  - forEachInRange: puntos dentro de la caja
+    //  - forEachInRadius: puntos a distancia euclidea <= radio del centro
+    //  - forEachInPolygon: puntos dentro del poligono convexo (ver polygonSearch)
+    template <class F>
+    void forEachInRange(const Caja& rectangulo, F&& f) const;
+    template <class F>
+    void forEachInRadius(const Punto& centro, Distancia radio, F&& f) const;
+    template <class F>
+    void forEachInPolygon(const std::vector<Punto>& vertices, F&& f) const;
+
+    // Busquedas por disco (bola en D dimensiones) y por poligono convexo, sin
+    // pasar por el rectangulo envolvente. Con la poda por cajas cada subarbol se
+    // clasifica por su caja: dentro de la region (se vuelca sin comprobar punto
+    // a punto), fuera (se poda) o cruzando su borde (se desciende).
+    //  - radiusSearch: puntos a distancia euclidea <= radio del centro
+    //  - polygonSearch (solo 2D): puntos dentro o sobre el borde del poligono
+    //    convexo de esos vertices, en cualquier orientacion (el borde, sujeto al
+    //    redondeo en double). Con menos de 3 vertices no hay resultados; si el
+    //    poligono no es convexo el resultado no esta definido.
+    std::vector<Punto> radiusSearch(const Punto& centro, Distancia radio) const;
+    std::vector<std::uint32_t> radiusSearchIds(const Punto& centro, Distancia radio) const;
+    std::vector<Punto> polygonSearch(const std::vector<Punto>& vertices) const;
+    std::vector<std::uint32_t> polygonSearchIds(const std::vector<Punto>& vertices) const;
+
+    // Poda con cajas envolventes: cada nodo mantiene la caja ajustada de su
+    // subarbol (se actualiza en build, insert y remove). Activada, nearest y
+    // kNearest descartan una rama por la distancia del objetivo a su caja en vez
+    // de al plano divisor, y rangeSearch / rangeCount descartan las cajas
+    // disjuntas y vuelcan sin comprobar punto a punto las contenidas en el
+    // rectangulo. Activada por defecto; desactivarla recupera la poda clasica
+    // por plano divisor (comparacion de rendimiento, visualizacion).
+    void setBoundingBoxPruning(bool activar) { podaConCajas = activar; }
+    bool boundingBoxPruning() const { return podaConCajas; }
+
+    // Eliminar un punto del arbol. Con id, solo la copia del punto con ese id
+    // (coordenadas repetidas); sin el, la primera copia encontrada.
+    void remove(const Punto& punto, std::uint32_t id = SIN_ID);
+
+    // Borrado perezoso: remove() solo marca el nodo como lapida en O(log n) y las
+    // consultas lo ignoran (sigue guiando el descenso). Cuando las lapidas de un
+    // subarbol superan umbral * tamano, el mas alto de esos subarboles se
+    // reconstruye solo con los puntos vivos. Desactivarlo compacta el arbol.
+    // Umbral por defecto 0.25, limitado a [0.01, 1].
+    static constexpr float UMBRAL_COMPACTACION = 0.25f;
+    void setLazyDeletion(bool activar);
+    bool lazyDeletion() const { return borradoPerezoso; }
+    void setCompactionThreshold(float fraccion);
+    float compactionThreshold() const { return umbralCompactacion; }
+    // Lapidas pendientes y compactacion explicita de todo el arbol (p. ej. en
+    // un momento sin consultas)
+    std::size_t tombstones() const { return root ? root->muertos : 0; }
+    void compact();
+
+    // Buscar los k vecinos mas cercanos (ordenados por distancia)
+    std::vector<Punto> kNearest(const Punto& objetivo, int k) const;
+    std::vector<std::uint32_t> kNearestIds(const Punto& objetivo, int k) const;
+
+    // Las mismas operaciones acumulando en *stats los contadores del recorrido
+    // (nodos visitados, ramas podadas, evaluaciones geometricas, profundidad
+    // maxima). Los contadores son una variante aparte de cada recorrido (plantilla
+    // con ConStats): las versiones sin stats no pagan nada. En remove no cuentan
+    // las reconstrucciones que dispare (ver balanceStats).
+    Punto nearest(const Punto& objetivo, QueryStats* stats) const;
+    std::vector<Punto> kNearest(const Punto& objetivo, int k, QueryStats* stats) const;
+    std::vector<Punto> rangeSearch(const Caja& rectangulo, QueryStats* stats) const;
+    void remove(const Punto& punto, std::uint32_t id, QueryStats* stats);
+
+    // Atributo numerico por punto (p. ej. la edad de un paciente): insert y
+    // build lo reciben (0 si no se da) y cada nodo guarda el minimo y el maximo
+    // del atributo en su subarbol. Las consultas filtradas solo devuelven
+    // puntos con filtro.minimo <= atributo <= filtro.maximo y descartan sin
+    // entrar los subarboles cuyo rango de atributo no corta el filtro;
+    // rangeSearch recorre un subarbol dentro del rectangulo comprobando solo el
+    // atributo. Sin puntos que lo cumplan, nearest devuelve Punto{} y nearestId
+    // SIN_ID; kNearest devuelve como mucho los que lo cumplen.
+    void insert(const Punto& punto, std::uint32_t id, float atributo);
+    // puntos[i] recibe el id i y el atributo atributos[i] (0 si falta)
+    void build(std::vector<Punto> puntos, const std::vector<float>& atributos);
+    Punto nearest(const Punto& objetivo, const FiltroAtributo& filtro) const;
+    std::uint32_t nearestId(const Punto& objetivo, const FiltroAtributo& filtro) const;
+    std::vector<Punto> kNearest(const Punto& objetivo, int k, const FiltroAtributo& filtro) const;
+    std::vector<std::uint32_t> kNearestIds(const Punto& objetivo, int k,
+                                           const FiltroAtributo& filtro) const;
+    std::vector<Punto> rangeSearch(const Caja& rectangulo, const FiltroAtributo& filtro) const;
+    std::vector<std::uint32_t> rangeSearchIds(const Caja& rectangulo, const FiltroAtributo& filtro) const;
+
+    // Vecinos aproximados: una rama se descarta si su cota por (1 + epsilon)^2
+    // ya no mejora al candidato, asi cada vecino devuelto esta como mucho a
+    // (1 + epsilon) veces la distancia del vecino exacto de su posicion. Con
+    // maxNodos > 0 la busqueda se corta tras evaluar ese numero de nodos (sin
+    // garantia de error; kNearestApprox puede devolver menos de k puntos).
+    // informe (opcional) indica si el resultado es exacto y cuantos nodos se
+    // evaluaron. epsilon = 0 y maxNodos = 0 equivalen a nearest / kNearest.
+    Punto nearestApprox(const Punto& objetivo, float epsilon, std::size_t maxNodos = 0,
+                        InformeAproximado* informe = nullptr) const;
+    std::vector<Punto> kNearestApprox(const Punto& objetivo, int k, float epsilon,
+                                      std::size_t maxNodos = 0,
+                                      InformeAproximado* informe = nullptr) const;
+
+    // Consultas por lotes repartidas en un pool de hilos. Internamente las
+    // consultas se reordenan por curva de Hilbert (sobre los dos primeros
+    // ejes) para que consultas vecinas (que recorren los mismos caminos del
+    // arbol) se resuelvan juntas en el mismo hilo; los resultados se escriben
+    // en el orden original.
+    //  - nearestBatch: salida[i] = nearest(consultas[i])
+    //  - kNearestBatch: fila i = salida[i*k, i*k + k), ordenada por distancia.
+    //    Devuelve cuantos vecinos validos tiene cada fila: min(k, size()).
+    void nearestBatch(const Punto* consultas, std::size_t n, Punto* salida,
+                      ThreadPool& pool) const;
+    void nearestBatch(const Punto* consultas, std::size_t n, Punto* salida,
+                      unsigned hilos = 0) const;
+    std::size_t kNearestBatch(const Punto* consultas, std::size_t n, int k, Punto* salida,
+                              ThreadPool& pool) const;
+    std::size_t kNearestBatch(const Punto* consultas, std::size_t n, int k, Punto* salida,
+                              unsigned hilos = 0) const;
+
+    // Histogramas de latencia (LatencyHistogram.h), desactivados por defecto.
+    // Activados, nearest / nearestId, kNearest / kNearestIds, rangeSearch /
+    // rangeSearchIds, insert y remove (todas sus sobrecargas: con QueryStats,
+    // con filtro y tambien sobre un arbol vacio) miden su duracion y la
+    // registran en el histograma de su operacion y de su hilo, sin cerrojos;
+    // nearestBatch y kNearestBatch registran cada consulta en el hilo del pool
+    // que la resolvio. Desactivados solo cuestan comprobar un puntero. Cambiar
+    // el ajuste no debe coincidir con otras operaciones; desactivarlo descarta
+    // lo registrado.
+    void setLatencyHistograms(bool activar);
+    bool latencyHistograms() const { return latencias != nullptr; }
+    // Registrador del arbol: snapshot(operacion) combina los hilos, toText() /
+    // toJson() exportan p50 / p90 / p99 / p999. nullptr si estan desactivados.
+    LatencyRecorder* latencyRecorder() const { return latencias.get(); }
+
+private:
+    Nodo* root;
+    NodeArena<Nodo> nodos;
+    bool podaConCajas = true;
+    float alpha = ALPHA_DEFECTO;
+    std::size_t reconstrucciones = 0;
+    std::size_t nodosReconstruidos = 0;
+    std::size_t tamanoMaximo = 0;  // mayor size() desde la ultima reconstruccion total
+    int holguraAltura = 0;         // niveles extra tolerados por pares (punto, id) repetidos
+    bool borradoPerezoso = false;
+    float umbralCompactacion = UMBRAL_COMPACTACION;
+    std::uint32_t siguienteId = 0;  // id que recibe el proximo insert(p)
+    std::unique_ptr<LatencyRecorder> latencias;  // nullptr: sin histogramas de latencia
+
+    static constexpr Distancia INFINITO = std::numeric_limits<Distancia>::has_infinity
+                                              ? std::numeric_limits<Distancia>::infinity()
+                                              : std::numeric_limits<Distancia>::max();
+
+    // Rama pendiente de un recorrido iterativo: nodo, su profundidad (el eje es
+    // profundidad % D) y la distancia al cuadrado al plano que la separa del objetivo
+    struct Pendiente {
+        Nodo* nodo;
+        int profundidad;
+        Distancia distanciaPlano;
+    };
+
+    // Estado de una consulta aproximada: cotas escaladas por factor = (1 + epsilon)^2
+    // y nodos que aun se pueden evaluar
+    struct EstadoAprox {
+        double factor;
+        std::size_t restantes;
+        InformeAproximado informe;
+    };
+    static EstadoAprox estadoAprox(float epsilon, std::size_t maxNodos);
+
+    // Candidato de k-NN: el heap compara solo la distancia
+    using Candidato = std::pair<Distancia, const Nodo*>;
+    static bool menorDistancia(const Candidato& a, const Candidato& b) { return a.first < b.first; }
+
+    // ============ EJES EN TIEMPO DE COMPILACION
+    template <std::size_t E>
+    using Eje = std::integral_constant<std::size_t, E>;
+
+    // f(Eje<0>{}), ..., f(Eje<D - 1>{})
+    template <class F, std::size_t... I>
+    static void paraCadaEje(F& f, std::index_sequence<I...>) { (f(Eje<I>{}), ...); }
+    template <class F>
+    static void paraCadaEje(F&& f) { paraCadaEje(f, std::make_index_sequence<D>{}); }
+
+    // f(Eje<eje>{}) para un eje conocido solo en tiempo de ejecucion
+    template <class F, std::size_t... I>
+    static void conEje(std::size_t eje, F& f, std::index_sequence<I...>) {
+        (void)((eje == I && (f(Eje<I>{}), true)) || ...);
+    }
+    template <class F>
+    static void conEje(std::size_t eje, F&& f) { conEje(eje, f, std::make_index_sequence<D>{}); }
+
+    // Descenso nivel a nivel: paso(Eje<e>{}) procesa un nodo del eje e y
+    // devuelve false para detenerse; el siguiente nivel usa el eje (e + 1) % D.
+    // El bucle se desenrolla D niveles por vuelta; solo la primera vuelta, que
+    // empieza en ejeInicial, comprueba que ejes saltar.
+    template <class Paso, std::size_t... I>
+    static void recorrerNiveles(std::size_t ejeInicial, Paso& paso, std::index_sequence<I...>) {
+        if (!((I < ejeInicial || paso(Eje<I>{})) && ...)) return;
+        while ((paso(Eje<I>{}) && ...)) {}
+    }
+    template <class Paso>
+    static void recorrerNiveles(std::size_t ejeInicial, Paso&& paso) {
+        recorrerNiveles(ejeInicial, paso, std::make_index_sequence<D>{});
+    }
+
+    // ============ GEOMETRIA (desenrollada por eje)
+    static Distancia diferencia(T a, T b) { return Distancia(a) - Distancia(b); }
+
+    template <std::size_t... I>
+    static Distancia distanciaCuadrado(const Punto& a, const Punto& b, std::index_sequence<I...>) {
+        return (... + (diferencia(a[I], b[I]) * diferencia(a[I], b[I])));
+    }
+    static Distancia distanciaCuadrado(const Punto& a, const Punto& b) {
+        return distanciaCuadrado(a, b, std::make_index_sequence<D>{});
+    }
+
+    // Distancia al cuadrado desde p al punto mas cercano de la caja (0 si esta dentro)
+    template <std::size_t I>
+    static Distancia distanciaEje(const Punto& p, const Caja& caja) {
+        Distancia d = std::max(std::max(diferencia(caja.inferior(I), p[I]),
+                                        diferencia(p[I], caja.superior(I))), Distancia(0));
+        return d * d;
+    }
+    template <std::size_t... I>
+    static Distancia distanciaCaja(const Punto& p, const Caja& caja, std::index_sequence<I...>) {
+        return (... + distanciaEje<I>(p, caja));
+    }
+    static Distancia distanciaCaja(const Punto& p, const Caja& caja) {
+        return distanciaCaja(p, caja, std::make_index_sequence<D>{});
+    }
+
+    // Distancia al cuadrado desde p a la esquina mas lejana de la caja
+    template <std::size_t I>
+    static Distancia distanciaMaxEje(const Punto& p, const Caja& caja) {
+        Distancia d = std::max(diferencia(p[I], caja.inferior(I)), diferencia(caja.superior(I), p[I]));
+        return d * d;
+    }
+    template <std::size_t... I>
+    static Distancia distanciaMaxCaja(const Punto& p, const Caja& caja, std::index_sequence<I...>) {
+        return (... + distanciaMaxEje<I>(p, caja));
+    }
+    static Distancia distanciaMaxCaja(const Punto& p, const Caja& caja) {
+        return distanciaMaxCaja(p, caja, std::make_index_sequence<D>{});
+    }
+
+    template <std::size_t... I>
+    static bool mismoPunto(const Punto& a, const Punto& b, std::index_sequence<I...>) {
+        return ((a[I] == b[I]) && ...);
+    }
+    static bool mismoPunto(const Punto& a, const Punto& b) {
+        return mismoPunto(a, b, std::make_index_sequence<D>{});
+    }
+
+    // Orden de los niveles que discriminan por eje: la coordenada y, en empate,
+    // el id. Asi los puntos repetidos se reparten a los dos lados de la mediana
+    // en vez de formar una cadena; a la izquierda va lo que precede al nodo.
+    static bool precede(const Punto& a, std::uint32_t idA, const Punto& b, std::uint32_t idB,
+                        std::size_t eje) {
+        return a[eje] < b[eje] || (a[eje] == b[eje] && idA < idB);
+    }
+
+    template <std::size_t... I>
+    static bool dentroDeCaja(const Punto& p, const Caja& caja, std::index_sequence<I...>) {
+        return ((p[I] >= caja.inferior(I) && p[I] <= caja.superior(I)) && ...);
+    }
+    static bool dentroDeCaja(const Punto& p, const Caja& caja) {
+        return dentroDeCaja(p, caja, std::make_index_sequence<D>{});
+    }
+
+    template <std::size_t... I>
+    static bool contieneCaja(const Caja& exterior, const Caja& interior, std::index_sequence<I...>) {
+        return ((interior.inferior(I) >= exterior.inferior(I) &&
+                 interior.superior(I) <= exterior.superior(I)) && ...);
+    }
+    static bool contieneCaja(const Caja& exterior, const Caja& interior) {
+        return contieneCaja(exterior, interior, std::make_index_sequence<D>{});
+    }
+
+    template <std::size_t... I>
+    static bool intersectaCaja(const Caja& a, const Caja& b, std::index_sequence<I...>) {
+        return ((a.inferior(I) <= b.superior(I) && b.inferior(I) <= a.superior(I)) && ...);
+    }
+    static bool intersectaCaja(const Caja& a, const Caja& b) {
+        return intersectaCaja(a, b, std::make_index_sequence<D>{});
+    }
+
+    static Caja cajaDePunto(const Punto& p) {
+        Caja caja;
+        paraCadaEje([&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            caja.inferior(eje) = caja.superior(eje) = p[eje];
+        });
+        return caja;
+    }
+
+    static void extenderCaja(Caja& caja, const Punto& p) {
+        paraCadaEje([&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            caja.inferior(eje) = std::min(caja.inferior(eje), p[eje]);
+            caja.superior(eje) = std::max(caja.superior(eje), p[eje]);
+        });
+    }
+
+    static void unirCaja(Caja& caja, const Caja& otra) {
+        paraCadaEje([&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            caja.inferior(eje) = std::min(caja.inferior(eje), otra.inferior(eje));
+            caja.superior(eje) = std::max(caja.superior(eje), otra.superior(eje));
+        });
+    }
+
+    // ============ ATRIBUTO
+    // El atributo del nodo cumple el filtro / el rango del subarbol lo corta
+    static bool cumpleFiltro(const Nodo* nodo, const FiltroAtributo& filtro) {
+        return nodo->atributo >= filtro.minimo && nodo->atributo <= filtro.maximo;
+    }
+    static bool solapaFiltro(const Nodo* nodo, const FiltroAtributo& filtro) {
+        return nodo->atributoMin <= filtro.maximo && nodo->atributoMax >= filtro.minimo;
+    }
+    static void extenderAtributo(Nodo* nodo, float atributo) {
+        nodo->atributoMin = std::min(nodo->atributoMin, atributo);
+        nodo->atributoMax = std::max(nodo->atributoMax, atributo);
+    }
+
+    // Recalcula los datos agregados del subarbol (tamano, muertos, caja y rango
+    // del atributo) a partir de sus hijos
+    static void actualizarResumen(Nodo* nodo);
+
+    // ============ CONSTRUCCION
+    static std::vector<PuntoId> numerar(std::vector<Punto> puntos);
+    static std::uint32_t siguienteIdTras(const std::vector<PuntoId>& puntos);
+    static std::size_t particionMediana(std::vector<PuntoId>& puntos, std::size_t inicio,
+                                        std::size_t fin, std::size_t eje);
+    template <class Ranura>
+    static Nodo* buildSerial(std::vector<PuntoId>& puntos, std::size_t inicio, std::size_t fin,
+                             int nivel, const Ranura& ranura);
+    static Nodo* buildSerial(std::vector<PuntoId>& puntos, std::size_t inicio, std::size_t fin,
+                             int nivel, Nodo* ranuras) {
+        return buildSerial(puntos, inicio, fin, nivel, [ranuras](std::size_t i) { return ranuras + i; });
+    }
+
+    // Construccion paralela sobre puntos[inicio, fin); el nodo del pivote en la
+    // posicion i se construye en ranuras[i]
+    void buildParallelRec(std::vector<PuntoId>& puntos, std::size_t inicio, std::size_t fin,
+                          int nivel, Nodo* ranuras, Nodo** destino, ThreadPool& pool,
+                          TaskGroup& grupo, std::size_t umbralSerial);
+
+    // Los recorridos y buildSerial son iterativos (pila explicita,
+    // TraversalStack.h): la profundidad de un arbol degenerado no agota la pila
+    // de llamadas. Solo buildParallelRec recursa, en los niveles por encima del
+    // umbral serial (O(log n) con claves (coordenada, id) distintas).
+    // Las busquedas por rango y por radio entregan cada nodo encontrado a
+    // emitir(nodo), que devuelve false para detenerlas; ellas devuelven false
+    // si se detuvieron.
+    // Aprox: poda escalada y presupuesto de nodos segun *aprox
+    // ConStats: acumula los contadores del recorrido en *stats
+    // ConFiltro: solo puntos cuyo atributo cumple *filtro; poda por rango de atributo
+    template <bool ConCajas, bool Aprox = false, bool ConStats = false, bool ConFiltro = false>
+    static Nodo* vecinoMasCercano(Nodo* raiz, const Punto& objetivo, EstadoAprox* aprox = nullptr,
+                                  QueryStats* stats = nullptr, const FiltroAtributo* filtro = nullptr);
+    template <bool ConStats = false, bool ConFiltro = false, class Emitir>
+    static bool volcarSubarbol(Nodo* raiz, Emitir& emitir, int profundidad = 0,
+                               QueryStats* stats = nullptr, const FiltroAtributo* filtro = nullptr);
+    template <bool ConCajas, bool ConStats = false, bool ConFiltro = false, class Emitir>
+    static bool busquedaRango(Nodo* raiz, const Caja& rectangulo, Emitir& emitir,
+                              QueryStats* stats = nullptr, const FiltroAtributo* filtro = nullptr);
+    static std::size_t contarRango(Nodo* raiz, const Caja& rectangulo, bool conCajas);
+    template <bool ConCajas, class Emitir>
+    static bool busquedaRadio(Nodo* raiz, const Punto& centro, Distancia radioCuadrado,
+                              Emitir& emitir);
+    // Region convexa como interseccion de semiespacios a . x <= b (en double) y
+    // su caja envolvente (poda por plano cuando no hay cajas)
+    struct RegionConvexa {
+        struct Semiespacio {
+            double a[D];
+            double b;
+        };
+        std::vector<Semiespacio> semiespacios;
+        Caja envolvente;
+    };
+    enum class Relacion { Fuera, Dentro, Cruza };
+    // Vacia (sin semiespacios) con menos de 3 vertices
+    static RegionConvexa regionPoligono(const std::vector<Punto>& vertices);
+    // activos: bit i = el semiespacio i aun corta la celda (los de indice >= 64
+    // se comprueban siempre)
+    static bool dentroDeRegion(const Punto& p, const RegionConvexa& region, std::uint64_t activos);
+    static Relacion relacionCaja(const Caja& caja, const RegionConvexa& region, std::uint64_t& activos);
+    template <bool ConCajas, class Emitir>
+    static bool busquedaConvexa(Nodo* raiz, const RegionConvexa& region, Emitir& emitir);
+    // Llama al visitante de forEachIn* con el punto (y el id si lo acepta)
+    template <class F>
+    static bool visitar(F& f, const Nodo* nodo);
+    template <bool ConCajas, bool Aprox = false, bool ConStats = false, bool ConFiltro = false>
+    static void busquedaKVecinos(Nodo* raiz, const Punto& objetivo, int k,
+                                 std::vector<Candidato>& pq, EstadoAprox* aprox = nullptr,
+                                 QueryStats* stats = nullptr, const FiltroAtributo* filtro = nullptr);
+    // Apunta en *stats la visita a un nodo a esa profundidad
+    static void contarVisita(QueryStats* stats, int profundidad) {
+        stats->nodosVisitados++;
+        stats->profundidadMaxima = std::max(stats->profundidadMaxima, profundidad);
+    }
+
+    // Reconstruye balanceado el subarbol *enlace reutilizando sus nodos
+    int reconstruir(Nodo** enlace);
+    // Todos los nodos del subarbol tienen el mismo punto e id: ninguna
+    // reconstruccion lo acorta (insert no lo intenta)
+    static bool claveUnica(const Nodo* raiz);
+    int alturaPermitida(std::size_t n) const;
+    // remove() con o sin contadores, y en modo perezoso
+    template <bool ConStats>
+    void eliminar(const Punto& punto, std::uint32_t id, QueryStats* stats);
+    template <bool ConStats>
+    void marcarBorrado(const Punto& punto, std::uint32_t id, QueryStats* stats);
+
+    // Funcion auxiliar para eliminar: enlace al nodo minimo en el eje d
+    template <bool ConStats = false>
+    static Nodo** findMin(Nodo** enlace, std::size_t d, int profundidad, QueryStats* stats = nullptr);
+    // Funcion auxiliar para remove(punto) sin id: el id de un nodo con ese punto
+    // (vivo, si soloVivos), o SIN_ID si no hay ninguno
+    template <bool ConStats = false>
+    static std::uint32_t buscarId(Nodo* raiz, const Punto& punto, bool soloVivos,
+                                  QueryStats* stats = nullptr);
+
+    // nearest / nearestId con filtro de atributo
+    Nodo* vecinoFiltrado(const Punto& objetivo, const FiltroAtributo& filtro) const;
+
+    // Funcion auxiliar para k-NN: deja en pq los candidatos ordenados por distancia
+    template <bool ConStats = false, bool ConFiltro = false>
+    void kNearestSearch(const Punto& objetivo, int k, std::vector<Candidato>& pq,
+                        QueryStats* stats = nullptr, const FiltroAtributo* filtro = nullptr) const;
+    // k-NN escribiendo en salida[0, k) y reutilizando el heap del llamador
+    std::size_t kNearestInto(const Punto& objetivo, int k, std::vector<Candidato>& pq,
+                             Punto* salida) const;
+
+    static constexpr std::size_t BLOQUE_LOTE = 256;
+    static std::uint32_t indiceHilbert(std::uint32_t x, std::uint32_t y);
+    static std::vector<std::uint32_t> ordenHilbert(const Punto* consultas, std::size_t n);
+};
+
+
+// ============ DATOS AGREGADOS
+template <class T, std::size_t D>
+void KDTreeND<T, D>::actualizarResumen(Nodo* nodo) {
+    nodo->tamano = 1;
+    nodo->muertos = nodo->borrado ? 1 : 0;
+    nodo->caja = cajaDePunto(nodo->punto);
+    nodo->atributoMin = nodo->atributoMax = nodo->atributo;
+    for (const Nodo* hijo : {nodo->izquierdo, nodo->derecho}) {
+        if (hijo == nullptr) continue;
+        nodo->tamano += hijo->tamano;
+        nodo->muertos += hijo->muertos;
+        unirCaja(nodo->caja, hijo->caja);
+        nodo->atributoMin = std::min(nodo->atributoMin, hijo->atributoMin);
+        nodo->atributoMax = std::max(nodo->atributoMax, hijo->atributoMax);
+    }
+}
+
+// ============ INSERCION
+// Complejidad: O(log n) amortizado con balanceo (alpha < 1), O(n) peor caso sin el
+// Iterativa: 'enlace' apunta al campo (root o hijo) donde ira el nuevo nodo
+template <class T, std::size_t D>
+std::uint32_t KDTreeND<T, D>::insert(const Punto& punto) {
+    std::uint32_t id = siguienteId;
+    insert(punto, id);
+    return id;
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::insert(const Punto& punto, std::uint32_t id) {
+    insert(punto, id, 0.0f);
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::insert(const Punto& punto, std::uint32_t id, float atributo) {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::Insert);
+    Nodo** enlace = &root;
+    TraversalStack<Nodo**> camino;
+    int nivel = 0;
+
+    if (root != nullptr) {
+        recorrerNiveles(0, [&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            Nodo* nodo = *enlace;
+            camino.push(enlace);
+            nodo->tamano++;  // el nuevo punto quedara en este subarbol
+            extenderCaja(nodo->caja, punto);
+            extenderAtributo(nodo, atributo);
+            enlace = precede(punto, id, nodo->punto, nodo->id, eje) ? &nodo->izquierdo : &nodo->derecho;
+            nivel++;
+            return *enlace != nullptr;
+        });
+    }
+
+    *enlace = nodos.create(punto, id, nivel, atributo);
+    tamanoMaximo = std::max(tamanoMaximo, nodos.size());
+    siguienteId = std::max(siguienteId, id + 1);
+
+    // Chivo expiatorio: si el nodo nuevo quedo mas profundo de lo permitido, se
+    // reconstruye el ancestro mas cercano cuyo subarbol es demasiado alto para
+    // su tamano (la raiz lo cumple siempre, asi que existe)
+    if (nivel > alturaPermitida(nodos.size())) {
+        while (!camino.empty()) {
+            Nodo** actual = camino.pop();
+            int tamano = (*actual)->tamano;
+            if (nivel - (*actual)->nivel > alturaPermitida(tamano)) {
+                // Con pares (punto, id) repetidos ni la mediana alcanza la cota: el
+                // exceso pasa a la holgura para no reconstruir en cada insercion.
+                // Si el subarbol entero es un mismo par ya es la cadena que
+                // saldria de reconstruirlo (en O(m^2)), asi que se deja como esta.
+                int altura = claveUnica(*actual) ? nivel - (*actual)->nivel + 1 : reconstruir(actual);
+                int exceso = altura - 1 - alturaPermitida(tamano);
+                if (exceso > 0) holguraAltura += exceso;
+                break;
+            }
+        }
+        // La reconstruccion descarta las lapidas: los ancestros cambian de tamano
+        while (!camino.empty()) actualizarResumen(*camino.pop());
+    }
+}
+
+// ============ CONSTRUCCION EN BLOQUE
+// Complejidad: O(n log n) (nth_element es O(n) por nivel y hay O(log n) niveles)
+
+// Entrada de build(): puntos[i] recibe el id i
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::numerar(std::vector<Punto> puntos) -> std::vector<PuntoId> {
+    std::vector<PuntoId> numerados(puntos.size());
+    for (std::size_t i = 0; i < puntos.size(); i++) numerados[i] = {puntos[i], (std::uint32_t)i};
+    return numerados;
+}
+
+// Mayor id + 1 (0 si no hay puntos)
+template <class T, std::size_t D>
+std::uint32_t KDTreeND<T, D>::siguienteIdTras(const std::vector<PuntoId>& puntos) {
+    std::uint32_t siguiente = 0;
+    for (const PuntoId& p : puntos) siguiente = std::max(siguiente, p.id + 1);
+    return siguiente;
+}
+
+// Particiona puntos[inicio, fin) alrededor de la mediana del eje y devuelve la
+// posicion del pivote: [inicio, pivote) precede al pivote y (pivote, fin) no.
+template <class T, std::size_t D>
+std::size_t KDTreeND<T, D>::particionMediana(std::vector<PuntoId>& puntos, std::size_t inicio,
+                                             std::size_t fin, std::size_t ejeNivel) {
+    std::size_t medio = inicio + (fin - inicio) / 2;
+    std::size_t pivote = medio;
+
+    conEje(ejeNivel, [&](auto E) {
+        constexpr std::size_t eje = decltype(E)::value;
+        auto menorEnEje = [](const PuntoId& a, const PuntoId& b) {
+            return precede(a.punto, a.id, b.punto, b.id, eje);
+        };
+        std::nth_element(puntos.begin() + inicio, puntos.begin() + medio, puntos.begin() + fin,
+                         menorEnEje);
+
+        // insert manda al subarbol derecho lo que no precede al nodo; para que
+        // insert, remove y findMin sigan siendo validos, el pivote debe ser el
+        // primero con la clave de la mediana (solo hay varios si se repiten
+        // punto e id) y la mitad izquierda debe precederlo estrictamente.
+        PuntoId mediana = puntos[medio];
+        auto primerNoMenor = std::partition(puntos.begin() + inicio, puntos.begin() + medio,
+                                            [&](const PuntoId& p) { return menorEnEje(p, mediana); });
+        pivote = primerNoMenor - puntos.begin();
+    });
+    std::swap(puntos[pivote], puntos[medio]);
+    return pivote;
+}
+
+// Construccion sobre puntos[inicio, fin): el nodo del pivote en la posicion i
+// se construye en la memoria ranura(i). El build usa un bloque contiguo de la
+// arena; reconstruir() reutiliza los nodos del subarbol viejo.
+// Iterativa: cada rango se apila dos veces, una para crear su nodo y otra (tras
+// sus dos hijos) para calcular los datos agregados, asi la pila solo crece con
+// la altura y sin la pila de llamadas.
+template <class T, std::size_t D>
+template <class Ranura>
+auto KDTreeND<T, D>::buildSerial(std::vector<PuntoId>& puntos, std::size_t inicio, std::size_t fin,
+                                 int nivel, const Ranura& ranura) -> Nodo* {
+    struct Pendiente {
+        std::size_t inicio, fin;
+        int nivel;
+        Nodo** destino;
+        Nodo* cerrar;  // no nulo: solo falta actualizarResumen(cerrar)
+    };
+
+    Nodo* raiz = nullptr;
+    TraversalStack<Pendiente> pila;
+    pila.push({inicio, fin, nivel, &raiz, nullptr});
+    while (!pila.empty()) {
+        Pendiente actual = pila.pop();
+        if (actual.cerrar != nullptr) {
+            actualizarResumen(actual.cerrar);
+            continue;
+        }
+        if (actual.inicio >= actual.fin) continue;
+
+        std::size_t pivote = particionMediana(puntos, actual.inicio, actual.fin, actual.nivel % D);
+        const PuntoId& mediana = puntos[pivote];
+        Nodo* nodo = new (ranura(pivote)) Nodo(mediana.punto, mediana.id, actual.nivel, mediana.atributo);
+        *actual.destino = nodo;
+        pila.push({0, 0, 0, nullptr, nodo});
+        pila.push({pivote + 1, actual.fin, actual.nivel + 1, &nodo->derecho, nullptr});
+        pila.push({actual.inicio, pivote, actual.nivel + 1, &nodo->izquierdo, nullptr});
+    }
+    return raiz;
+}
+
+// Cada llamada escribe su subarbol en *destino (campo hijo del padre, ya creado),
+// asi las tareas no necesitan sincronizarse entre si: solo el grupo final.
+// Cada rango [inicio, fin) usa sus propias ranuras, por lo que la arena no se toca.
+template <class T, std::size_t D>
+void KDTreeND<T, D>::buildParallelRec(std::vector<PuntoId>& puntos, std::size_t inicio,
+                                      std::size_t fin, int nivel, Nodo* ranuras, Nodo** destino,
+                                      ThreadPool& pool, TaskGroup& grupo,
+                                      std::size_t umbralSerial) {
+    if (fin - inicio <= umbralSerial) {
+        *destino = buildSerial(puntos, inicio, fin, nivel, ranuras);
+        return;
+    }
+
+    // Los hijos se terminan en otras tareas: la caja y el rango del atributo se
+    // calculan aqui sobre el rango completo (una pasada lineal, solo en los
+    // niveles por encima del umbral)
+    Caja caja = cajaDePunto(puntos[inicio].punto);
+    float atributoMin = puntos[inicio].atributo, atributoMax = puntos[inicio].atributo;
+    for (std::size_t i = inicio + 1; i < fin; i++) {
+        extenderCaja(caja, puntos[i].punto);
+        atributoMin = std::min(atributoMin, puntos[i].atributo);
+        atributoMax = std::max(atributoMax, puntos[i].atributo);
+    }
+
+    std::size_t pivote = particionMediana(puntos, inicio, fin, nivel % D);
+
+    const PuntoId& mediana = puntos[pivote];
+    Nodo* nodo = new (ranuras + pivote) Nodo(mediana.punto, mediana.id, nivel, mediana.atributo);
+    nodo->tamano = (int)(fin - inicio);
+    nodo->caja = caja;
+    nodo->atributoMin = atributoMin;
+    nodo->atributoMax = atributoMax;
+    *destino = nodo;
+
+    // El subarbol izquierdo se ofrece al pool; el derecho continua en este hilo
+    pool.submit(grupo, [this, &puntos, inicio, pivote, nivel, ranuras, nodo, &pool, &grupo, umbralSerial] {
+        buildParallelRec(puntos, inicio, pivote, nivel + 1, ranuras, &nodo->izquierdo,
+                         pool, grupo, umbralSerial);
+    });
+    buildParallelRec(puntos, pivote + 1, fin, nivel + 1, ranuras, &nodo->derecho,
+                     pool, grupo, umbralSerial);
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::build(std::vector<Punto> puntos) {
+    buildWithIds(numerar(std::move(puntos)));
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::build(std::vector<Punto> puntos, const std::vector<float>& atributos) {
+    std::vector<PuntoId> numerados = numerar(std::move(puntos));
+    for (std::size_t i = 0; i < numerados.size() && i < atributos.size(); i++) {
+        numerados[i].atributo = atributos[i];
+    }
+    buildWithIds(std::move(numerados));
+}
+
+// Los n nodos se construyen en un unico bloque contiguo de la arena
+template <class T, std::size_t D>
+void KDTreeND<T, D>::buildWithIds(std::vector<PuntoId> puntos) {
+    clear();
+    Nodo* ranuras = nodos.allocateContiguous(puntos.size());
+    root = buildSerial(puntos, 0, puntos.size(), 0, ranuras);
+    tamanoMaximo = nodos.size();
+    holguraAltura = 0;
+    siguienteId = siguienteIdTras(puntos);
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::buildParallel(std::vector<Punto> puntos, ThreadPool& pool,
+                                   std::size_t umbralSerial) {
+    buildParallelWithIds(numerar(std::move(puntos)), pool, umbralSerial);
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::buildParallelWithIds(std::vector<PuntoId> puntos, ThreadPool& pool,
+                                          std::size_t umbralSerial) {
+    clear();
+    Nodo* ranuras = nodos.allocateContiguous(puntos.size());
+
+    TaskGroup grupo;
+    buildParallelRec(puntos, 0, puntos.size(), 0, ranuras, &root, pool, grupo,
+                     std::max<std::size_t>(umbralSerial, 1));
+    pool.wait(grupo);
+    tamanoMaximo = nodos.size();
+    holguraAltura = 0;
+    siguienteId = siguienteIdTras(puntos);
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::buildParallel(std::vector<Punto> puntos, unsigned hilos,
+                                   std::size_t umbralSerial) {
+    ThreadPool pool(hilos);
+    buildParallel(std::move(puntos), pool, umbralSerial);
+}
+
+// ============ AUTO-BALANCEO
+template <class T, std::size_t D>
+void KDTreeND<T, D>::setBalanceAlpha(float nuevo) {
+    alpha = std::min(std::max(nuevo, 0.55f), 1.0f);
+    tamanoMaximo = nodos.size();
+    holguraAltura = 0;
+}
+
+// Profundidad maxima (bajo la raiz) de un subarbol alpha-balanceado de n nodos:
+// log_{1/alpha}(n), mas la holgura acumulada por pares (punto, id) repetidos
+template <class T, std::size_t D>
+int KDTreeND<T, D>::alturaPermitida(std::size_t n) const {
+    if (alpha >= 1.0f) return std::numeric_limits<int>::max();
+    return (int)(std::log((double)n) / std::log(1.0 / alpha)) + holguraAltura;
+}
+
+// Los puntos vivos del subarbol se reparten de nuevo por la mediana sobre los
+// mismos nodos (placement new), asi la arena no crece; los nodos sobrantes (uno
+// por lapida) vuelven a la arena. O(m log m) para m = tamano.
+// Devuelve la altura del subarbol reconstruido.
+template <class T, std::size_t D>
+int KDTreeND<T, D>::reconstruir(Nodo** enlace) {
+    Nodo* raiz = *enlace;
+    std::vector<PuntoId> puntos;
+    std::vector<Nodo*> huecos;
+    puntos.reserve(raiz->tamano - raiz->muertos);
+    huecos.reserve(raiz->tamano);
+
+    TraversalStack<Nodo*> pila;
+    pila.push(raiz);
+    while (!pila.empty()) {
+        Nodo* nodo = pila.pop();
+        if (!nodo->borrado) puntos.push_back({nodo->punto, nodo->id, nodo->atributo});
+        huecos.push_back(nodo);
+        if (nodo->izquierdo) pila.push(nodo->izquierdo);
+        if (nodo->derecho) pila.push(nodo->derecho);
+    }
+
+    reconstrucciones++;
+    nodosReconstruidos += puntos.size();
+    Nodo* const* ranuras = huecos.data();
+    int nivelRaiz = raiz->nivel;
+    *enlace = buildSerial(puntos, 0, puntos.size(), nivelRaiz,
+                       [ranuras](std::size_t i) { return ranuras[i]; });
+    for (std::size_t i = puntos.size(); i < huecos.size(); i++) nodos.destroy(huecos[i]);
+
+    int nivelMaximo = nivelRaiz - 1;
+    for (std::size_t i = 0; i < puntos.size(); i++) nivelMaximo = std::max(nivelMaximo, huecos[i]->nivel);
+    return nivelMaximo - nivelRaiz + 1;
+}
+
+template <class T, std::size_t D>
+bool KDTreeND<T, D>::claveUnica(const Nodo* raiz) {
+    TraversalStack<const Nodo*> pila;
+    pila.push(raiz);
+    while (!pila.empty()) {
+        const Nodo* nodo = pila.pop();
+        if (nodo->id != raiz->id || !mismoPunto(nodo->punto, raiz->punto)) return false;
+        if (nodo->izquierdo) pila.push(nodo->izquierdo);
+        if (nodo->derecho) pila.push(nodo->derecho);
+    }
+    return true;
+}
+
+// ============ ELIMINACION PEREZOSA
+template <class T, std::size_t D>
+void KDTreeND<T, D>::setLazyDeletion(bool activar) {
+    if (!activar) compact();
+    borradoPerezoso = activar;
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::setCompactionThreshold(float fraccion) {
+    umbralCompactacion = std::min(std::max(fraccion, 0.01f), 1.0f);
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::compact() {
+    if (root == nullptr || root->muertos == 0) return;
+    reconstruir(&root);
+    tamanoMaximo = nodos.size();
+}
+
+// Complejidad: O(log n) mas la compactacion amortizada, O(log n / umbral) por borrado.
+// Todas las copias de un par (punto, id) estan en el camino de busqueda de su
+// clave (las iguales van a la derecha): se marca la primera viva.
+// Una hoja no necesita lapida: se desengancha directamente.
+template <class T, std::size_t D>
+template <bool ConStats>
+void KDTreeND<T, D>::marcarBorrado(const Punto& punto, std::uint32_t id, QueryStats* stats) {
+    if (id == SIN_ID) id = buscarId<ConStats>(root, punto, true, stats);
+    if (id == SIN_ID) return;
+
+    Nodo** enlace = &root;
+    TraversalStack<Nodo**> camino;
+
+    if (root != nullptr) {
+        recorrerNiveles(0, [&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            Nodo* nodo = *enlace;
+            if constexpr (ConStats) {
+                contarVisita(stats, (int)camino.size());
+                stats->distancias++;
+            }
+            if (!nodo->borrado && mismoPunto(nodo->punto, punto) && nodo->id == id) return false;
+            camino.push(enlace);
+            bool izquierda = precede(punto, id, nodo->punto, nodo->id, eje);
+            if constexpr (ConStats) {
+                stats->subarbolesPodados += ((izquierda ? nodo->derecho : nodo->izquierdo) != nullptr);
+            }
+            enlace = izquierda ? &nodo->izquierdo : &nodo->derecho;
+            return *enlace != nullptr;
+        });
+    }
+    Nodo* objetivo = *enlace;
+    if (objetivo == nullptr) return;
+
+    if (objetivo->izquierdo == nullptr && objetivo->derecho == nullptr) {
+        nodos.destroy(objetivo);
+        *enlace = nullptr;
+    } else {
+        objetivo->borrado = true;
+        camino.push(enlace);
+    }
+
+    // Recalcular el camino de abajo hacia arriba; el ultimo subarbol que supera
+    // el umbral de muertos es el mas alto y es el que se compacta
+    Nodo** compactar = nullptr;
+    while (!camino.empty()) {
+        Nodo** actual = camino.pop();
+        Nodo* nodo = *actual;
+        actualizarResumen(nodo);
+        if (nodo->muertos > umbralCompactacion * nodo->tamano) compactar = actual;
+    }
+    if (compactar == nullptr) return;
+
+    // Los ancestros del subarbol compactado cambian de tamano y de caja
+    TraversalStack<Nodo*> ancestros;
+    enlace = &root;
+    recorrerNiveles(0, [&](auto E) {
+        constexpr std::size_t eje = decltype(E)::value;
+        if (enlace == compactar) return false;
+        Nodo* nodo = *enlace;
+        ancestros.push(nodo);
+        enlace = precede(punto, id, nodo->punto, nodo->id, eje) ? &nodo->izquierdo : &nodo->derecho;
+        return true;
+    });
+    reconstruir(compactar);
+    while (!ancestros.empty()) actualizarResumen(ancestros.pop());
+}
+
+template <class T, std::size_t D>
+EstadisticasBalance KDTreeND<T, D>::balanceStats() const {
+    EstadisticasBalance estadisticas;
+    estadisticas.reconstrucciones = reconstrucciones;
+    estadisticas.nodosReconstruidos = nodosReconstruidos;
+    estadisticas.alturaPermitida = (root && alpha < 1.0f) ? alturaPermitida(nodos.size()) + 1 : 0;
+
+    TraversalStack<Nodo*> pila;
+    if (root) pila.push(root);
+    while (!pila.empty()) {
+        Nodo* nodo = pila.pop();
+        estadisticas.altura = std::max(estadisticas.altura, nodo->nivel + 1);
+        if (nodo->izquierdo) pila.push(nodo->izquierdo);
+        if (nodo->derecho) pila.push(nodo->derecho);
+    }
+    return estadisticas;
+}
+
+template <class T, std::size_t D>
+KDTreeND<T, D>::KDTreeND(KDTreeND&& otro) noexcept
+    : root(std::exchange(otro.root, nullptr)), nodos(std::move(otro.nodos)),
+      podaConCajas(otro.podaConCajas), alpha(otro.alpha),
+      reconstrucciones(std::exchange(otro.reconstrucciones, 0)),
+      nodosReconstruidos(std::exchange(otro.nodosReconstruidos, 0)),
+      tamanoMaximo(std::exchange(otro.tamanoMaximo, 0)),
+      holguraAltura(std::exchange(otro.holguraAltura, 0)),
+      borradoPerezoso(otro.borradoPerezoso), umbralCompactacion(otro.umbralCompactacion),
+      siguienteId(std::exchange(otro.siguienteId, 0)), latencias(std::move(otro.latencias)) {}
+
+template <class T, std::size_t D>
+KDTreeND<T, D>& KDTreeND<T, D>::operator=(KDTreeND&& otro) noexcept {
+    if (this != &otro) {
+        nodos = std::move(otro.nodos);
+        root = std::exchange(otro.root, nullptr);
+        podaConCajas = otro.podaConCajas;
+        alpha = otro.alpha;
+        reconstrucciones = std::exchange(otro.reconstrucciones, 0);
+        nodosReconstruidos = std::exchange(otro.nodosReconstruidos, 0);
+        tamanoMaximo = std::exchange(otro.tamanoMaximo, 0);
+        holguraAltura = std::exchange(otro.holguraAltura, 0);
+        borradoPerezoso = otro.borradoPerezoso;
+        umbralCompactacion = otro.umbralCompactacion;
+        siguienteId = std::exchange(otro.siguienteId, 0);
+        latencias = std::move(otro.latencias);
+    }
+    return *this;
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::clear() {
+    nodos.release();
+    root = nullptr;
+    reconstrucciones = 0;
+    nodosReconstruidos = 0;
+    tamanoMaximo = 0;
+    holguraAltura = 0;
+    siguienteId = 0;
+}
+
+// Las lapidas ocupan nodo pero no cuentan como puntos
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::points() const -> std::vector<Punto> {
+    std::vector<Punto> resultado;
+    resultado.reserve(size());
+
+    std::vector<Nodo*> pila;
+    if (root) pila.push_back(root);
+    while (!pila.empty()) {
+        Nodo* nodo = pila.back();
+        pila.pop_back();
+        if (!nodo->borrado) resultado.push_back(nodo->punto);
+        if (nodo->izquierdo) pila.push_back(nodo->izquierdo);
+        if (nodo->derecho) pila.push_back(nodo->derecho);
+    }
+    return resultado;
+}
+
+// ============ VECINO MAS CERCANO
+// Complejidad: O(log n) promedio, O(n) peor caso
+// Iterativo: se baja siempre por la rama del lado del objetivo y la rama
+// opuesta queda en la pila con la distancia a su plano; al sacarla se descarta
+// si el circulo de radio r (mejor distancia actual) ya no cruza ese plano.
+// ConCajas: la cota de cada rama es la distancia a su caja envolvente (siempre
+// >= la distancia al plano) y el descenso se corta si la caja queda fuera del circulo.
+// Aprox: el circulo se encoge a radio / (1 + epsilon) y cada nodo evaluado
+// consume presupuesto; al agotarlo no se evalua ningun nodo mas.
+// ConStats: cada rama descartada cuenta una vez, al descartarla.
+// ConFiltro: un punto solo es candidato si su atributo cumple el filtro, y una
+// rama cuyo rango de atributo no lo corta no se visita.
+template <class T, std::size_t D>
+template <bool ConCajas, bool Aprox, bool ConStats, bool ConFiltro>
+auto KDTreeND<T, D>::vecinoMasCercano(Nodo* raiz, const Punto& objetivo, EstadoAprox* aprox,
+                                      QueryStats* stats, const FiltroAtributo* filtro) -> Nodo* {
+    Nodo* mejor = nullptr;
+    Distancia radioCuadrado = INFINITO;
+
+    // Poda: la rama solo se explora si el circulo intersecta su plano divisor (o su caja)
+    auto descartarSinContar = [&](Distancia cota) {
+        if (cota > radioCuadrado) return true;
+        if constexpr (Aprox) {
+            if ((double)cota * aprox->factor > (double)radioCuadrado) {
+                aprox->informe.exacto = false;
+                return true;
+            }
+        }
+        return false;
+    };
+    auto descartar = [&](Distancia cota) {
+        bool descartada = descartarSinContar(cota);
+        if constexpr (ConStats) stats->subarbolesPodados += descartada;
+        return descartada;
+    };
+    // ConFiltro: la rama sin atributos dentro del filtro se pierde (nullptr)
+    auto filtrarRama = [&](Nodo* rama) -> Nodo* {
+        if constexpr (ConFiltro) {
+            if (rama != nullptr && !solapaFiltro(rama, *filtro)) {
+                if constexpr (ConStats) stats->subarbolesPodados++;
+                return nullptr;
+            }
+        }
+        return rama;
+    };
+
+    TraversalStack<Pendiente> pila;
+    if (filtrarRama(raiz)) pila.push({raiz, 0, Distancia(0)});
+
+    while (!pila.empty()) {
+        Pendiente actual = pila.pop();
+        if (descartar(actual.distanciaPlano)) continue;
+
+        Nodo* nodo = actual.nodo;
+        int profundidad = actual.profundidad;
+        recorrerNiveles(profundidad % D, [&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            if constexpr (Aprox) {
+                if (aprox->restantes == 0) {
+                    aprox->informe.exacto = false;
+                    return false;
+                }
+                aprox->restantes--;
+                aprox->informe.nodosVisitados++;
+            }
+            if constexpr (ConStats) {
+                contarVisita(stats, profundidad);
+                stats->distancias++;
+            }
+            Distancia distancia = distanciaCuadrado(objetivo, nodo->punto);
+            bool candidato = !nodo->borrado && (!ConFiltro || cumpleFiltro(nodo, *filtro));
+            if (distancia < radioCuadrado && candidato) {
+                radioCuadrado = distancia;
+                mejor = nodo;
+            }
+
+            // r' = distancia desde el objetivo al plano divisor (en el eje correspondiente)
+            Distancia distanciaPlano = diferencia(objetivo[eje], nodo->punto[eje]);
+            Nodo* ramaSiguiente = filtrarRama((distanciaPlano < 0) ? nodo->izquierdo : nodo->derecho);
+            Nodo* ramaOpuesta = filtrarRama((distanciaPlano < 0) ? nodo->derecho : nodo->izquierdo);
+
+            if (ramaOpuesta != nullptr) {
+                Distancia cota = ConCajas ? distanciaCaja(objetivo, ramaOpuesta->caja)
+                                          : distanciaPlano * distanciaPlano;
+                if constexpr (ConStats && ConCajas) stats->distancias++;
+                if (!descartar(cota)) pila.push({ramaOpuesta, profundidad + 1, cota});
+            }
+
+            if constexpr (ConStats && ConCajas) stats->distancias += (ramaSiguiente != nullptr);
+            if (ConCajas && ramaSiguiente != nullptr &&
+                descartar(distanciaCaja(objetivo, ramaSiguiente->caja))) {
+                return false;
+            }
+            nodo = ramaSiguiente;
+            profundidad++;
+            return nodo != nullptr;
+        });
+    }
+
+    return mejor;
+}
+
+// Metodo publico: encuentra el punto mas cercano a 'objetivo' en el KD-tree
+//  - Tiempo: O(log n) promedio con poda efectiva, O(n) peor caso.
+//  - Nota: en la UI se mide y muestra el tiempo real de la operación para el usuario.
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::nearest(const Punto& objetivo) const -> Punto {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::Nearest);
+    if (!root) return Punto{};
+
+    Nodo* resultado = podaConCajas ? vecinoMasCercano<true>(root, objetivo)
+                                   : vecinoMasCercano<false>(root, objetivo);
+
+    if (resultado) return resultado->punto;
+    return Punto{};
+}
+
+template <class T, std::size_t D>
+std::uint32_t KDTreeND<T, D>::nearestId(const Punto& objetivo) const {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::Nearest);
+    Nodo* resultado = podaConCajas ? vecinoMasCercano<true>(root, objetivo)
+                                   : vecinoMasCercano<false>(root, objetivo);
+    return resultado ? resultado->id : SIN_ID;
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::nearest(const Punto& objetivo, QueryStats* stats) const -> Punto {
+    if (stats == nullptr) return nearest(objetivo);
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::Nearest);
+    Nodo* resultado = podaConCajas ? vecinoMasCercano<true, false, true>(root, objetivo, nullptr, stats)
+                                   : vecinoMasCercano<false, false, true>(root, objetivo, nullptr, stats);
+    return resultado ? resultado->punto : Punto{};
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::estadoAprox(float epsilon, std::size_t maxNodos) -> EstadoAprox {
+    double factor = 1.0 + std::max(epsilon, 0.0f);
+    return {factor * factor, maxNodos ? maxNodos : std::numeric_limits<std::size_t>::max(), {}};
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::nearestApprox(const Punto& objetivo, float epsilon, std::size_t maxNodos,
+                                   InformeAproximado* informe) const -> Punto {
+    EstadoAprox aprox = estadoAprox(epsilon, maxNodos);
+    Nodo* resultado = podaConCajas ? vecinoMasCercano<true, true>(root, objetivo, &aprox)
+                                   : vecinoMasCercano<false, true>(root, objetivo, &aprox);
+    if (informe) *informe = aprox.informe;
+    return resultado ? resultado->punto : Punto{};
+}
+
+// ============ BUSQUEDA POR RANGO
+// Complejidad: O(n^(1-1/D) + k) esperado, O(n) peor caso
+// Iterativa: se baja por un hijo mientras sea posible; cuando el rectangulo
+// cruza el plano divisor, el subarbol derecho queda pendiente en la pila.
+
+// Emite todos los nodos vivos del subarbol sin comprobar el rectangulo.
+// La profundidad de cada nodo solo se sigue con ConStats.
+// ConFiltro: solo se comprueba el atributo; los hijos cuyo rango no corta el
+// filtro no se visitan.
+template <class T, std::size_t D>
+template <bool ConStats, bool ConFiltro, class Emitir>
+bool KDTreeND<T, D>::volcarSubarbol(Nodo* raiz, Emitir& emitir, int profundidad,
+                                    QueryStats* stats, const FiltroAtributo* filtro) {
+    auto emite = [&](const Nodo* nodo) {
+        return !nodo->borrado && (!ConFiltro || cumpleFiltro(nodo, *filtro));
+    };
+    auto entra = [&](const Nodo* hijo) {
+        return hijo != nullptr && (!ConFiltro || solapaFiltro(hijo, *filtro));
+    };
+    if constexpr (ConStats) {
+        TraversalStack<std::pair<Nodo*, int>> pila;
+        pila.push({raiz, profundidad});
+        while (!pila.empty()) {
+            auto [nodo, nivel] = pila.pop();
+            contarVisita(stats, nivel);
+            if (emite(nodo) && !emitir(nodo)) return false;
+            if (entra(nodo->derecho)) pila.push({nodo->derecho, nivel + 1});
+            if (entra(nodo->izquierdo)) pila.push({nodo->izquierdo, nivel + 1});
+        }
+        return true;
+    }
+    TraversalStack<Nodo*> pila;
+    pila.push(raiz);
+    while (!pila.empty()) {
+        Nodo* nodo = pila.pop();
+        if (emite(nodo) && !emitir(nodo)) return false;
+        if (entra(nodo->derecho)) pila.push(nodo->derecho);
+        if (entra(nodo->izquierdo)) pila.push(nodo->izquierdo);
+    }
+    return true;
+}
+
+// ConCajas: un hijo solo se visita si su caja intersecta el rectangulo, y un
+// subarbol cuya caja queda dentro del rectangulo se vuelca entero.
+// ConFiltro: un hijo cuyo rango de atributo no corta el filtro no se visita,
+// y el volcado sigue comprobando el atributo.
+template <class T, std::size_t D>
+template <bool ConCajas, bool ConStats, bool ConFiltro, class Emitir>
+bool KDTreeND<T, D>::busquedaRango(Nodo* raiz, const Caja& rectangulo, Emitir& emitir,
+                                   QueryStats* stats, const FiltroAtributo* filtro) {
+    TraversalStack<Pendiente> pila;
+    if (raiz && (!ConFiltro || solapaFiltro(raiz, *filtro))) pila.push({raiz, 0, Distancia(0)});
+    bool detenida = false;
+
+    while (!detenida && !pila.empty()) {
+        Pendiente actual = pila.pop();
+        Nodo* nodo = actual.nodo;
+        int profundidad = actual.profundidad;
+
+        recorrerNiveles(profundidad % D, [&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            if constexpr (ConStats && ConCajas) stats->distancias++;
+            if (ConCajas && contieneCaja(rectangulo, nodo->caja)) {
+                detenida = !volcarSubarbol<ConStats, ConFiltro>(nodo, emitir, profundidad, stats, filtro);
+                return false;
+            }
+
+            // Paso 1: Verificar si el punto del nodo esta dentro del rectangulo
+            if constexpr (ConStats) {
+                contarVisita(stats, profundidad);
+                stats->distancias++;
+            }
+            if (dentroDeCaja(nodo->punto, rectangulo) && !nodo->borrado &&
+                (!ConFiltro || cumpleFiltro(nodo, *filtro)) && !emitir(nodo)) {
+                detenida = true;
+                return false;
+            }
+
+            // Paso 2: seguir solo por los hijos cuyo semiplano (o caja) intersecta el rectangulo
+            Nodo* izquierdo;
+            Nodo* derecho;
+            if (ConCajas) {
+                izquierdo = (nodo->izquierdo && intersectaCaja(rectangulo, nodo->izquierdo->caja))
+                                ? nodo->izquierdo : nullptr;
+                derecho = (nodo->derecho && intersectaCaja(rectangulo, nodo->derecho->caja))
+                              ? nodo->derecho : nullptr;
+            } else {
+                T valor = nodo->punto[eje];
+                izquierdo = (rectangulo.inferior(eje) <= valor) ? nodo->izquierdo : nullptr;
+                derecho = (rectangulo.superior(eje) >= valor) ? nodo->derecho : nullptr;
+            }
+            if constexpr (ConFiltro) {
+                if (izquierdo && !solapaFiltro(izquierdo, *filtro)) izquierdo = nullptr;
+                if (derecho && !solapaFiltro(derecho, *filtro)) derecho = nullptr;
+            }
+            if constexpr (ConStats) {
+                if constexpr (ConCajas) stats->distancias += (nodo->izquierdo != nullptr) + (nodo->derecho != nullptr);
+                stats->subarbolesPodados += (izquierdo != nodo->izquierdo) + (derecho != nodo->derecho);
+            }
+
+            profundidad++;
+            if (izquierdo != nullptr && derecho != nullptr) {
+                pila.push({derecho, profundidad, Distancia(0)});
+                nodo = izquierdo;
+            } else {
+                nodo = (izquierdo != nullptr) ? izquierdo : derecho;
+            }
+            return nodo != nullptr;
+        });
+    }
+    return !detenida;
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::rangeSearch(const Caja& rectangulo) const -> std::vector<Punto> {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::RangeSearch);
+    std::vector<Punto> resultado;
+    auto emitir = [&resultado](const Nodo* nodo) {
+        resultado.push_back(nodo->punto);
+        return true;
+    };
+    if (podaConCajas) busquedaRango<true>(root, rectangulo, emitir);
+    else busquedaRango<false>(root, rectangulo, emitir);
+    return resultado;
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::rangeSearch(const Caja& rectangulo, QueryStats* stats) const
+    -> std::vector<Punto> {
+    if (stats == nullptr) return rangeSearch(rectangulo);
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::RangeSearch);
+    std::vector<Punto> resultado;
+    auto emitir = [&resultado](const Nodo* nodo) {
+        resultado.push_back(nodo->punto);
+        return true;
+    };
+    if (podaConCajas) busquedaRango<true, true>(root, rectangulo, emitir, stats);
+    else busquedaRango<false, true>(root, rectangulo, emitir, stats);
+    return resultado;
+}
+
+template <class T, std::size_t D>
+std::vector<std::uint32_t> KDTreeND<T, D>::rangeSearchIds(const Caja& rectangulo) const {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::RangeSearch);
+    std::vector<std::uint32_t> resultado;
+    auto emitir = [&resultado](const Nodo* nodo) {
+        resultado.push_back(nodo->id);
+        return true;
+    };
+    if (podaConCajas) busquedaRango<true>(root, rectangulo, emitir);
+    else busquedaRango<false>(root, rectangulo, emitir);
+    return resultado;
+}
+
+// ============ VISITANTES (rango y radio)
+template <class T, std::size_t D>
+template <class F>
+bool KDTreeND<T, D>::visitar(F& f, const Nodo* nodo) {
+    auto llamar = [&]() -> decltype(auto) {
+        if constexpr (std::is_invocable_v<F&, const Punto&, std::uint32_t>) return f(nodo->punto, nodo->id);
+        else return f(nodo->punto);
+    };
+    if constexpr (std::is_void_v<decltype(llamar())>) {
+        llamar();
+        return true;
+    } else {
+        return static_cast<bool>(llamar());
+    }
+}
+
+template <class T, std::size_t D>
+template <class F>
+void KDTreeND<T, D>::forEachInRange(const Caja& rectangulo, F&& f) const {
+    auto emitir = [&f](const Nodo* nodo) { return visitar(f, nodo); };
+    if (podaConCajas) busquedaRango<true>(root, rectangulo, emitir);
+    else busquedaRango<false>(root, rectangulo, emitir);
+}
+
+// Misma estrategia que busquedaRango con la bola en lugar del rectangulo: una
+// rama se descarta si el plano (o su caja) queda a mas de radio del centro, y
+// ConCajas vuelca sin comprobar los subarboles cuya caja cabe en la bola.
+template <class T, std::size_t D>
+template <bool ConCajas, class Emitir>
+bool KDTreeND<T, D>::busquedaRadio(Nodo* raiz, const Punto& centro, Distancia radioCuadrado,
+                                   Emitir& emitir) {
+    TraversalStack<Pendiente> pila;
+    if (raiz) pila.push({raiz, 0, Distancia(0)});
+    bool detenida = false;
+
+    while (!detenida && !pila.empty()) {
+        Pendiente actual = pila.pop();
+        Nodo* nodo = actual.nodo;
+        int profundidad = actual.profundidad;
+
+        recorrerNiveles(profundidad % D, [&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            if (ConCajas && distanciaMaxCaja(centro, nodo->caja) <= radioCuadrado) {
+                detenida = !volcarSubarbol(nodo, emitir);
+                return false;
+            }
+
+            if (!nodo->borrado && distanciaCuadrado(centro, nodo->punto) <= radioCuadrado &&
+                !emitir(nodo)) {
+                detenida = true;
+                return false;
+            }
+
+            Nodo* izquierdo;
+            Nodo* derecho;
+            if (ConCajas) {
+                izquierdo = (nodo->izquierdo && distanciaCaja(centro, nodo->izquierdo->caja) <= radioCuadrado)
+                                ? nodo->izquierdo : nullptr;
+                derecho = (nodo->derecho && distanciaCaja(centro, nodo->derecho->caja) <= radioCuadrado)
+                              ? nodo->derecho : nullptr;
+            } else {
+                Distancia diff = diferencia(centro[eje], nodo->punto[eje]);
+                bool cruza = diff * diff <= radioCuadrado;
+                izquierdo = (diff < 0 || cruza) ? nodo->izquierdo : nullptr;
+                derecho = (diff >= 0 || cruza) ? nodo->derecho : nullptr;
+            }
+
+            profundidad++;
+            if (izquierdo != nullptr && derecho != nullptr) {
+                pila.push({derecho, profundidad, Distancia(0)});
+                nodo = izquierdo;
+            } else {
+                nodo = (izquierdo != nullptr) ? izquierdo : derecho;
+            }
+            return nodo != nullptr;
+        });
+    }
+    return !detenida;
+}
+
+template <class T, std::size_t D>
+template <class F>
+void KDTreeND<T, D>::forEachInRadius(const Punto& centro, Distancia radio, F&& f) const {
+    if (radio < 0) return;
+    auto emitir = [&f](const Nodo* nodo) { return visitar(f, nodo); };
+    if (podaConCajas) busquedaRadio<true>(root, centro, radio * radio, emitir);
+    else busquedaRadio<false>(root, centro, radio * radio, emitir);
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::radiusSearch(const Punto& centro, Distancia radio) const -> std::vector<Punto> {
+    std::vector<Punto> resultado;
+    forEachInRadius(centro, radio, [&resultado](const Punto& p) { resultado.push_back(p); });
+    return resultado;
+}
+
+template <class T, std::size_t D>
+std::vector<std::uint32_t> KDTreeND<T, D>::radiusSearchIds(const Punto& centro, Distancia radio) const {
+    std::vector<std::uint32_t> resultado;
+    forEachInRadius(centro, radio, [&resultado](const Punto&, std::uint32_t id) { resultado.push_back(id); });
+    return resultado;
+}
+
+// ============ BUSQUEDA POR POLIGONO CONVEXO
+// Cada arista (p, q) recorrida en sentido antihorario deja el interior a su
+// izquierda: cruz(q - p, x - p) >= 0, es decir a . x <= b con a = (dy, -dx) y
+// b = a . p. En sentido horario se invierten los signos.
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::regionPoligono(const std::vector<Punto>& vertices) -> RegionConvexa {
+    static_assert(D == 2, "polygonSearch solo admite arboles 2D");
+    RegionConvexa region;
+    std::size_t n = vertices.size();
+    if (n < 3) return region;
+
+    double area = 0;  // doble del area con signo: > 0 si es antihorario
+    for (std::size_t i = 0; i < n; i++) {
+        const Punto& p = vertices[i];
+        const Punto& q = vertices[(i + 1) % n];
+        area += (double)p[0] * (double)q[1] - (double)q[0] * (double)p[1];
+    }
+    double signo = (area < 0) ? -1.0 : 1.0;
+
+    region.envolvente = cajaDePunto(vertices[0]);
+    for (std::size_t i = 0; i < n; i++) {
+        const Punto& p = vertices[i];
+        const Punto& q = vertices[(i + 1) % n];
+        double dx = (double)q[0] - (double)p[0];
+        double dy = (double)q[1] - (double)p[1];
+        typename RegionConvexa::Semiespacio h;
+        h.a[0] = signo * dy;
+        h.a[1] = -signo * dx;
+        h.b = h.a[0] * (double)p[0] + h.a[1] * (double)p[1];
+        region.semiespacios.push_back(h);
+        extenderCaja(region.envolvente, p);
+    }
+    return region;
+}
+
+template <class T, std::size_t D>
+bool KDTreeND<T, D>::dentroDeRegion(const Punto& p, const RegionConvexa& region, std::uint64_t activos) {
+    for (std::size_t i = 0; i < region.semiespacios.size(); i++) {
+        if (i < 64 && !(activos >> i & 1)) continue;
+        const auto& h = region.semiespacios[i];
+        double producto = 0;
+        for (std::size_t e = 0; e < D; e++) producto += h.a[e] * (double)p[e];
+        if (producto > h.b) return false;
+    }
+    return true;
+}
+
+// Para cada semiespacio, el minimo y el maximo de a . x en la caja estan en
+// las esquinas que eligen los signos de a: minimo > b deja la caja fuera y
+// maximo <= b la deja del lado interior (el semiespacio deja de estar activo:
+// las cajas de los hijos estan contenidas en la del padre). Dentro cuando no
+// queda ninguno activo. Una caja que no separa ningun semiespacio por si solo
+// ni la envolvente se clasifica como cruzando aunque quede fuera (se
+// desciende de mas, el resultado sigue siendo exacto).
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::relacionCaja(const Caja& caja, const RegionConvexa& region, std::uint64_t& activos)
+    -> Relacion {
+    if (!intersectaCaja(caja, region.envolvente)) return Relacion::Fuera;
+    bool dentro = true;
+    for (std::size_t i = 0; i < region.semiespacios.size(); i++) {
+        if (i < 64 && !(activos >> i & 1)) continue;
+        const auto& h = region.semiespacios[i];
+        double minimo = 0, maximo = 0;
+        for (std::size_t e = 0; e < D; e++) {
+            double bajo = h.a[e] * (double)caja.inferior(e);
+            double alto = h.a[e] * (double)caja.superior(e);
+            minimo += std::min(bajo, alto);
+            maximo += std::max(bajo, alto);
+        }
+        if (minimo > h.b) return Relacion::Fuera;
+        if (maximo > h.b) dentro = false;
+        else if (i < 64) activos &= ~(std::uint64_t(1) << i);
+    }
+    return dentro ? Relacion::Dentro : Relacion::Cruza;
+}
+
+// Mismo recorrido que busquedaRango. ConCajas: cada nodo clasifica su caja al
+// entrar (una vez por subarbol alcanzado) solo contra los semiespacios que
+// aun cortan la de su padre; fuera se poda y dentro se vuelca. Sin cajas, los
+// hijos se podan por plano contra la caja envolvente.
+template <class T, std::size_t D>
+template <bool ConCajas, class Emitir>
+bool KDTreeND<T, D>::busquedaConvexa(Nodo* raiz, const RegionConvexa& region, Emitir& emitir) {
+    struct PendienteRegion {
+        Nodo* nodo;
+        int profundidad;
+        std::uint64_t activos;
+    };
+
+    TraversalStack<PendienteRegion> pila;
+    if (raiz && !region.semiespacios.empty()) pila.push({raiz, 0, ~std::uint64_t(0)});
+    bool detenida = false;
+
+    while (!detenida && !pila.empty()) {
+        PendienteRegion actual = pila.pop();
+        Nodo* nodo = actual.nodo;
+        int profundidad = actual.profundidad;
+        std::uint64_t activos = actual.activos;
+
+        recorrerNiveles(profundidad % D, [&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            if constexpr (ConCajas) {
+                Relacion relacion = relacionCaja(nodo->caja, region, activos);
+                if (relacion == Relacion::Fuera) return false;
+                if (relacion == Relacion::Dentro) {
+                    detenida = !volcarSubarbol(nodo, emitir);
+                    return false;
+                }
+            }
+
+            if (!nodo->borrado && dentroDeRegion(nodo->punto, region, activos) && !emitir(nodo)) {
+                detenida = true;
+                return false;
+            }
+
+            Nodo* izquierdo = nodo->izquierdo;
+            Nodo* derecho = nodo->derecho;
+            if (!ConCajas) {
+                T valor = nodo->punto[eje];
+                if (region.envolvente.inferior(eje) > valor) izquierdo = nullptr;
+                if (region.envolvente.superior(eje) < valor) derecho = nullptr;
+            }
+
+            profundidad++;
+            if (izquierdo != nullptr && derecho != nullptr) {
+                pila.push({derecho, profundidad, activos});
+                nodo = izquierdo;
+            } else {
+                nodo = (izquierdo != nullptr) ? izquierdo : derecho;
+            }
+            return nodo != nullptr;
+        });
+    }
+    return !detenida;
+}
+
+template <class T, std::size_t D>
+template <class F>
+void KDTreeND<T, D>::forEachInPolygon(const std::vector<Punto>& vertices, F&& f) const {
+    RegionConvexa region = regionPoligono(vertices);
+    auto emitir = [&f](const Nodo* nodo) { return visitar(f, nodo); };
+    if (podaConCajas) busquedaConvexa<true>(root, region, emitir);
+    else busquedaConvexa<false>(root, region, emitir);
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::polygonSearch(const std::vector<Punto>& vertices) const -> std::vector<Punto> {
+    std::vector<Punto> resultado;
+    forEachInPolygon(vertices, [&resultado](const Punto& p) { resultado.push_back(p); });
+    return resultado;
+}
+
+template <class T, std::size_t D>
+std::vector<std::uint32_t> KDTreeND<T, D>::polygonSearchIds(const std::vector<Punto>& vertices) const {
+    std::vector<std::uint32_t> resultado;
+    forEachInPolygon(vertices, [&resultado](const Punto&, std::uint32_t id) { resultado.push_back(id); });
+    return resultado;
+}
+
+// ============ ELIMINACION
+// Complejidad: O(log n) promedio, O(n) peor caso
+// Devuelve el enlace (campo root o hijo) que apunta al nodo con la menor
+// coordenada en el eje d (el menor id en empate) dentro del subarbol *enlace,
+// cuya raiz esta a 'profundidad'. En los niveles que discriminan por d basta
+// con bajar por la izquierda.
+template <class T, std::size_t D>
+template <bool ConStats>
+auto KDTreeND<T, D>::findMin(Nodo** enlace, std::size_t d, int profundidad, QueryStats* stats)
+    -> Nodo** {
+    struct Entrada {
+        Nodo** enlace;
+        int profundidad;
+    };
+
+    Nodo** mejor = nullptr;
+    conEje(d, [&](auto E) {
+        constexpr std::size_t eje = decltype(E)::value;
+        TraversalStack<Entrada> pila;
+        if (*enlace) pila.push({enlace, profundidad});
+
+        while (!pila.empty()) {
+            Entrada actual = pila.pop();
+            Nodo* nodo = *actual.enlace;
+            if constexpr (ConStats) contarVisita(stats, actual.profundidad);
+
+            if (mejor == nullptr || precede(nodo->punto, nodo->id, (*mejor)->punto, (*mejor)->id, eje)) {
+                mejor = actual.enlace;
+            }
+
+            // El subarbol derecho de un nivel que discrimina por d no precede al nodo
+            if (actual.profundidad % D != eje && nodo->derecho != nullptr) {
+                pila.push({&nodo->derecho, actual.profundidad + 1});
+            } else if constexpr (ConStats) {
+                stats->subarbolesPodados += (nodo->derecho != nullptr);
+            }
+            if (nodo->izquierdo != nullptr) {
+                pila.push({&nodo->izquierdo, actual.profundidad + 1});
+            }
+        }
+    });
+
+    return mejor;
+}
+
+// Sin id no hay clave con la que bajar: un punto con la misma coordenada que el
+// nodo puede estar a cualquiera de sus dos lados, y en ese caso se miran ambos.
+template <class T, std::size_t D>
+template <bool ConStats>
+std::uint32_t KDTreeND<T, D>::buscarId(Nodo* raiz, const Punto& punto, bool soloVivos,
+                                       QueryStats* stats) {
+    struct Pendiente {
+        Nodo* nodo;
+        int profundidad;
+    };
+
+    TraversalStack<Pendiente> pila;
+    if (raiz) pila.push({raiz, 0});
+    while (!pila.empty()) {
+        Pendiente actual = pila.pop();
+        Nodo* nodo = actual.nodo;
+        if constexpr (ConStats) {
+            contarVisita(stats, actual.profundidad);
+            stats->distancias++;
+        }
+        if ((!soloVivos || !nodo->borrado) && mismoPunto(nodo->punto, punto)) return nodo->id;
+
+        conEje(actual.profundidad % D, [&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            T valor = nodo->punto[eje];
+            if (nodo->derecho != nullptr && punto[eje] >= valor) {
+                pila.push({nodo->derecho, actual.profundidad + 1});
+            }
+            if (nodo->izquierdo != nullptr && punto[eje] <= valor) {
+                pila.push({nodo->izquierdo, actual.profundidad + 1});
+            }
+        });
+    }
+    return SIN_ID;
+}
+
+// Iterativa: localiza el nodo y lo reemplaza por el minimo (en su eje) de su
+// subarbol derecho; el nodo donado pasa a ser el que hay que eliminar, hasta
+// llegar a una hoja que se desengancha y vuelve a la arena.
+// 'camino' guarda todos los nodos desde la raiz hasta esa hoja: al final sus
+// datos agregados (tamano, caja) se recalculan de abajo hacia arriba.
+// Con balanceo, cuando quedan menos de alpha * tamanoMaximo puntos el arbol
+// entero se reconstruye (las eliminaciones no alargan caminos, pero dejan
+// alturas calculadas para un n mayor).
+template <class T, std::size_t D>
+void KDTreeND<T, D>::remove(const Punto& punto, std::uint32_t id) {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::Remove);
+    eliminar<false>(punto, id, nullptr);
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::remove(const Punto& punto, std::uint32_t id, QueryStats* stats) {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::Remove);
+    if (stats) eliminar<true>(punto, id, stats);
+    else eliminar<false>(punto, id, nullptr);
+}
+
+template <class T, std::size_t D>
+template <bool ConStats>
+void KDTreeND<T, D>::eliminar(const Punto& punto, std::uint32_t id, QueryStats* stats) {
+    if (borradoPerezoso) {
+        marcarBorrado<ConStats>(punto, id, stats);
+        return;
+    }
+    if (id == SIN_ID) id = buscarId<ConStats>(root, punto, false, stats);
+    if (id == SIN_ID) return;
+
+    Nodo** enlace = &root;
+    int profundidad = 0;
+    TraversalStack<Nodo*> camino;
+
+    // Paso 1: buscar el nodo con el punto
+    if (root != nullptr) {
+        recorrerNiveles(0, [&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            Nodo* nodo = *enlace;
+            camino.push(nodo);
+            if constexpr (ConStats) {
+                contarVisita(stats, profundidad);
+                stats->distancias++;
+            }
+            if (mismoPunto(nodo->punto, punto) && nodo->id == id) return false;
+
+            bool izquierda = precede(punto, id, nodo->punto, nodo->id, eje);
+            if constexpr (ConStats) {
+                stats->subarbolesPodados += ((izquierda ? nodo->derecho : nodo->izquierdo) != nullptr);
+            }
+            enlace = izquierda ? &nodo->izquierdo : &nodo->derecho;
+            profundidad++;
+            return *enlace != nullptr;
+        });
+    }
+    if (*enlace == nullptr) return;
+
+    // Paso 2: reemplazos sucesivos hasta una hoja
+    while (true) {
+        Nodo* nodo = *enlace;
+
+        if (nodo->derecho == nullptr && nodo->izquierdo == nullptr) {
+            camino.pop();
+            nodos.destroy(nodo);
+            *enlace = nullptr;
+            break;
+        }
+
+        // Sin subarbol derecho: el izquierdo pasa a la derecha y se usa su minimo,
+        // asi el subarbol derecho sigue siendo >= al nuevo punto del nodo
+        if (nodo->derecho == nullptr) {
+            nodo->derecho = nodo->izquierdo;
+            nodo->izquierdo = nullptr;
+        }
+
+        Nodo** enlaceMin = findMin<ConStats>(&nodo->derecho, profundidad % D, profundidad + 1, stats);
+        Nodo* minimo = *enlaceMin;
+
+        // Camino hasta el donante: a la izquierda de cada nodo solo hay claves que
+        // lo preceden, asi que las comparaciones con su clave llevan exactamente hasta el
+        Nodo* actual = nodo->derecho;
+        if (actual != minimo) {
+            recorrerNiveles(actual->nivel % D, [&](auto E) {
+                constexpr std::size_t eje = decltype(E)::value;
+                camino.push(actual);
+                actual = precede(minimo->punto, minimo->id, actual->punto, actual->id, eje)
+                             ? actual->izquierdo
+                             : actual->derecho;
+                return actual != minimo;
+            });
+        }
+        camino.push(minimo);
+
+        nodo->punto = minimo->punto;
+        nodo->id = minimo->id;
+        nodo->atributo = minimo->atributo;
+        enlace = enlaceMin;
+        profundidad = minimo->nivel;
+    }
+
+    while (!camino.empty()) actualizarResumen(camino.pop());
+
+    if (root != nullptr && alpha < 1.0f && nodos.size() < alpha * tamanoMaximo) {
+        reconstruir(&root);
+        tamanoMaximo = nodos.size();
+    }
+}
+
+// ============ CONTEO POR RANGO
+// Complejidad: O(n^(1-1/D)) en un arbol balanceado
+// Cada entrada de la pila lleva la celda (region del espacio) de su subarbol;
+// con la poda por cajas se usa la caja ajustada, mas pequena que la celda.
+template <class T, std::size_t D>
+std::size_t KDTreeND<T, D>::rangeCount(const Caja& rectangulo) const {
+    return contarRango(root, rectangulo, podaConCajas);
+}
+
+template <class T, std::size_t D>
+std::size_t KDTreeND<T, D>::contarRango(Nodo* raiz, const Caja& rectangulo, bool conCajas) {
+    struct PendienteCelda {
+        Nodo* nodo;
+        int profundidad;
+        Caja celda;
+    };
+
+    std::size_t cuenta = 0;
+    TraversalStack<PendienteCelda> pila;
+    if (raiz) {
+        PendienteCelda inicial{raiz, 0, {}};
+        for (std::size_t e = 0; e < D; e++) {
+            inicial.celda.inferior(e) = std::numeric_limits<T>::has_infinity
+                                            ? -std::numeric_limits<T>::infinity()
+                                            : std::numeric_limits<T>::lowest();
+            inicial.celda.superior(e) = std::numeric_limits<T>::has_infinity
+                                            ? std::numeric_limits<T>::infinity()
+                                            : std::numeric_limits<T>::max();
+        }
+        pila.push(inicial);
+    }
+
+    while (!pila.empty()) {
+        PendienteCelda actual = pila.pop();
+        Nodo* nodo = actual.nodo;
+
+        // Celda completamente dentro: todo el subarbol cuenta sin visitarlo
+        const Caja& region = conCajas ? nodo->caja : actual.celda;
+        if (contieneCaja(rectangulo, region)) {
+            cuenta += nodo->tamano - nodo->muertos;
+            continue;
+        }
+        if (conCajas && !intersectaCaja(rectangulo, region)) continue;
+
+        if (dentroDeCaja(nodo->punto, rectangulo) && !nodo->borrado) cuenta++;
+
+        conEje(actual.profundidad % D, [&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            T valor = nodo->punto[eje];
+            if (nodo->izquierdo != nullptr && rectangulo.inferior(eje) <= valor) {
+                Caja celda = actual.celda;
+                celda.superior(eje) = valor;
+                pila.push({nodo->izquierdo, actual.profundidad + 1, celda});
+            }
+            if (nodo->derecho != nullptr && rectangulo.superior(eje) >= valor) {
+                Caja celda = actual.celda;
+                celda.inferior(eje) = valor;
+                pila.push({nodo->derecho, actual.profundidad + 1, celda});
+            }
+        });
+    }
+
+    return cuenta;
+}
+
+// ============ K VECINOS MAS CERCANOS (k-NN)
+// Complejidad: O(k * log n) promedio, O(n) peor caso
+// Iterativa: misma estrategia que vecinoMasCercano, con el radio de poda igual
+// a la distancia del peor candidato mientras el heap tenga k elementos.
+// ConCajas: como en vecinoMasCercano, la cota de cada rama es la distancia a su caja.
+// Aprox: como en vecinoMasCercano, con el radio del peor candidato.
+// ConFiltro: como en vecinoMasCercano.
+template <class T, std::size_t D>
+template <bool ConCajas, bool Aprox, bool ConStats, bool ConFiltro>
+void KDTreeND<T, D>::busquedaKVecinos(Nodo* raiz, const Punto& objetivo, int k,
+                                      std::vector<Candidato>& pq, EstadoAprox* aprox,
+                                      QueryStats* stats, const FiltroAtributo* filtro) {
+    // Con el heap lleno, una rama se descarta si su cota no mejora al peor candidato
+    auto descartarSinContar = [&](Distancia cota) {
+        if (pq.size() < (std::size_t)k) return false;
+        if (cota >= pq.front().first) return true;
+        if constexpr (Aprox) {
+            if ((double)cota * aprox->factor >= (double)pq.front().first) {
+                aprox->informe.exacto = false;
+                return true;
+            }
+        }
+        return false;
+    };
+    auto descartar = [&](Distancia cota) {
+        bool descartada = descartarSinContar(cota);
+        if constexpr (ConStats) stats->subarbolesPodados += descartada;
+        return descartada;
+    };
+    auto filtrarRama = [&](Nodo* rama) -> Nodo* {
+        if constexpr (ConFiltro) {
+            if (rama != nullptr && !solapaFiltro(rama, *filtro)) {
+                if constexpr (ConStats) stats->subarbolesPodados++;
+                return nullptr;
+            }
+        }
+        return rama;
+    };
+
+    TraversalStack<Pendiente> pila;
+    if (filtrarRama(raiz)) pila.push({raiz, 0, Distancia(0)});
+
+    while (!pila.empty()) {
+        Pendiente actual = pila.pop();
+        if (descartar(actual.distanciaPlano)) continue;
+
+        Nodo* nodo = actual.nodo;
+        int profundidad = actual.profundidad;
+        recorrerNiveles(profundidad % D, [&](auto E) {
+            constexpr std::size_t eje = decltype(E)::value;
+            if constexpr (Aprox) {
+                if (aprox->restantes == 0) {
+                    aprox->informe.exacto = false;
+                    return false;
+                }
+                aprox->restantes--;
+                aprox->informe.nodosVisitados++;
+            }
+            if constexpr (ConStats) {
+                contarVisita(stats, profundidad);
+                stats->distancias++;
+            }
+            // Paso 1: Calcular la distancia al cuadrado del nodo actual al objetivo
+            Distancia distSq = distanciaCuadrado(objetivo, nodo->punto);
+
+            // Paso 2: Intentar agregar el punto actual a la lista de candidatos
+            // Mantenemos un max-heap de tamaño k (el mayor está en pq.front())
+            if (nodo->borrado || (ConFiltro && !cumpleFiltro(nodo, *filtro))) {
+                // lapida o fuera del filtro: solo sirve para guiar el descenso
+            } else if (pq.size() < (std::size_t)k) {
+                pq.push_back({distSq, nodo});
+                std::push_heap(pq.begin(), pq.end(), menorDistancia);
+            } else if (distSq < pq.front().first) {
+                std::pop_heap(pq.begin(), pq.end(), menorDistancia);
+                pq.back() = {distSq, nodo};
+                std::push_heap(pq.begin(), pq.end(), menorDistancia);
+            }
+
+            Distancia diff = diferencia(objetivo[eje], nodo->punto[eje]);
+            Nodo* ramaCercana = filtrarRama((diff < 0) ? nodo->izquierdo : nodo->derecho);
+            Nodo* ramaLejana = filtrarRama((diff < 0) ? nodo->derecho : nodo->izquierdo);
+
+            // Poda: la rama lejana solo puede aportar si su cota (plano o caja) < peor candidato
+            if (ramaLejana != nullptr) {
+                Distancia cota = ConCajas ? distanciaCaja(objetivo, ramaLejana->caja) : diff * diff;
+                if constexpr (ConStats && ConCajas) stats->distancias++;
+                if (!descartar(cota)) pila.push({ramaLejana, profundidad + 1, cota});
+            }
+
+            if constexpr (ConStats && ConCajas) stats->distancias += (ramaCercana != nullptr);
+            if (ConCajas && ramaCercana != nullptr &&
+                descartar(distanciaCaja(objetivo, ramaCercana->caja))) {
+                return false;
+            }
+            nodo = ramaCercana;
+            profundidad++;
+            return nodo != nullptr;
+        });
+    }
+}
+
+template <class T, std::size_t D>
+template <bool ConStats, bool ConFiltro>
+void KDTreeND<T, D>::kNearestSearch(const Punto& objetivo, int k, std::vector<Candidato>& pq,
+                                    QueryStats* stats, const FiltroAtributo* filtro) const {
+    pq.clear();
+    if (podaConCajas) {
+        busquedaKVecinos<true, false, ConStats, ConFiltro>(root, objetivo, k, pq, nullptr, stats, filtro);
+    } else {
+        busquedaKVecinos<false, false, ConStats, ConFiltro>(root, objetivo, k, pq, nullptr, stats, filtro);
+    }
+    std::sort_heap(pq.begin(), pq.end(), menorDistancia);
+}
+
+template <class T, std::size_t D>
+std::size_t KDTreeND<T, D>::kNearestInto(const Punto& objetivo, int k,
+                                         std::vector<Candidato>& pq, Punto* salida) const {
+    if (root == nullptr || k <= 0) return 0;
+
+    kNearestSearch(objetivo, k, pq);
+    for (std::size_t i = 0; i < pq.size(); i++) {
+        salida[i] = pq[i].second->punto;
+    }
+    return pq.size();
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::kNearest(const Punto& objetivo, int k) const -> std::vector<Punto> {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::KNearest);
+    std::vector<Punto> resultado;
+    if (root == nullptr || k <= 0) return resultado;
+
+    std::vector<Candidato> pq;
+    pq.reserve(k);  // Optimización: pre-reservar espacio
+
+    resultado.resize(std::min(size(), (std::size_t)k));
+    kNearestInto(objetivo, k, pq, resultado.data());
+    return resultado;
+}
+
+template <class T, std::size_t D>
+std::vector<std::uint32_t> KDTreeND<T, D>::kNearestIds(const Punto& objetivo, int k) const {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::KNearest);
+    std::vector<std::uint32_t> resultado;
+    if (root == nullptr || k <= 0) return resultado;
+
+    std::vector<Candidato> pq;
+    pq.reserve(k);
+    kNearestSearch(objetivo, k, pq);
+    resultado.reserve(pq.size());
+    for (const Candidato& c : pq) resultado.push_back(c.second->id);
+    return resultado;
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::kNearest(const Punto& objetivo, int k, QueryStats* stats) const
+    -> std::vector<Punto> {
+    if (stats == nullptr) return kNearest(objetivo, k);
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::KNearest);
+    std::vector<Punto> resultado;
+    if (root == nullptr || k <= 0) return resultado;
+
+    std::vector<Candidato> pq;
+    pq.reserve(k);
+    kNearestSearch<true>(objetivo, k, pq, stats);
+    resultado.reserve(pq.size());
+    for (const Candidato& c : pq) resultado.push_back(c.second->punto);
+    return resultado;
+}
+
+// ============ CONSULTAS FILTRADAS POR ATRIBUTO
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::vecinoFiltrado(const Punto& objetivo, const FiltroAtributo& filtro) const -> Nodo* {
+    if (podaConCajas) {
+        return vecinoMasCercano<true, false, false, true>(root, objetivo, nullptr, nullptr, &filtro);
+    }
+    return vecinoMasCercano<false, false, false, true>(root, objetivo, nullptr, nullptr, &filtro);
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::nearest(const Punto& objetivo, const FiltroAtributo& filtro) const -> Punto {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::Nearest);
+    Nodo* resultado = vecinoFiltrado(objetivo, filtro);
+    return resultado ? resultado->punto : Punto{};
+}
+
+template <class T, std::size_t D>
+std::uint32_t KDTreeND<T, D>::nearestId(const Punto& objetivo, const FiltroAtributo& filtro) const {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::Nearest);
+    Nodo* resultado = vecinoFiltrado(objetivo, filtro);
+    return resultado ? resultado->id : SIN_ID;
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::kNearest(const Punto& objetivo, int k, const FiltroAtributo& filtro) const
+    -> std::vector<Punto> {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::KNearest);
+    std::vector<Punto> resultado;
+    if (root == nullptr || k <= 0) return resultado;
+
+    std::vector<Candidato> pq;
+    pq.reserve(k);
+    kNearestSearch<false, true>(objetivo, k, pq, nullptr, &filtro);
+    resultado.reserve(pq.size());
+    for (const Candidato& c : pq) resultado.push_back(c.second->punto);
+    return resultado;
+}
+
+template <class T, std::size_t D>
+std::vector<std::uint32_t> KDTreeND<T, D>::kNearestIds(const Punto& objetivo, int k,
+                                                       const FiltroAtributo& filtro) const {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::KNearest);
+    std::vector<std::uint32_t> resultado;
+    if (root == nullptr || k <= 0) return resultado;
+
+    std::vector<Candidato> pq;
+    pq.reserve(k);
+    kNearestSearch<false, true>(objetivo, k, pq, nullptr, &filtro);
+    resultado.reserve(pq.size());
+    for (const Candidato& c : pq) resultado.push_back(c.second->id);
+    return resultado;
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::rangeSearch(const Caja& rectangulo, const FiltroAtributo& filtro) const
+    -> std::vector<Punto> {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::RangeSearch);
+    std::vector<Punto> resultado;
+    auto emitir = [&resultado](const Nodo* nodo) {
+        resultado.push_back(nodo->punto);
+        return true;
+    };
+    if (podaConCajas) busquedaRango<true, false, true>(root, rectangulo, emitir, nullptr, &filtro);
+    else busquedaRango<false, false, true>(root, rectangulo, emitir, nullptr, &filtro);
+    return resultado;
+}
+
+template <class T, std::size_t D>
+std::vector<std::uint32_t> KDTreeND<T, D>::rangeSearchIds(const Caja& rectangulo,
+                                                          const FiltroAtributo& filtro) const {
+    MedicionLatencia medicion(latencias.get(), OperacionConsulta::RangeSearch);
+    std::vector<std::uint32_t> resultado;
+    auto emitir = [&resultado](const Nodo* nodo) {
+        resultado.push_back(nodo->id);
+        return true;
+    };
+    if (podaConCajas) busquedaRango<true, false, true>(root, rectangulo, emitir, nullptr, &filtro);
+    else busquedaRango<false, false, true>(root, rectangulo, emitir, nullptr, &filtro);
+    return resultado;
+}
+
+template <class T, std::size_t D>
+auto KDTreeND<T, D>::kNearestApprox(const Punto& objetivo, int k, float epsilon, std::size_t maxNodos,
+                                    InformeAproximado* informe) const -> std::vector<Punto> {
+    std::vector<Punto> resultado;
+    EstadoAprox aprox = estadoAprox(epsilon, maxNodos);
+    if (root != nullptr && k > 0) {
+        std::vector<Candidato> pq;
+        pq.reserve(k);
+        if (podaConCajas) busquedaKVecinos<true, true>(root, objetivo, k, pq, &aprox);
+        else busquedaKVecinos<false, true>(root, objetivo, k, pq, &aprox);
+        std::sort_heap(pq.begin(), pq.end(), menorDistancia);
+        resultado.reserve(pq.size());
+        for (const Candidato& c : pq) resultado.push_back(c.second->punto);
+    }
+    if (informe) *informe = aprox.informe;
+    return resultado;
+}
+
+// ============ CONSULTAS POR LOTES
+// Las consultas se ordenan por su indice en la curva de Hilbert (cuantizado a
+// 16 bits por eje dentro de la caja envolvente del lote, sobre los ejes 0 y 1)
+// y el orden resultante se reparte en bloques contiguos entre los hilos del pool.
+// Indice de Hilbert de (x, y) en una rejilla de 2^16 x 2^16
+template <class T, std::size_t D>
+std::uint32_t KDTreeND<T, D>::indiceHilbert(std::uint32_t x, std::uint32_t y) {
+    std::uint32_t d = 0;
+    for (std::uint32_t s = 1u << 15; s > 0; s >>= 1) {
+        std::uint32_t rx = (x & s) ? 1 : 0;
+        std::uint32_t ry = (y & s) ? 1 : 0;
+        d += s * s * ((3 * rx) ^ ry);
+        // Rotar el cuadrante para que la curva sea continua
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - x;
+                y = s - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// Devuelve la permutacion de [0, n) que recorre las consultas en orden de Hilbert
+// (en 1D, en orden de la coordenada)
+template <class T, std::size_t D>
+std::vector<std::uint32_t> KDTreeND<T, D>::ordenHilbert(const Punto* consultas, std::size_t n) {
+    constexpr std::size_t EJE_Y = (D > 1) ? 1 : 0;
+    // La caja se calcula solo con coordenadas finitas; NaN e infinitos van a la
+    // celda 0 (convertirlos a entero no esta definido) y el resto se satura a 16 bits
+    double xmin = std::numeric_limits<double>::infinity(), xmax = -xmin;
+    double ymin = xmin, ymax = -xmin;
+    for (std::size_t i = 0; i < n; i++) {
+        double x = (double)consultas[i][0], y = (double)consultas[i][EJE_Y];
+        if (std::isfinite(x)) {
+            xmin = std::min(xmin, x);
+            xmax = std::max(xmax, x);
+        }
+        if (std::isfinite(y)) {
+            ymin = std::min(ymin, y);
+            ymax = std::max(ymax, y);
+        }
+    }
+    double escalaX = (xmax > xmin) ? 65535.0 / (xmax - xmin) : 0.0;
+    double escalaY = (ymax > ymin) ? 65535.0 / (ymax - ymin) : 0.0;
+    auto cuantizar = [](double valor, double minimo, double escala) -> std::uint32_t {
+        if (!std::isfinite(valor)) return 0;
+        return (std::uint32_t)std::min(std::max((valor - minimo) * escala, 0.0), 65535.0);
+    };
+
+    // Clave en los 32 bits altos, indice original en los bajos
+    std::vector<std::uint64_t> claves(n), auxiliar(n);
+    for (std::size_t i = 0; i < n; i++) {
+        std::uint32_t cx = cuantizar((double)consultas[i][0], xmin, escalaX);
+        std::uint32_t cy = cuantizar((double)consultas[i][EJE_Y], ymin, escalaY);
+        std::uint32_t clave = (D > 1) ? indiceHilbert(cx, cy) : cx;
+        claves[i] = ((std::uint64_t)clave << 32) | (std::uint64_t)i;
+    }
+
+    // Radix sort LSD de la clave en dos pasadas de 16 bits: O(n)
+    std::vector<std::size_t> cuenta(1 << 16);
+    for (int desplazamiento = 32; desplazamiento < 64; desplazamiento += 16) {
+        std::fill(cuenta.begin(), cuenta.end(), 0);
+        for (std::uint64_t c : claves) cuenta[(c >> desplazamiento) & 0xFFFF]++;
+        std::size_t acumulado = 0;
+        for (std::size_t& c : cuenta) {
+            std::size_t actual = c;
+            c = acumulado;
+            acumulado += actual;
+        }
+        for (std::uint64_t c : claves) auxiliar[cuenta[(c >> desplazamiento) & 0xFFFF]++] = c;
+        claves.swap(auxiliar);
+    }
+
+    std::vector<std::uint32_t> orden(n);
+    for (std::size_t i = 0; i < n; i++) orden[i] = (std::uint32_t)claves[i];
+    return orden;
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::nearestBatch(const Punto* consultas, std::size_t n, Punto* salida,
+                                  ThreadPool& pool) const {
+    std::vector<std::uint32_t> orden = ordenHilbert(consultas, n);
+    pool.parallelFor(n, BLOQUE_LOTE, [&](std::size_t inicio, std::size_t fin) {
+        for (std::size_t i = inicio; i < fin; i++) {
+            std::uint32_t original = orden[i];
+            salida[original] = nearest(consultas[original]);
+        }
+    });
+}
+
+template <class T, std::size_t D>
+void KDTreeND<T, D>::nearestBatch(const Punto* consultas, std::size_t n, Punto* salida,
+                                  unsigned hilos) const {
+    ThreadPool pool(hilos);
+    nearestBatch(consultas, n, salida, pool);
+}
+
+template <class T, std::size_t D>
+std::size_t KDTreeND<T, D>::kNearestBatch(const Punto* consultas, std::size_t n, int k,
+                                          Punto* salida, ThreadPool& pool) const {
+    if (root == nullptr || k <= 0) return 0;
+
+    std::vector<std::uint32_t> orden = ordenHilbert(consultas, n);
+    pool.parallelFor(n, BLOQUE_LOTE, [&](std::size_t inicio, std::size_t fin) {
+        std::vector<Candidato> pq;  // un heap por bloque, sin realocar
+        pq.reserve(k);
+        for (std::size_t i = inicio; i < fin; i++) {
+            std::uint32_t original = orden[i];
+            MedicionLatencia medicion(latencias.get(), OperacionConsulta::KNearest);
+            kNearestInto(consultas[original], k, pq, salida + (std::size_t)original * k);
+        }
+    });
+    return std::min(size(), (std::size_t)k);
+}
+
+template <class T, std::size_t D>
+std::size_t KDTreeND<T, D>::kNearestBatch(const Punto* consultas, std::size_t n, int k,
+                                          Punto* salida, unsigned hilos) const {
+    ThreadPool pool(hilos);
+    return kNearestBatch(consultas, n, k, salida, pool);
+}
+
+// ============ HISTOGRAMAS DE LATENCIA
+template <class T, std::size_t D>
+void KDTreeND<T, D>::setLatencyHistograms(bool activar) {
+    if (!activar) latencias.reset();
+    else if (!latencias) latencias = std::make_unique<LatencyRecorder>();
+}
@@ -0,0 +1,230 @@
+#include "LatencyHistogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+using namespace std;
+
+const char* nombreOperacion(OperacionConsulta operacion) {
+    switch (operacion) {
+        case OperacionConsulta::Nearest: return "nearest";
+        case OperacionConsulta::KNearest: return "kNearest";
+        case OperacionConsulta::RangeSearch: return "rangeSearch";
+        case OperacionConsulta::Insert: return "insert";
+        case OperacionConsulta::Remove: return "remove";
+    }
+    return "?";
+}
+
+// ============ HISTOGRAMA
+static int log2Entero(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int k = 0;
+    while (v >>= 1) k++;
+    return k;
+#endif
+}
+
+// v < 32: cubeta v. Si no, con k = floor(log2 v), los BITS_SUBCUBETA bits
+// siguientes al mas alto eligen una de las 32 cubetas de [2^k, 2^(k+1))
+size_t LatencyHistogram::cubeta(uint64_t ns) {
+    if (ns < SUBCUBETAS) return (size_t)ns;
+    int k = log2Entero(ns);
+    if (k > EXPONENTE_MAXIMO) return NUM_CUBETAS - 1;
+    int desplazamiento = k - BITS_SUBCUBETA;
+    return (size_t)(SUBCUBETAS + (uint64_t)desplazamiento * SUBCUBETAS + ((ns >> desplazamiento) - SUBCUBETAS));
+}
+
+uint64_t LatencyHistogram::limiteSuperior(size_t cubeta) {
+    if (cubeta < SUBCUBETAS) return cubeta;
+    uint64_t desplazamiento = (cubeta - SUBCUBETAS) / SUBCUBETAS;
+    uint64_t inferior = (SUBCUBETAS + cubeta % SUBCUBETAS) << desplazamiento;
+    return inferior + (uint64_t(1) << desplazamiento) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    cuentas[cubeta(ns)]++;
+    minimo = total ? std::min(minimo, ns) : ns;
+    maximo = std::max(maximo, ns);
+    suma += ns;
+    total++;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& otro) {
+    if (otro.total == 0) return;
+    for (size_t i = 0; i < NUM_CUBETAS; i++) cuentas[i] += otro.cuentas[i];
+    minimo = total ? std::min(minimo, otro.minimo) : otro.minimo;
+    maximo = std::max(maximo, otro.maximo);
+    suma += otro.suma;
+    total += otro.total;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+    p = std::min(std::max(p, 0.0), 100.0);
+    // Rango (1..total) de la muestra buscada
+    uint64_t objetivo = std::max<uint64_t>(1, (uint64_t)std::ceil(p / 100.0 * (double)total));
+    uint64_t acumulado = 0;
+    for (size_t i = 0; i < NUM_CUBETAS; i++) {
+        acumulado += cuentas[i];
+        if (acumulado >= objetivo) return std::min(limiteSuperior(i), maximo);
+    }
+    return maximo;
+}
+
+string LatencyHistogram::toText() const {
+    char linea[256];
+    snprintf(linea, sizeof(linea),
+             "n=%llu media=%.0f min=%llu p50=%llu p90=%llu p99=%llu p999=%llu max=%llu (ns)",
+             (unsigned long long)total, mean(), (unsigned long long)min(),
+             (unsigned long long)percentile(50), (unsigned long long)percentile(90),
+             (unsigned long long)percentile(99), (unsigned long long)percentile(99.9),
+             (unsigned long long)max());
+    return linea;
+}
+
+string LatencyHistogram::toJson() const {
+    char objeto[320];
+    snprintf(objeto, sizeof(objeto),
+             "{\"n\": %llu, \"media_ns\": %.1f, \"min_ns\": %llu, \"p50_ns\": %llu, \"p90_ns\": %llu, "
+             "\"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu}",
+             (unsigned long long)total, mean(), (unsigned long long)min(),
+             (unsigned long long)percentile(50), (unsigned long long)percentile(90),
+             (unsigned long long)percentile(99), (unsigned long long)percentile(99.9),
+             (unsigned long long)max());
+    return objeto;
+}
+
+// ============ REGISTRADOR POR HILOS
+// Un solo hilo escribe en cada contador: incrementar con carga + almacenamiento
+// relajados basta y evita el prefijo lock de fetch_add. Los atomicos solo
+// sirven para que snapshot() lea sin carrera de datos.
+struct LatencyRecorder::Fragmento {
+    struct Contadores {
+        atomic<uint64_t> cuentas[LatencyHistogram::NUM_CUBETAS];
+        atomic<uint64_t> total, suma, minimo, maximo;
+    };
+
+    thread::id hilo;
+    Fragmento* siguiente;
+    Contadores operaciones[NUM_OPERACIONES];
+};
+
+static atomic<uint64_t> siguienteIdent{1};
+
+// Ultimo registrador usado por el hilo y su fragmento. Los ident no se
+// reutilizan: una entrada de un registrador ya destruido nunca coincide.
+// Un hilo nuevo con el id de uno terminado hereda su fragmento: sigue
+// habiendo un solo escritor.
+struct CacheHilo {
+    uint64_t registrador = 0;
+    void* fragmento = nullptr;
+};
+static thread_local CacheHilo cacheHilo;
+
+LatencyRecorder::LatencyRecorder() : ident(siguienteIdent.fetch_add(1, memory_order_relaxed)) {}
+
+LatencyRecorder::~LatencyRecorder() {
+    Fragmento* fragmento = fragmentos.load(memory_order_acquire);
+    while (fragmento) {
+        Fragmento* siguiente = fragmento->siguiente;
+        delete fragmento;
+        fragmento = siguiente;
+    }
+}
+
+auto LatencyRecorder::fragmentoDelHilo() -> Fragmento* {
+    if (cacheHilo.registrador == ident) return static_cast<Fragmento*>(cacheHilo.fragmento);
+
+    // Fallo de cache: el fragmento del hilo puede existir ya (el hilo alterna
+    // entre arboles); si no, se crea y se enlaza en cabeza
+    thread::id yo = this_thread::get_id();
+    Fragmento* propio = nullptr;
+    for (Fragmento* f = fragmentos.load(memory_order_acquire); f && !propio; f = f->siguiente) {
+        if (f->hilo == yo) propio = f;
+    }
+    if (!propio) {
+        propio = new Fragmento();  // inicializacion por valor: contadores a cero
+        propio->hilo = yo;
+        propio->siguiente = fragmentos.load(memory_order_relaxed);
+        while (!fragmentos.compare_exchange_weak(propio->siguiente, propio, memory_order_release,
+                                                 memory_order_relaxed)) {
+        }
+    }
+    cacheHilo = {ident, propio};
+    return propio;
+}
+
+void LatencyRecorder::record(OperacionConsulta operacion, uint64_t ns) {
+    Fragmento::Contadores& c = fragmentoDelHilo()->operaciones[(size_t)operacion];
+    auto sumar = [](atomic<uint64_t>& contador, uint64_t valor) {
+        contador.store(contador.load(memory_order_relaxed) + valor, memory_order_relaxed);
+    };
+    uint64_t total = c.total.load(memory_order_relaxed);
+    sumar(c.cuentas[LatencyHistogram::cubeta(ns)], 1);
+    if (total == 0 || ns < c.minimo.load(memory_order_relaxed)) c.minimo.store(ns, memory_order_relaxed);
+    if (ns > c.maximo.load(memory_order_relaxed)) c.maximo.store(ns, memory_order_relaxed);
+    sumar(c.suma, ns);
+    c.total.store(total + 1, memory_order_relaxed);
+}
+
+LatencyHistogram LatencyRecorder::snapshot(OperacionConsulta operacion) const {
+    LatencyHistogram resultado;
+    for (Fragmento* f = fragmentos.load(memory_order_acquire); f; f = f->siguiente) {
+        const Fragmento::Contadores& c = f->operaciones[(size_t)operacion];
+        LatencyHistogram parcial;
+        for (size_t i = 0; i < LatencyHistogram::NUM_CUBETAS; i++) {
+            parcial.cuentas[i] = c.cuentas[i].load(memory_order_relaxed);
+            parcial.total += parcial.cuentas[i];
+        }
+        // total se recalcula de las cubetas: coherente con los percentiles
+        // aunque el hilo este registrando
+        parcial.suma = c.suma.load(memory_order_relaxed);
+        parcial.minimo = c.minimo.load(memory_order_relaxed);
+        parcial.maximo = c.maximo.load(memory_order_relaxed);
+        resultado.merge(parcial);
+    }
+    return resultado;
+}
+
+void LatencyRecorder::reset() {
+    for (Fragmento* f = fragmentos.load(memory_order_acquire); f; f = f->siguiente) {
+        for (Fragmento::Contadores& c : f->operaciones) {
+            for (atomic<uint64_t>& cuenta : c.cuentas) cuenta.store(0, memory_order_relaxed);
+            c.total.store(0, memory_order_relaxed);
+            c.suma.store(0, memory_order_relaxed);
+            c.minimo.store(0, memory_order_relaxed);
+            c.maximo.store(0, memory_order_relaxed);
+        }
+    }
+}
+
+size_t LatencyRecorder::threads() const {
+    size_t cuenta = 0;
+    for (Fragmento* f = fragmentos.load(memory_order_acquire); f; f = f->siguiente) cuenta++;
+    return cuenta;
+}
+
+string LatencyRecorder::toText() const {
+    string texto;
+    for (size_t i = 0; i < NUM_OPERACIONES; i++) {
+        OperacionConsulta operacion = (OperacionConsulta)i;
+        LatencyHistogram h = snapshot(operacion);
+        if (h.count() == 0) continue;
+        char nombre[32];
+        snprintf(nombre, sizeof(nombre), "%-12s ", nombreOperacion(operacion));
+        texto += nombre + h.toText() + "\n";
+    }
+    return texto;
+}
+
+string LatencyRecorder::toJson() const {
+    string json = "{";
+    for (size_t i = 0; i < NUM_OPERACIONES; i++) {
+        OperacionConsulta operacion = (OperacionConsulta)i;
+        json += (i ? ", \"" : "\"") + string(nombreOperacion(operacion)) + "\": " + snapshot(operacion).toJson();
+    }
+    return json + "}";
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Operaciones del arbol con histograma de latencia propio
+enum class OperacionConsulta { Nearest, KNearest, RangeSearch, Insert, Remove };
+constexpr std::size_t NUM_OPERACIONES = 5;
+const char* nombreOperacion(OperacionConsulta operacion);
+
+// Histograma de latencias en nanosegundos con cubetas log-lineales (estilo
+// HDR): los valores < 32 son exactos y por encima cada potencia de dos se
+// divide en 32 cubetas, asi el error relativo es <= 1/32 (~3%) hasta 2^41 ns
+// (~36 min; los mayores caen en la ultima cubeta). Copiable y combinable con
+// merge; no admite escrituras concurrentes (ver LatencyRecorder).
+class LatencyHistogram {
+public:
+    static constexpr int BITS_SUBCUBETA = 5;
+    static constexpr std::uint64_t SUBCUBETAS = 1u << BITS_SUBCUBETA;
+    static constexpr int EXPONENTE_MAXIMO = 40;
+    static constexpr std::size_t NUM_CUBETAS = SUBCUBETAS * (EXPONENTE_MAXIMO - BITS_SUBCUBETA + 2);
+
+    void record(std::uint64_t ns);
+    void merge(const LatencyHistogram& otro);
+    void clear() { *this = LatencyHistogram(); }
+
+    std::uint64_t count() const { return total; }
+    std::uint64_t min() const { return total ? minimo : 0; }
+    std::uint64_t max() const { return maximo; }
+    double mean() const { return total ? (double)suma / total : 0.0; }
+    // Menor cota de cubeta que deja al menos el p% (0..100) de las muestras
+    // por debajo o en ella; nunca mayor que max()
+    std::uint64_t percentile(double p) const;
+
+    // Cuenta, media, min, p50, p90, p99, p999 y max: una linea de texto / un objeto JSON
+    std::string toText() const;
+    std::string toJson() const;
+
+    // Cubeta de un valor y mayor valor que cae en ella
+    static std::size_t cubeta(std::uint64_t ns);
+    static std::uint64_t limiteSuperior(std::size_t cubeta);
+    std::uint64_t cuenta(std::size_t cubeta) const { return cuentas[cubeta]; }
+
+private:
+    friend class LatencyRecorder;
+
+    std::array<std::uint64_t, NUM_CUBETAS> cuentas{};
+    std::uint64_t total = 0;
+    std::uint64_t suma = 0;
+    std::uint64_t minimo = 0;
+    std::uint64_t maximo = 0;
+};
+
+// Histogramas de latencia de un arbol: uno por operacion y por hilo. Cada
+// hilo escribe solo en su fragmento, con cargas y almacenamientos relajados
+// (ni cerrojos ni lectura-modificacion-escritura atomica), y snapshot()
+// combina todos los fragmentos bajo demanda. El primer registro de un hilo
+// enlaza su fragmento con CAS en una lista que vive lo que el registrador.
+class LatencyRecorder {
+public:
+    LatencyRecorder();
+    ~LatencyRecorder();
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+    void record(OperacionConsulta operacion, std::uint64_t ns);
+
+    // Combinacion de todos los hilos. Con registros en curso cada cubeta es
+    // exacta, pero el conjunto puede no corresponder a un mismo instante.
+    LatencyHistogram snapshot(OperacionConsulta operacion) const;
+    // Pone los contadores a cero; un registro simultaneo puede sobrevivir
+    void reset();
+    // Hilos que han registrado alguna vez
+    std::size_t threads() const;
+
+    // Operaciones con muestras, una por linea / objeto JSON con una clave por operacion
+    std::string toText() const;
+    std::string toJson() const;
+
+private:
+    struct Fragmento;
+    Fragmento* fragmentoDelHilo();
+
+    std::atomic<Fragmento*> fragmentos{nullptr};
+    const std::uint64_t ident;  // unico por registrador: clave de la cache de cada hilo
+};
+
+// Mide su propio tiempo de vida y lo registra al destruirse; sin registrador
+// no lee el reloj
+class MedicionLatencia {
+public:
+    MedicionLatencia(LatencyRecorder* registrador, OperacionConsulta operacion)
+        : registrador(registrador), operacion(operacion) {
+        if (registrador) inicio = std::chrono::steady_clock::now();
+    }
+    ~MedicionLatencia() {
+        if (registrador) {
+            auto duracion = std::chrono::steady_clock::now() - inicio;
+            registrador->record(operacion,
+                                (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duracion).count());
+        }
+    }
+    MedicionLatencia(const MedicionLatencia&) = delete;
+    MedicionLatencia& operator=(const MedicionLatencia&) = delete;
+
+private:
+    LatencyRecorder* registrador;
+    OperacionConsulta operacion;
+    std::chrono::steady_clock::time_point inicio;
+};
@@ -0,0 +1,75 @@
+#include "MappedFile.h"
+#include <cstdio>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define KD_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+#ifdef KD_MMAP
+bool MappedFile::open(const string& ruta) {
+    close();
+    int descriptor = ::open(ruta.c_str(), O_RDONLY);
+    if (descriptor < 0) return false;
+    struct stat info;
+    if (fstat(descriptor, &info) != 0) {
+        ::close(descriptor);
+        return false;
+    }
+    size_t bytes = (size_t)info.st_size;
+    // mmap no admite longitud 0: un archivo vacio se representa sin region
+    // propia, pero abierto
+    if (bytes == 0) {
+        ::close(descriptor);
+        static const char vacio = 0;
+        region = shared_ptr<const char>(&vacio, [](const char*) {});
+        return true;
+    }
+    void* base = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);  // el mapeo sigue valido sin el descriptor
+    if (base == MAP_FAILED) return false;
+    region = shared_ptr<const char>(static_cast<const char*>(base),
+                                    [bytes](const char* p) { munmap((void*)p, bytes); });
+    longitud = bytes;
+    return true;
+}
+
+void MappedFile::adviseSequential() const {
+    if (longitud > 0) madvise((void*)region.get(), longitud, MADV_SEQUENTIAL);
+}
+
+void MappedFile::discard(size_t desde, size_t bytes) const {
+    if (desde >= longitud) return;
+    bytes = min(bytes, longitud - desde);
+    // madvise exige direcciones alineadas a pagina: solo las paginas completas
+    const size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+    size_t inicio = (desde + pagina - 1) / pagina * pagina;
+    size_t fin = (desde + bytes) / pagina * pagina;
+    if (desde + bytes == longitud) fin = longitud;  // la ultima pagina puede ser parcial
+    if (fin > inicio) madvise((void*)(region.get() + inicio), fin - inicio, MADV_DONTNEED);
+}
+#else
+bool MappedFile::open(const string& ruta) {
+    close();
+    FILE* archivo = fopen(ruta.c_str(), "rb");
+    if (!archivo) return false;
+    auto contenido = make_shared<vector<char>>();
+    char bloque[1 << 16];
+    size_t leidos;
+    while ((leidos = fread(bloque, 1, sizeof(bloque), archivo)) > 0)
+        contenido->insert(contenido->end(), bloque, bloque + leidos);
+    fclose(archivo);
+    longitud = contenido->size();
+    contenido->push_back(0);  // data() nunca es nulo, ni con el archivo vacio
+    region = shared_ptr<const char>(contenido, contenido->data());
+    return true;
+}
+
+void MappedFile::adviseSequential() const {}
+void MappedFile::discard(size_t, size_t) const {}
+#endif
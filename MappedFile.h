@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+// Archivo de solo lectura mapeado en memoria (mmap). Sin mmap en la
+// plataforma el archivo se lee entero a memoria propia con la misma interfaz.
+// Las copias comparten la region; se desmapea al soltar la ultima.
+class MappedFile {
+public:
+    // false si el archivo no existe o no se puede mapear
+    bool open(const std::string& ruta);
+    void close() { region.reset(); longitud = 0; }
+
+    bool isOpen() const { return region != nullptr; }
+    const char* data() const { return region.get(); }
+    std::size_t size() const { return longitud; }
+
+    // Avisos al sistema (sin efecto sin mmap):
+    //  - adviseSequential: se leera en orden, lectura anticipada agresiva
+    //  - discard: [desde, desde + bytes) ya no se leera; sus paginas dejan de
+    //    contar como residentes (las completas dentro del rango)
+    void adviseSequential() const;
+    void discard(std::size_t desde, std::size_t bytes) const;
+
+private:
+    std::shared_ptr<const char> region;
+    std::size_t longitud = 0;
+};
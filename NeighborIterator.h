@@ -0,0 +1,129 @@
+#pragma once
+#include "KDTreeND.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Vecinos en orden de distancia, de uno en uno y sin fijar k (busqueda
+// "best-first" incremental de Hjaltason y Samet).
+//
+// Un heap de minimos guarda subarboles, con la distancia del objetivo a su
+// caja envolvente como clave, y puntos ya evaluados, con su distancia. Sacar
+// un subarbol evalua su punto y mete sus dos hijos; sacar un punto lo entrega:
+// ningun elemento pendiente puede estar mas cerca (la caja de un subarbol
+// acota por debajo a todos sus puntos). Cada next() cuesta O(log n)
+// amortizado en un arbol balanceado y continua donde lo dejo el anterior; el
+// k-esimo vecino cuesta lo mismo que kNearest(k), sin repetir el recorrido
+// cuando despues hacen falta mas.
+//
+// El iterador apunta a los nodos del arbol: modificar el arbol (insert,
+// remove, build...) lo invalida. Con un snapshot de PersistentKDTree sirve la
+// raiz del snapshot mientras este viva.
+template <class T, std::size_t D>
+class NeighborIteratorND {
+    using Arbol = KDTreeND<T, D>;
+
+public:
+    using Punto = typename Arbol::Punto;
+    using Nodo = typename Arbol::Nodo;
+    using Distancia = typename Arbol::Distancia;
+
+    NeighborIteratorND(const Arbol& arbol, const Punto& objetivo)
+        : NeighborIteratorND(arbol.getRoot(), objetivo) {}
+    // Sobre un subarbol cualquiera (p. ej. Snapshot::getRoot())
+    NeighborIteratorND(const Nodo* raiz, const Punto& objetivo) : objetivo(objetivo) {
+        if (raiz && raiz->tamano > raiz->muertos) {
+            meter({Arbol::distanciaCaja(objetivo, raiz->caja), raiz, false});
+        }
+    }
+
+    // Avanza al siguiente vecino mas cercano; false cuando ya se entregaron todos
+    bool next();
+
+    // Vecino actual (validos tras un next() que devolvio true). Con distancias
+    // iguales el orden entre ellos no esta definido.
+    const Punto& point() const { return actual->punto; }
+    std::uint32_t id() const { return actual->id; }
+    Distancia distanceSquared() const { return distanciaActual; }
+
+    // Vecinos entregados hasta ahora
+    std::size_t count() const { return entregados; }
+
+private:
+    struct Entrada {
+        Distancia clave;
+        const Nodo* nodo;
+        bool esPunto;  // el punto del nodo, no su subarbol
+    };
+    // Orden del heap de minimos: a igual clave, los puntos salen antes que los subarboles
+    static bool despues(const Entrada& a, const Entrada& b) {
+        return a.clave > b.clave || (a.clave == b.clave && a.esPunto < b.esPunto);
+    }
+    void meter(const Entrada& entrada) {
+        heap.push_back(entrada);
+        std::push_heap(heap.begin(), heap.end(), despues);
+    }
+
+    Punto objetivo;
+    std::vector<Entrada> heap;
+    const Nodo* actual = nullptr;
+    Distancia distanciaActual = 0;
+    std::size_t entregados = 0;
+};
+
+// Meter en el heap y sacar enseguida es lo mismo que procesar directamente
+// cuando nada en el heap va antes: asi el descenso hacia el objetivo (la
+// rama mas cercana de cada nodo) no paga operaciones de heap.
+template <class T, std::size_t D>
+bool NeighborIteratorND<T, D>::next() {
+    Entrada siguiente;
+    bool pendiente = false;  // siguiente ya elegido sin pasar por el heap
+    while (pendiente || !heap.empty()) {
+        if (!pendiente) {
+            std::pop_heap(heap.begin(), heap.end(), despues);
+            siguiente = heap.back();
+            heap.pop_back();
+        }
+        pendiente = false;
+
+        if (siguiente.esPunto) {
+            actual = siguiente.nodo;
+            distanciaActual = siguiente.clave;
+            entregados++;
+            return true;
+        }
+
+        // Subarbol: sus hijos con algun punto vivo y su punto (si esta vivo)
+        const Nodo* nodo = siguiente.nodo;
+        Entrada candidatas[3];
+        int cuantas = 0;
+        for (const Nodo* hijo : {nodo->izquierdo, nodo->derecho}) {
+            if (hijo && hijo->tamano > hijo->muertos) {
+                candidatas[cuantas++] = {Arbol::distanciaCaja(objetivo, hijo->caja), hijo, false};
+            }
+        }
+        if (!nodo->borrado) {
+            candidatas[cuantas++] = {Arbol::distanciaCuadrado(objetivo, nodo->punto), nodo, true};
+        }
+        if (cuantas == 0) continue;
+
+        int menor = 0;
+        for (int i = 1; i < cuantas; i++) {
+            if (despues(candidatas[menor], candidatas[i])) menor = i;
+        }
+        for (int i = 0; i < cuantas; i++) {
+            if (i != menor) meter(candidatas[i]);
+        }
+        if (heap.empty() || !despues(candidatas[menor], heap.front())) {
+            siguiente = candidatas[menor];
+            pendiente = true;
+        } else {
+            meter(candidatas[menor]);
+        }
+    }
+    actual = nullptr;
+    return false;
+}
+
+using NeighborIterator = NeighborIteratorND<float, 2>;
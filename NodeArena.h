@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Arena de nodos por bloques (slabs) propiedad del arbol.
+//  - Los nodos se reservan de forma contigua dentro de cada bloque (localidad de cache)
+//  - destroy() no devuelve memoria al sistema: la ranura va a una lista libre y
+//    la reutiliza el siguiente create()
+//  - release() libera todos los bloques de una vez sin recorrer los nodos
+//    (T es trivialmente destructible), coste proporcional al numero de bloques
+template <class T>
+class NodeArena {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "NodeArena libera bloques sin llamar destructores");
+
+    // La lista libre reutiliza la memoria de las ranuras vacias
+    struct Libre {
+        Libre* siguiente;
+    };
+    static_assert(sizeof(T) >= sizeof(Libre), "T debe poder alojar un puntero");
+
+public:
+    NodeArena() = default;
+    ~NodeArena() { release(); }
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    NodeArena(NodeArena&& otra) noexcept { robar(otra); }
+    NodeArena& operator=(NodeArena&& otra) noexcept {
+        if (this != &otra) {
+            release();
+            robar(otra);
+        }
+        return *this;
+    }
+
+    template <class... Args>
+    T* create(Args&&... args) {
+        void* memoria;
+        if (libres != nullptr) {
+            memoria = libres;
+            libres = libres->siguiente;
+        } else {
+            if (usadosBloque == capacidadBloque) nuevoBloque();
+            memoria = bloqueActual + usadosBloque++;
+        }
+        enUso++;
+        return new (memoria) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* nodo) {
+        libres = new (static_cast<void*>(nodo)) Libre{libres};
+        enUso--;
+    }
+
+    // Bloque dedicado de n ranuras consecutivas sin inicializar (construccion
+    // en bloque: el llamador hace placement-new en base[i]).
+    T* allocateContiguous(std::size_t n) {
+        if (n == 0) return nullptr;
+        T* base = reservar(n);
+        enUso += n;
+        return base;
+    }
+
+    void release() {
+        for (T* bloque : bloques) ::operator delete(static_cast<void*>(bloque));
+        bloques.clear();
+        libres = nullptr;
+        bloqueActual = nullptr;
+        usadosBloque = capacidadBloque = 0;
+        enUso = 0;
+    }
+
+    // Nodos vivos (creados y no destruidos)
+    std::size_t size() const { return enUso; }
+
+private:
+    static constexpr std::size_t BLOQUE_INICIAL = 256;
+    static constexpr std::size_t BLOQUE_MAXIMO = 1 << 16;
+
+    std::vector<T*> bloques;
+    Libre* libres = nullptr;
+    T* bloqueActual = nullptr;
+    std::size_t usadosBloque = 0;
+    std::size_t capacidadBloque = 0;
+    std::size_t enUso = 0;
+
+    T* reservar(std::size_t n) {
+        T* bloque = static_cast<T*>(::operator new(n * sizeof(T)));
+        bloques.push_back(bloque);
+        return bloque;
+    }
+
+    // Bloques crecientes (x2, hasta BLOQUE_MAXIMO) para amortizar las reservas
+    void nuevoBloque() {
+        std::size_t capacidad = (capacidadBloque == 0) ? BLOQUE_INICIAL : capacidadBloque * 2;
+        if (capacidad > BLOQUE_MAXIMO) capacidad = BLOQUE_MAXIMO;
+        bloqueActual = reservar(capacidad);
+        capacidadBloque = capacidad;
+        usadosBloque = 0;
+    }
+
+    void robar(NodeArena& otra) {
+        bloques = std::move(otra.bloques);
+        libres = std::exchange(otra.libres, nullptr);
+        bloqueActual = std::exchange(otra.bloqueActual, nullptr);
+        usadosBloque = std::exchange(otra.usadosBloque, 0);
+        capacidadBloque = std::exchange(otra.capacidadBloque, 0);
+        enUso = std::exchange(otra.enUso, 0);
+        otra.bloques.clear();
+    }
+};
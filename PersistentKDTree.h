@@ -0,0 +1,454 @@
+#pragma once
+#include "KDTreeND.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// KD-tree persistente: lecturas concurrentes sin bloqueo sobre versiones
+// inmutables (aislamiento por instantanea).
+//
+// Un nodo publicado no se modifica nunca. Cada escritura copia solo el camino
+// de la raiz al nodo que cambia (O(log n) nodos nuevos), repite sobre esas
+// copias privadas el auto-balanceo y la compactacion de KDTreeND (los
+// subarboles reconstruidos tambien son nodos nuevos) y publica la raiz nueva
+// con un store atomico. Los nodos no copiados se comparten entre versiones.
+//
+// snapshot() fija la version vigente: sus consultas ven siempre el mismo
+// arbol aunque haya escrituras en curso y no toman ningun cerrojo. Las
+// escrituras se serializan entre si con un mutex interno.
+//
+// Reclamacion por epocas: cada escritura avanza la epoca y retira los nodos
+// que dejo de enlazar con la epoca anterior como etiqueta. Un snapshot anuncia
+// en una ranura la epoca en que empezo; un nodo retirado se libera cuando
+// todas las ranuras ocupadas anuncian una epoca posterior a su etiqueta (ningun
+// snapshot vivo puede alcanzarlo). Los snapshots son de corta duracion: uno
+// olvidado retiene todos los nodos retirados desde entonces.
+//
+// Mismo criterio de balanceo (alpha = 0.75) y de borrado (lapidas, umbral de
+// compactacion 0.25) que KDTreeND por defecto; las cajas se mantienen siempre.
+template <class T, std::size_t D>
+class PersistentKDTreeND {
+    using Arbol = KDTreeND<T, D>;
+
+public:
+    using Punto = typename Arbol::Punto;
+    using Caja = typename Arbol::Caja;
+    using Nodo = typename Arbol::Nodo;
+    using Distancia = typename Arbol::Distancia;
+    static constexpr std::uint32_t SIN_ID = Arbol::SIN_ID;
+
+    // Snapshots simultaneos como maximo; snapshot() espera (yield) si estan todas ocupadas
+    static constexpr std::size_t RANURAS = 128;
+
+    // Version fijada del arbol. Movible, no copiable; al destruirse libera su ranura.
+    class Snapshot {
+    public:
+        Snapshot(Snapshot&& otro) noexcept
+            : arbol(std::exchange(otro.arbol, nullptr)), ranura(otro.ranura), raiz(otro.raiz) {}
+        Snapshot& operator=(Snapshot&& otro) noexcept {
+            if (this != &otro) {
+                soltar();
+                arbol = std::exchange(otro.arbol, nullptr);
+                ranura = otro.ranura;
+                raiz = otro.raiz;
+            }
+            return *this;
+        }
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        ~Snapshot() { soltar(); }
+
+        // Misma semantica que las consultas homonimas de KDTreeND
+        std::size_t size() const { return raiz ? raiz->tamano - raiz->muertos : 0; }
+        Nodo* getRoot() const { return raiz; }
+        Punto nearest(const Punto& objetivo) const {
+            Nodo* nodo = Arbol::template vecinoMasCercano<true>(raiz, objetivo);
+            return nodo ? nodo->punto : Punto{};
+        }
+        std::uint32_t nearestId(const Punto& objetivo) const {
+            Nodo* nodo = Arbol::template vecinoMasCercano<true>(raiz, objetivo);
+            return nodo ? nodo->id : SIN_ID;
+        }
+        std::vector<Punto> kNearest(const Punto& objetivo, int k) const {
+            std::vector<Punto> resultado;
+            for (const auto& c : candidatos(objetivo, k)) resultado.push_back(c.second->punto);
+            return resultado;
+        }
+        std::vector<std::uint32_t> kNearestIds(const Punto& objetivo, int k) const {
+            std::vector<std::uint32_t> resultado;
+            for (const auto& c : candidatos(objetivo, k)) resultado.push_back(c.second->id);
+            return resultado;
+        }
+        std::vector<Punto> rangeSearch(const Caja& rectangulo) const {
+            std::vector<Punto> resultado;
+            forEachInRange(rectangulo, [&resultado](const Punto& p) { resultado.push_back(p); });
+            return resultado;
+        }
+        std::size_t rangeCount(const Caja& rectangulo) const {
+            return Arbol::contarRango(raiz, rectangulo, true);
+        }
+        template <class F>
+        void forEachInRange(const Caja& rectangulo, F&& f) const {
+            auto emitir = [&f](const Nodo* nodo) { return Arbol::visitar(f, nodo); };
+            Arbol::template busquedaRango<true>(raiz, rectangulo, emitir);
+        }
+        template <class F>
+        void forEachInRadius(const Punto& centro, Distancia radio, F&& f) const {
+            if (radio < 0) return;
+            auto emitir = [&f](const Nodo* nodo) { return Arbol::visitar(f, nodo); };
+            Arbol::template busquedaRadio<true>(raiz, centro, radio * radio, emitir);
+        }
+
+    private:
+        friend class PersistentKDTreeND;
+        Snapshot(const PersistentKDTreeND* arbol, std::size_t ranura, Nodo* raiz)
+            : arbol(arbol), ranura(ranura), raiz(raiz) {}
+
+        void soltar() {
+            if (arbol) arbol->ranuras[ranura].epoca.store(LIBRE, std::memory_order_release);
+            arbol = nullptr;
+        }
+
+        std::vector<typename Arbol::Candidato> candidatos(const Punto& objetivo, int k) const {
+            std::vector<typename Arbol::Candidato> pq;
+            if (raiz == nullptr || k <= 0) return pq;
+            pq.reserve(k);
+            Arbol::template busquedaKVecinos<true>(raiz, objetivo, k, pq);
+            std::sort_heap(pq.begin(), pq.end(), Arbol::menorDistancia);
+            return pq;
+        }
+
+        const PersistentKDTreeND* arbol;
+        std::size_t ranura;
+        Nodo* raiz;
+    };
+
+    PersistentKDTreeND() = default;
+    explicit PersistentKDTreeND(std::vector<Punto> puntos) { build(std::move(puntos)); }
+
+    // Al destruir el arbol no debe quedar ningun snapshot vivo
+    PersistentKDTreeND(const PersistentKDTreeND&) = delete;
+    PersistentKDTreeND& operator=(const PersistentKDTreeND&) = delete;
+
+    // Lectura: fija la version vigente. Lock-free salvo con RANURAS snapshots vivos.
+    Snapshot snapshot() const;
+
+    // Escrituras (serializadas; no bloquean a los lectores). Mismos ids y atributo que KDTreeND.
+    void build(std::vector<Punto> puntos);
+    std::uint32_t insert(const Punto& punto);
+    void insert(const Punto& punto, std::uint32_t id);
+    void insert(const Punto& punto, std::uint32_t id, float atributo);
+    void remove(const Punto& punto, std::uint32_t id = SIN_ID);
+    void clear();
+
+    // Puntos de la version vigente
+    std::size_t size() const { return tamano.load(std::memory_order_acquire); }
+    std::uint64_t epoch() const { return epoca.load(std::memory_order_acquire); }
+
+    // Nodos retirados que algun snapshot vivo aun puede alcanzar. Las escrituras
+    // intentan liberarlos cada UMBRAL_RECLAMACION retiros; reclaim() lo fuerza.
+    static constexpr std::size_t UMBRAL_RECLAMACION = 1024;
+    std::size_t pendingReclamation() const;
+    void reclaim();
+
+private:
+    static constexpr std::uint64_t LIBRE = std::numeric_limits<std::uint64_t>::max();
+    static constexpr float ALPHA = Arbol::ALPHA_DEFECTO;
+    static constexpr float UMBRAL_COMPACTACION = Arbol::UMBRAL_COMPACTACION;
+
+    // Cada ranura en su propia linea de cache: los lectores no comparten lineas
+    struct alignas(64) Ranura {
+        std::atomic<std::uint64_t> epoca{LIBRE};
+    };
+
+    struct Retirado {
+        std::uint64_t epoca;
+        Nodo* nodo;
+    };
+
+    mutable Ranura ranuras[RANURAS];
+    std::atomic<Nodo*> raiz{nullptr};
+    std::atomic<std::uint64_t> epoca{0};
+    std::atomic<std::size_t> tamano{0};
+
+    // Estado del escritor (protegido por escritura)
+    mutable std::mutex escritura;
+    NodeArena<Nodo> nodos;
+    std::vector<Retirado> retirados;
+    std::uint32_t siguienteId = 0;
+    int holguraAltura = 0;
+
+    // insert() con el mutex ya tomado
+    void insertar(const Punto& punto, std::uint32_t id, float atributo);
+    // Copia privada (aun no publicada) de un nodo publicado; el original se retira
+    Nodo* copiar(Nodo* nodo);
+    void retirar(Nodo* nodo) { retirados.push_back({epoca.load(std::memory_order_relaxed), nodo}); }
+    void retirarSubarbol(Nodo* raiz);
+    // Reconstruye balanceado el subarbol *enlace (enlace privado) en nodos nuevos
+    int reconstruir(Nodo** enlace);
+    int alturaPermitida(std::size_t n) const;
+    // Publica la version cuya raiz es nueva y avanza la epoca
+    void publicar(Nodo* nueva);
+    void reclamar();
+};
+
+using PersistentKDTree = PersistentKDTreeND<float, 2>;
+
+// ============ LECTURA
+// La ranura se anuncia antes de leer la raiz (ambos seq_cst): si el escritor
+// no ve la ranura al reclamar, el lector vera la raiz publicada por el.
+template <class T, std::size_t D>
+auto PersistentKDTreeND<T, D>::snapshot() const -> Snapshot {
+    std::size_t inicio = std::hash<std::thread::id>{}(std::this_thread::get_id()) % RANURAS;
+    for (;;) {
+        for (std::size_t i = 0; i < RANURAS; i++) {
+            std::size_t r = (inicio + i) % RANURAS;
+            std::uint64_t libre = LIBRE;
+            if (ranuras[r].epoca.load(std::memory_order_relaxed) == LIBRE &&
+                ranuras[r].epoca.compare_exchange_strong(libre, epoca.load())) {
+                return Snapshot(this, r, raiz.load());
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+// ============ ESCRITURA
+template <class T, std::size_t D>
+auto PersistentKDTreeND<T, D>::copiar(Nodo* nodo) -> Nodo* {
+    retirar(nodo);
+    return nodos.create(*nodo);
+}
+
+template <class T, std::size_t D>
+void PersistentKDTreeND<T, D>::retirarSubarbol(Nodo* raiz) {
+    TraversalStack<Nodo*> pila;
+    if (raiz) pila.push(raiz);
+    while (!pila.empty()) {
+        Nodo* nodo = pila.pop();
+        retirar(nodo);
+        if (nodo->izquierdo) pila.push(nodo->izquierdo);
+        if (nodo->derecho) pila.push(nodo->derecho);
+    }
+}
+
+template <class T, std::size_t D>
+int PersistentKDTreeND<T, D>::alturaPermitida(std::size_t n) const {
+    return (int)(std::log((double)n) / std::log(1.0 / ALPHA)) + holguraAltura;
+}
+
+// Como KDTreeND::reconstruir, pero sin reutilizar los nodos: los viejos pueden
+// seguir visibles en otras versiones y se retiran
+template <class T, std::size_t D>
+int PersistentKDTreeND<T, D>::reconstruir(Nodo** enlace) {
+    Nodo* viejo = *enlace;
+    std::vector<typename Arbol::PuntoId> puntos;
+    puntos.reserve(viejo->tamano - viejo->muertos);
+
+    TraversalStack<Nodo*> pila;
+    pila.push(viejo);
+    while (!pila.empty()) {
+        Nodo* nodo = pila.pop();
+        if (!nodo->borrado) puntos.push_back({nodo->punto, nodo->id, nodo->atributo});
+        if (nodo->izquierdo) pila.push(nodo->izquierdo);
+        if (nodo->derecho) pila.push(nodo->derecho);
+    }
+    retirarSubarbol(viejo);
+
+    // buildSerial construye cada nodo sobre la ranura que se le da: una nueva de la arena
+    int nivelRaiz = viejo->nivel;
+    *enlace = Arbol::buildSerial(puntos, 0, puntos.size(), nivelRaiz,
+                                 [this](std::size_t) { return nodos.create(Punto{}, 0u, 0); });
+
+    int nivelMaximo = nivelRaiz - 1;
+    if (*enlace) pila.push(*enlace);
+    while (!pila.empty()) {
+        Nodo* nodo = pila.pop();
+        nivelMaximo = std::max(nivelMaximo, nodo->nivel);
+        if (nodo->izquierdo) pila.push(nodo->izquierdo);
+        if (nodo->derecho) pila.push(nodo->derecho);
+    }
+    return nivelMaximo - nivelRaiz + 1;
+}
+
+// raiz.store (seq_cst) antes de avanzar la epoca: un snapshot que lea la epoca
+// nueva vera esta raiz o una posterior, nunca los nodos retirados hasta ahora
+template <class T, std::size_t D>
+void PersistentKDTreeND<T, D>::publicar(Nodo* nueva) {
+    raiz.store(nueva);
+    tamano.store(nueva ? nueva->tamano - nueva->muertos : 0, std::memory_order_release);
+    epoca.fetch_add(1);
+    if (retirados.size() >= UMBRAL_RECLAMACION) reclamar();
+}
+
+// Libera los retirados con etiqueta menor que la epoca mas antigua anunciada
+template <class T, std::size_t D>
+void PersistentKDTreeND<T, D>::reclamar() {
+    std::uint64_t minima = epoca.load();
+    for (const Ranura& r : ranuras) minima = std::min(minima, r.epoca.load());
+
+    std::size_t quedan = 0;
+    for (const Retirado& r : retirados) {
+        if (r.epoca < minima) nodos.destroy(r.nodo);
+        else retirados[quedan++] = r;
+    }
+    retirados.resize(quedan);
+}
+
+template <class T, std::size_t D>
+void PersistentKDTreeND<T, D>::reclaim() {
+    std::lock_guard<std::mutex> guarda(escritura);
+    reclamar();
+}
+
+template <class T, std::size_t D>
+std::size_t PersistentKDTreeND<T, D>::pendingReclamation() const {
+    std::lock_guard<std::mutex> guarda(escritura);
+    return retirados.size();
+}
+
+template <class T, std::size_t D>
+void PersistentKDTreeND<T, D>::build(std::vector<Punto> puntos) {
+    std::lock_guard<std::mutex> guarda(escritura);
+    retirarSubarbol(raiz.load(std::memory_order_relaxed));
+    std::vector<typename Arbol::PuntoId> numerados = Arbol::numerar(std::move(puntos));
+    Nodo* ranuras = nodos.allocateContiguous(numerados.size());
+    Nodo* nueva = Arbol::buildSerial(numerados, 0, numerados.size(), 0, ranuras);
+    siguienteId = (std::uint32_t)numerados.size();
+    holguraAltura = 0;
+    publicar(nueva);
+}
+
+template <class T, std::size_t D>
+void PersistentKDTreeND<T, D>::clear() {
+    std::lock_guard<std::mutex> guarda(escritura);
+    retirarSubarbol(raiz.load(std::memory_order_relaxed));
+    siguienteId = 0;
+    holguraAltura = 0;
+    publicar(nullptr);
+}
+
+template <class T, std::size_t D>
+std::uint32_t PersistentKDTreeND<T, D>::insert(const Punto& punto) {
+    std::lock_guard<std::mutex> guarda(escritura);
+    std::uint32_t id = siguienteId;
+    insertar(punto, id, 0.0f);
+    return id;
+}
+
+template <class T, std::size_t D>
+void PersistentKDTreeND<T, D>::insert(const Punto& punto, std::uint32_t id) {
+    std::lock_guard<std::mutex> guarda(escritura);
+    insertar(punto, id, 0.0f);
+}
+
+template <class T, std::size_t D>
+void PersistentKDTreeND<T, D>::insert(const Punto& punto, std::uint32_t id, float atributo) {
+    std::lock_guard<std::mutex> guarda(escritura);
+    insertar(punto, id, atributo);
+}
+
+// Mismo descenso que KDTreeND::insert sobre copias del camino
+template <class T, std::size_t D>
+void PersistentKDTreeND<T, D>::insertar(const Punto& punto, std::uint32_t id, float atributo) {
+    Nodo* nueva = raiz.load(std::memory_order_relaxed);
+    Nodo** enlace = &nueva;
+    std::vector<Nodo**> camino;
+    int nivel = 0;
+
+    while (*enlace != nullptr) {
+        Nodo* nodo = copiar(*enlace);
+        *enlace = nodo;
+        camino.push_back(enlace);
+        nodo->tamano++;
+        Arbol::extenderCaja(nodo->caja, punto);
+        Arbol::extenderAtributo(nodo, atributo);
+        std::size_t eje = nivel % D;
+        enlace = Arbol::precede(punto, id, nodo->punto, nodo->id, eje) ? &nodo->izquierdo : &nodo->derecho;
+        nivel++;
+    }
+    *enlace = nodos.create(punto, id, nivel, atributo);
+    siguienteId = std::max(siguienteId, id + 1);
+
+    // Chivo expiatorio sobre las copias privadas del camino
+    std::size_t n = nueva->tamano;
+    if (nivel > alturaPermitida(n)) {
+        while (!camino.empty()) {
+            Nodo** actual = camino.back();
+            camino.pop_back();
+            int tamanoSub = (*actual)->tamano;
+            if (nivel - (*actual)->nivel > alturaPermitida(tamanoSub)) {
+                // Como en KDTreeND::insert: un subarbol con un solo par (punto, id)
+                // no se reconstruye
+                int altura = Arbol::claveUnica(*actual) ? nivel - (*actual)->nivel + 1 : reconstruir(actual);
+                int exceso = altura - 1 - alturaPermitida(tamanoSub);
+                if (exceso > 0) holguraAltura += exceso;
+                break;
+            }
+        }
+        // La reconstruccion descarta las lapidas: los ancestros cambian de tamano
+        while (!camino.empty()) {
+            Arbol::actualizarResumen(*camino.back());
+            camino.pop_back();
+        }
+    }
+    publicar(nueva);
+}
+
+// Borrado con lapida (como KDTreeND en modo perezoso): una hoja se desengancha
+// de la copia de su padre; cualquier otro nodo se copia marcado como borrado.
+template <class T, std::size_t D>
+void PersistentKDTreeND<T, D>::remove(const Punto& punto, std::uint32_t id) {
+    std::lock_guard<std::mutex> guarda(escritura);
+
+    // Primero se busca sin copiar: si el punto no esta no hay version nueva
+    std::vector<Nodo*> ruta;
+    Nodo* nodo = raiz.load(std::memory_order_relaxed);
+    if (id == SIN_ID) id = Arbol::buscarId(nodo, punto, true);
+    if (id == SIN_ID) return;
+    for (int nivel = 0; nodo != nullptr; nivel++) {
+        ruta.push_back(nodo);
+        if (!nodo->borrado && Arbol::mismoPunto(nodo->punto, punto) && nodo->id == id) break;
+        std::size_t eje = nivel % D;
+        nodo = Arbol::precede(punto, id, nodo->punto, nodo->id, eje) ? nodo->izquierdo : nodo->derecho;
+    }
+    if (nodo == nullptr) return;
+
+    Nodo* nueva = ruta[0];
+    Nodo** enlace = &nueva;
+    std::vector<Nodo**> camino;
+    for (std::size_t i = 0; i + 1 < ruta.size(); i++) {
+        Nodo* copia = copiar(*enlace);
+        *enlace = copia;
+        camino.push_back(enlace);
+        enlace = (copia->izquierdo == ruta[i + 1]) ? &copia->izquierdo : &copia->derecho;
+    }
+    if (nodo->izquierdo == nullptr && nodo->derecho == nullptr) {
+        retirar(nodo);
+        *enlace = nullptr;
+    } else {
+        *enlace = copiar(nodo);
+        (*enlace)->borrado = true;
+        camino.push_back(enlace);
+    }
+
+    // Recalcular el camino de abajo hacia arriba; se compacta el subarbol mas
+    // alto que supere el umbral de lapidas
+    std::size_t compactar = camino.size();
+    for (std::size_t i = camino.size(); i-- > 0;) {
+        Nodo* actual = *camino[i];
+        Arbol::actualizarResumen(actual);
+        if (actual->muertos > UMBRAL_COMPACTACION * actual->tamano) compactar = i;
+    }
+    if (compactar < camino.size()) {
+        reconstruir(camino[compactar]);
+        for (std::size_t i = compactar; i-- > 0;) Arbol::actualizarResumen(*camino[i]);
+    }
+    publicar(nueva);
+}
@@ -0,0 +1,383 @@
+#pragma once
+#include "KDTree.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Carga de puntos desde archivo directamente a la construccion en bloque.
+//
+// El archivo se mapea (MappedFile) y se reparte en bloques de tamanoBloque
+// bytes que el pool procesa en paralelo; las paginas de cada bloque se
+// descartan al terminarlo, asi la memoria residente no crece con el archivo.
+// Dos pasadas: la primera cuenta registros por bloque para saber donde escribe
+// cada uno y la segunda parsea (std::from_chars) y valida directamente sobre
+// el vector de PuntoId que consume buildParallelWithIds: no hay copia
+// intermedia de los puntos.
+//
+// Formatos:
+//  - CSV: una fila por punto, D columnas numericas separadas por `separador`
+//    (espacios alrededor permitidos, columnas extra ignoradas, lineas vacias
+//    saltadas, \n o \r\n). id = indice de la linea tras la cabecera: las
+//    lineas vacias tambien consumen el suyo, asi id + 1 (+ 1 con cabecera)
+//    es el numero de linea del punto en el archivo.
+//  - Binario: registros T[D] empaquetados en el orden de bytes nativo, sin
+//    cabecera. id = indice del registro.
+// Las filas descartadas consumen su id, asi el id sigue identificando la fila.
+//
+// Si la carga falla el arbol no se modifica.
+//
+// PointLoader es PointLoaderND<float, 2> (KDTree).
+enum class EstadoCarga {
+    Ok,
+    ErrorES,         // no se pudo abrir o mapear el archivo
+    ErrorFormato,    // numero mal formado, columnas de menos o registro incompleto
+    FueraDeDominio,  // coordenada fuera del dominio con descartarFueraDeDominio = false
+};
+
+struct InformeCarga {
+    EstadoCarga estado = EstadoCarga::Ok;
+    std::size_t bytes = 0;
+    std::size_t registros = 0;    // lineas tras la cabecera (vacias incluidas) / registros del archivo
+    std::size_t puntos = 0;       // puntos en el arbol
+    std::size_t descartados = 0;  // fuera del dominio (o no finitos)
+    std::size_t lineaError = 0;   // linea (CSV, desde 1) o registro (binario, desde 1) con error
+    double segundosLectura = 0;   // mapeo, parseo y validacion
+    double segundosConstruccion = 0;
+
+    double mbPorSegundo() const { return segundosLectura > 0 ? bytes / 1e6 / segundosLectura : 0; }
+};
+
+template <class T, std::size_t D>
+class PointLoaderND {
+public:
+    using Arbol = KDTreeND<T, D>;
+    using Punto = typename Arbol::Punto;
+    using Caja = typename Arbol::Caja;
+    using PuntoId = typename Arbol::PuntoId;
+
+    struct Opciones {
+        // Coordenadas admitidas; las no finitas quedan siempre fuera
+        Caja dominio = dominioCompleto();
+        // true: los puntos fuera del dominio se cuentan en descartados;
+        // false: la carga falla con FueraDeDominio
+        bool descartarFueraDeDominio = true;
+        char separador = ',';
+        bool cabecera = false;  // CSV: la primera linea son nombres de columna
+        unsigned hilos = 0;     // 0 = todos los nucleos
+        std::size_t tamanoBloque = std::size_t(8) << 20;
+    };
+
+    static Caja dominioCompleto();
+
+    static InformeCarga loadCsv(const std::string& ruta, Arbol& arbol, const Opciones& opciones = {});
+    static InformeCarga loadBinary(const std::string& ruta, Arbol& arbol, const Opciones& opciones = {});
+
+private:
+    using Reloj = std::chrono::steady_clock;
+
+    // Resultado de un bloque de la segunda pasada
+    struct Bloque {
+        std::size_t escritos = 0;
+        std::size_t descartados = 0;
+        std::size_t registroError = 0;  // linea o registro (desde 1) del primer error
+        EstadoCarga estado = EstadoCarga::Ok;
+    };
+
+    static double segundosDesde(Reloj::time_point inicio) {
+        return std::chrono::duration<double>(Reloj::now() - inicio).count();
+    }
+    static bool esEspacio(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+    static bool lineaVacia(const char* p, const char* fin);
+    static bool enDominio(const Punto& p, const Caja& dominio);
+    static bool parsearLinea(const char* p, const char* fin, char separador, Punto& punto);
+    static std::vector<std::size_t> limitesCsv(const char* datos, std::size_t inicio, std::size_t fin,
+                                               std::size_t tamanoBloque);
+    static void compactar(std::vector<PuntoId>& puntos, const std::vector<std::size_t>& primerRegistro,
+                          const std::vector<Bloque>& bloques);
+    static bool resumir(const std::vector<Bloque>& bloques, InformeCarga& informe);
+};
+
+using PointLoader = PointLoaderND<float, 2>;
+
+template <class T, std::size_t D>
+auto PointLoaderND<T, D>::dominioCompleto() -> Caja {
+    Caja caja;
+    for (std::size_t e = 0; e < D; e++) {
+        caja.inferior(e) = std::numeric_limits<T>::lowest();
+        caja.superior(e) = std::numeric_limits<T>::max();
+    }
+    return caja;
+}
+
+// ============ VALIDACION Y PARSEO
+template <class T, std::size_t D>
+bool PointLoaderND<T, D>::enDominio(const Punto& p, const Caja& dominio) {
+    for (std::size_t e = 0; e < D; e++) {
+        if (std::is_floating_point<T>::value && !std::isfinite((double)p[e])) return false;
+        if (p[e] < dominio.inferior(e) || p[e] > dominio.superior(e)) return false;
+    }
+    return true;
+}
+
+template <class T, std::size_t D>
+bool PointLoaderND<T, D>::lineaVacia(const char* p, const char* fin) {
+    while (p < fin && esEspacio(*p)) p++;
+    return p == fin;
+}
+
+// Parsea las D primeras columnas de [p, fin) (una linea sin '\n'). Con un
+// separador en blanco (' ' o '\t') cualquier racha de blancos separa.
+template <class T, std::size_t D>
+bool PointLoaderND<T, D>::parsearLinea(const char* p, const char* fin, char separador, Punto& punto) {
+    const bool separadorBlanco = esEspacio(separador);
+    bool separado = false;
+    for (std::size_t e = 0; e < D; e++) {
+        while (p < fin && esEspacio(*p)) p++;
+        if (p < fin && *p == '+') p++;  // from_chars no acepta el signo +
+        T valor;
+        std::from_chars_result r = std::from_chars(p, fin, valor);
+        if (r.ec != std::errc()) return false;
+        punto[e] = valor;
+        p = r.ptr;
+        const char* finValor = p;
+        while (p < fin && esEspacio(*p)) p++;
+        separado = separadorBlanco ? (p != finValor && p != fin) : (p != fin && *p == separador);
+        if (e + 1 < D) {
+            if (!separado) return false;
+            if (!separadorBlanco) p++;
+        }
+    }
+    return p == fin || separado;
+}
+
+// ============ BLOQUES
+// Limites de bloque en [inicio, fin): cada bloque termina justo tras un '\n'
+template <class T, std::size_t D>
+std::vector<std::size_t> PointLoaderND<T, D>::limitesCsv(const char* datos, std::size_t inicio,
+                                                         std::size_t fin, std::size_t tamanoBloque) {
+    std::vector<std::size_t> limites{inicio};
+    std::size_t actual = inicio;
+    while (fin - actual > tamanoBloque) {
+        const void* salto = std::memchr(datos + actual + tamanoBloque, '\n', fin - actual - tamanoBloque);
+        if (!salto) break;
+        actual = (std::size_t)(static_cast<const char*>(salto) - datos) + 1;
+        if (actual < fin) limites.push_back(actual);
+    }
+    limites.push_back(fin);
+    return limites;
+}
+
+// Junta los puntos escritos al principio de cada bloque (los descartes dejan
+// huecos al final de su tramo). En el sitio, de izquierda a derecha.
+template <class T, std::size_t D>
+void PointLoaderND<T, D>::compactar(std::vector<PuntoId>& puntos,
+                                    const std::vector<std::size_t>& primerRegistro,
+                                    const std::vector<Bloque>& bloques) {
+    std::size_t destino = 0;
+    for (std::size_t b = 0; b < bloques.size(); b++) {
+        std::size_t origen = primerRegistro[b];
+        if (destino != origen) {
+            std::copy(puntos.begin() + origen, puntos.begin() + origen + bloques[b].escritos,
+                      puntos.begin() + destino);
+        }
+        destino += bloques[b].escritos;
+    }
+    puntos.resize(destino);
+}
+
+// Agrega los bloques en el informe; false si alguno fallo. Con varios errores
+// no se garantiza cual se informa: un bloque deja de parsear en cuanto otro
+// falla, asi que uno anterior puede no haber llegado a su error.
+template <class T, std::size_t D>
+bool PointLoaderND<T, D>::resumir(const std::vector<Bloque>& bloques, InformeCarga& informe) {
+    for (const Bloque& b : bloques) {
+        if (b.estado != EstadoCarga::Ok) {
+            informe.estado = b.estado;
+            informe.lineaError = b.registroError;
+            return false;
+        }
+        informe.puntos += b.escritos;
+        informe.descartados += b.descartados;
+    }
+    return true;
+}
+
+// ============ CSV
+template <class T, std::size_t D>
+InformeCarga PointLoaderND<T, D>::loadCsv(const std::string& ruta, Arbol& arbol, const Opciones& opciones) {
+    InformeCarga informe;
+    auto inicio = Reloj::now();
+    MappedFile archivo;
+    if (!archivo.open(ruta)) {
+        informe.estado = EstadoCarga::ErrorES;
+        return informe;
+    }
+    archivo.adviseSequential();
+    const char* datos = archivo.data();
+    const std::size_t longitud = archivo.size();
+    informe.bytes = longitud;
+
+    std::size_t inicioDatos = 0;
+    if (opciones.cabecera) {
+        const void* salto = std::memchr(datos, '\n', longitud);
+        inicioDatos = salto ? (std::size_t)(static_cast<const char*>(salto) - datos) + 1 : longitud;
+    }
+    std::vector<std::size_t> limites =
+        limitesCsv(datos, inicioDatos, longitud, std::max<std::size_t>(opciones.tamanoBloque, 1));
+    const std::size_t numBloques = limites.size() - 1;
+    ThreadPool pool(opciones.hilos);
+
+    // Pasada 1: filas por bloque (solo el ultimo puede acabar sin '\n')
+    std::vector<std::size_t> primeraFila(numBloques + 1, 0);
+    pool.parallelFor(numBloques, 1, [&](std::size_t desde, std::size_t hasta) {
+        for (std::size_t b = desde; b < hasta; b++) {
+            const char* p = datos + limites[b];
+            const char* fin = datos + limites[b + 1];
+            std::size_t filas = (std::size_t)std::count(p, fin, '\n');
+            if (fin > p && fin[-1] != '\n') filas++;
+            primeraFila[b + 1] = filas;
+        }
+    });
+    for (std::size_t b = 0; b < numBloques; b++) primeraFila[b + 1] += primeraFila[b];
+    informe.registros = primeraFila[numBloques];
+    if (informe.registros > Arbol::SIN_ID) {  // los ids son de 32 bits
+        informe.estado = EstadoCarga::ErrorFormato;
+        return informe;
+    }
+
+    // Pasada 2: parseo directo a la posicion final
+    std::vector<PuntoId> puntos(informe.registros);
+    std::vector<Bloque> bloques(numBloques);
+    std::atomic<bool> fallo{false};
+    const std::size_t filaBase = opciones.cabecera ? 2 : 1;  // numero de linea de la fila 0
+    pool.parallelFor(numBloques, 1, [&](std::size_t desde, std::size_t hasta) {
+        for (std::size_t b = desde; b < hasta; b++) {
+            Bloque& bloque = bloques[b];
+            const char* p = datos + limites[b];
+            const char* fin = datos + limites[b + 1];
+            std::size_t fila = primeraFila[b];
+            PuntoId* salida = puntos.data() + primeraFila[b];
+
+            for (; p < fin && !fallo.load(std::memory_order_relaxed); fila++) {
+                const char* salto = static_cast<const char*>(std::memchr(p, '\n', fin - p));
+                const char* finLinea = salto ? salto : fin;
+                if (!lineaVacia(p, finLinea)) {
+                    PuntoId& destino = salida[bloque.escritos];
+                    EstadoCarga estado = EstadoCarga::Ok;
+                    if (!parsearLinea(p, finLinea, opciones.separador, destino.punto)) {
+                        estado = EstadoCarga::ErrorFormato;
+                    } else if (!enDominio(destino.punto, opciones.dominio)) {
+                        if (opciones.descartarFueraDeDominio) bloque.descartados++;
+                        else estado = EstadoCarga::FueraDeDominio;
+                    } else {
+                        destino.id = (std::uint32_t)fila;
+                        bloque.escritos++;
+                    }
+                    if (estado != EstadoCarga::Ok) {
+                        bloque.estado = estado;
+                        bloque.registroError = fila + filaBase;
+                        fallo = true;
+                        break;
+                    }
+                }
+                p = salto ? salto + 1 : fin;
+            }
+            archivo.discard(limites[b], limites[b + 1] - limites[b]);
+        }
+    });
+
+    if (!resumir(bloques, informe)) {
+        informe.segundosLectura = segundosDesde(inicio);
+        return informe;
+    }
+    compactar(puntos, primeraFila, bloques);
+    informe.segundosLectura = segundosDesde(inicio);
+
+    inicio = Reloj::now();
+    arbol.buildParallelWithIds(std::move(puntos), pool);
+    informe.segundosConstruccion = segundosDesde(inicio);
+    return informe;
+}
+
+// ============ BINARIO
+template <class T, std::size_t D>
+InformeCarga PointLoaderND<T, D>::loadBinary(const std::string& ruta, Arbol& arbol, const Opciones& opciones) {
+    constexpr std::size_t bytesRegistro = D * sizeof(T);
+
+    InformeCarga informe;
+    auto inicio = Reloj::now();
+    MappedFile archivo;
+    if (!archivo.open(ruta)) {
+        informe.estado = EstadoCarga::ErrorES;
+        return informe;
+    }
+    archivo.adviseSequential();
+    const char* datos = archivo.data();
+    informe.bytes = archivo.size();
+    informe.registros = archivo.size() / bytesRegistro;
+    if (archivo.size() % bytesRegistro != 0 || informe.registros > Arbol::SIN_ID) {
+        informe.estado = EstadoCarga::ErrorFormato;
+        informe.lineaError = informe.registros + 1;
+        return informe;
+    }
+
+    const std::size_t porBloque = std::max<std::size_t>(opciones.tamanoBloque / bytesRegistro, 1);
+    const std::size_t numBloques = (informe.registros + porBloque - 1) / porBloque;
+    std::vector<std::size_t> primerRegistro(numBloques);
+    for (std::size_t b = 0; b < numBloques; b++) primerRegistro[b] = b * porBloque;
+
+    std::vector<PuntoId> puntos(informe.registros);
+    std::vector<Bloque> bloques(numBloques);
+    std::atomic<bool> fallo{false};
+    ThreadPool pool(opciones.hilos);
+    pool.parallelFor(numBloques, 1, [&](std::size_t desde, std::size_t hasta) {
+        for (std::size_t b = desde; b < hasta; b++) {
+            Bloque& bloque = bloques[b];
+            std::size_t primero = primerRegistro[b];
+            std::size_t ultimo = std::min(primero + porBloque, informe.registros);
+            PuntoId* salida = puntos.data() + primero;
+
+            for (std::size_t r = primero; r < ultimo && !fallo.load(std::memory_order_relaxed); r++) {
+                PuntoId& destino = salida[bloque.escritos];
+                T coordenadas[D];
+                std::memcpy(coordenadas, datos + r * bytesRegistro, bytesRegistro);  // sin exigir alineacion
+                for (std::size_t e = 0; e < D; e++) destino.punto[e] = coordenadas[e];
+                if (enDominio(destino.punto, opciones.dominio)) {
+                    destino.id = (std::uint32_t)r;
+                    bloque.escritos++;
+                } else if (opciones.descartarFueraDeDominio) {
+                    bloque.descartados++;
+                } else {
+                    bloque.estado = EstadoCarga::FueraDeDominio;
+                    bloque.registroError = r + 1;
+                    fallo = true;
+                    break;
+                }
+            }
+            archivo.discard(primero * bytesRegistro, (ultimo - primero) * bytesRegistro);
+        }
+    });
+
+    if (!resumir(bloques, informe)) {
+        informe.segundosLectura = segundosDesde(inicio);
+        return informe;
+    }
+    compactar(puntos, primerRegistro, bloques);
+    informe.segundosLectura = segundosDesde(inicio);
+
+    inicio = Reloj::now();
+    arbol.buildParallelWithIds(std::move(puntos), pool);
+    informe.segundosConstruccion = segundosDesde(inicio);
+    return informe;
+}
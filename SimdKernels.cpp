@@ -0,0 +1,273 @@
+#include "SimdKernels.h"
+#include <limits>
+
+// SSE2 es parte de x86-64; en 32 bits solo si el compilador lo habilita
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__SSE2__)
+#define KD_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(KD_SIMD_X86)
+#define KD_SIMD_AVX2 1
+#define KD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace std;
+
+// ============ ESCALAR
+
+static void distanciasEscalar(const float* x, const float* y, size_t n,
+                              float qx, float qy, float* salida) {
+    for (size_t i = 0; i < n; i++) {
+        float dx = x[i] - qx;
+        float dy = y[i] - qy;
+        salida[i] = dx * dx + dy * dy;
+    }
+}
+
+static size_t masCercanoEscalar(const float* x, const float* y, size_t n,
+                                float qx, float qy, float* distancia) {
+    size_t mejor = 0;
+    float mejorDistancia = numeric_limits<float>::infinity();
+    for (size_t i = 0; i < n; i++) {
+        float dx = x[i] - qx;
+        float dy = y[i] - qy;
+        float d = dx * dx + dy * dy;
+        if (d < mejorDistancia) {
+            mejorDistancia = d;
+            mejor = i;
+        }
+    }
+    *distancia = mejorDistancia;
+    return mejor;
+}
+
+static size_t enRectanguloEscalar(const float* x, const float* y, size_t n,
+                                  const Rectangulo& r, uint32_t* indices) {
+    size_t cuenta = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (x[i] >= r.xmin && x[i] <= r.xmax && y[i] >= r.ymin && y[i] <= r.ymax) {
+            indices[cuenta++] = (uint32_t)i;
+        }
+    }
+    return cuenta;
+}
+
+// Reduce los carriles de un kernel vectorial y continua con la cola escalar
+static size_t reducirMinimo(const float* carriles, const int32_t* indices, int ancho,
+                            const float* x, const float* y, size_t desde, size_t n,
+                            float qx, float qy, float* distancia) {
+    float mejorDistancia = numeric_limits<float>::infinity();
+    size_t mejor = 0;
+    for (int c = 0; c < ancho; c++) {
+        if (indices[c] < 0) continue;
+        if (carriles[c] < mejorDistancia ||
+            (carriles[c] == mejorDistancia && (size_t)indices[c] < mejor)) {
+            mejorDistancia = carriles[c];
+            mejor = (size_t)indices[c];
+        }
+    }
+    for (size_t i = desde; i < n; i++) {
+        float dx = x[i] - qx;
+        float dy = y[i] - qy;
+        float d = dx * dx + dy * dy;
+        if (d < mejorDistancia) {
+            mejorDistancia = d;
+            mejor = i;
+        }
+    }
+    *distancia = mejorDistancia;
+    return mejor;
+}
+
+#ifdef KD_SIMD_X86
+
+// ============ SSE (SSE2, base de x86-64)
+
+static void distanciasSSE(const float* x, const float* y, size_t n,
+                          float qx, float qy, float* salida) {
+    const __m128 qx4 = _mm_set1_ps(qx);
+    const __m128 qy4 = _mm_set1_ps(qy);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), qx4);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), qy4);
+        _mm_storeu_ps(salida + i, _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+    }
+    distanciasEscalar(x + i, y + i, n - i, qx, qy, salida + i);
+}
+
+static size_t masCercanoSSE(const float* x, const float* y, size_t n,
+                            float qx, float qy, float* distancia) {
+    const __m128 qx4 = _mm_set1_ps(qx);
+    const __m128 qy4 = _mm_set1_ps(qy);
+    __m128 mejor = _mm_set1_ps(numeric_limits<float>::infinity());
+    __m128i mejorIndice = _mm_set1_epi32(-1);
+    __m128i indice = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i paso = _mm_set1_epi32(4);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), qx4);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), qy4);
+        __m128 d = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        __m128i menor = _mm_castps_si128(_mm_cmplt_ps(d, mejor));
+        // blend sin SSE4.1: (menor & indice) | (~menor & mejorIndice)
+        mejorIndice = _mm_or_si128(_mm_and_si128(menor, indice), _mm_andnot_si128(menor, mejorIndice));
+        mejor = _mm_min_ps(d, mejor);
+        indice = _mm_add_epi32(indice, paso);
+    }
+
+    alignas(16) float carriles[4];
+    alignas(16) int32_t indices[4];
+    _mm_store_ps(carriles, mejor);
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices), mejorIndice);
+    return reducirMinimo(carriles, indices, 4, x, y, i, n, qx, qy, distancia);
+}
+
+static size_t enRectanguloSSE(const float* x, const float* y, size_t n,
+                              const Rectangulo& r, uint32_t* indices) {
+    const __m128 xmin = _mm_set1_ps(r.xmin), xmax = _mm_set1_ps(r.xmax);
+    const __m128 ymin = _mm_set1_ps(r.ymin), ymax = _mm_set1_ps(r.ymax);
+    size_t cuenta = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 py = _mm_loadu_ps(y + i);
+        __m128 dentro = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(px, xmin), _mm_cmple_ps(px, xmax)),
+                                   _mm_and_ps(_mm_cmpge_ps(py, ymin), _mm_cmple_ps(py, ymax)));
+        unsigned bits = (unsigned)_mm_movemask_ps(dentro);
+        while (bits) {
+            indices[cuenta++] = (uint32_t)(i + __builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+    for (; i < n; i++) {
+        if (x[i] >= r.xmin && x[i] <= r.xmax && y[i] >= r.ymin && y[i] <= r.ymax) {
+            indices[cuenta++] = (uint32_t)i;
+        }
+    }
+    return cuenta;
+}
+
+#endif  // KD_SIMD_X86
+
+#ifdef KD_SIMD_AVX2
+
+// ============ AVX2 (compilado con target("avx2"), elegido en tiempo de ejecucion)
+
+KD_TARGET_AVX2
+static void distanciasAVX2(const float* x, const float* y, size_t n,
+                           float qx, float qy, float* salida) {
+    const __m256 qx8 = _mm256_set1_ps(qx);
+    const __m256 qy8 = _mm256_set1_ps(qy);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), qx8);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), qy8);
+        _mm256_storeu_ps(salida + i, _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+    }
+    distanciasEscalar(x + i, y + i, n - i, qx, qy, salida + i);
+}
+
+KD_TARGET_AVX2
+static size_t masCercanoAVX2(const float* x, const float* y, size_t n,
+                             float qx, float qy, float* distancia) {
+    const __m256 qx8 = _mm256_set1_ps(qx);
+    const __m256 qy8 = _mm256_set1_ps(qy);
+    __m256 mejor = _mm256_set1_ps(numeric_limits<float>::infinity());
+    __m256i mejorIndice = _mm256_set1_epi32(-1);
+    __m256i indice = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i paso = _mm256_set1_epi32(8);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), qx8);
+        __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), qy8);
+        __m256 d = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        __m256 menor = _mm256_cmp_ps(d, mejor, _CMP_LT_OQ);
+        mejorIndice = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(mejorIndice),
+                                                           _mm256_castsi256_ps(indice), menor));
+        mejor = _mm256_min_ps(d, mejor);
+        indice = _mm256_add_epi32(indice, paso);
+    }
+
+    alignas(32) float carriles[8];
+    alignas(32) int32_t indices[8];
+    _mm256_store_ps(carriles, mejor);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indices), mejorIndice);
+    return reducirMinimo(carriles, indices, 8, x, y, i, n, qx, qy, distancia);
+}
+
+KD_TARGET_AVX2
+static size_t enRectanguloAVX2(const float* x, const float* y, size_t n,
+                               const Rectangulo& r, uint32_t* indices) {
+    const __m256 xmin = _mm256_set1_ps(r.xmin), xmax = _mm256_set1_ps(r.xmax);
+    const __m256 ymin = _mm256_set1_ps(r.ymin), ymax = _mm256_set1_ps(r.ymax);
+    size_t cuenta = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 px = _mm256_loadu_ps(x + i);
+        __m256 py = _mm256_loadu_ps(y + i);
+        __m256 dentroX = _mm256_and_ps(_mm256_cmp_ps(px, xmin, _CMP_GE_OQ), _mm256_cmp_ps(px, xmax, _CMP_LE_OQ));
+        __m256 dentroY = _mm256_and_ps(_mm256_cmp_ps(py, ymin, _CMP_GE_OQ), _mm256_cmp_ps(py, ymax, _CMP_LE_OQ));
+        unsigned bits = (unsigned)_mm256_movemask_ps(_mm256_and_ps(dentroX, dentroY));
+        while (bits) {
+            indices[cuenta++] = (uint32_t)(i + __builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+    for (; i < n; i++) {
+        if (x[i] >= r.xmin && x[i] <= r.xmax && y[i] >= r.ymin && y[i] <= r.ymax) {
+            indices[cuenta++] = (uint32_t)i;
+        }
+    }
+    return cuenta;
+}
+
+#endif  // KD_SIMD_AVX2
+
+// ============ DESPACHO
+
+static const KernelsDistancia KERNELS_ESCALAR = {
+    NivelSimd::Escalar, "escalar", distanciasEscalar, masCercanoEscalar, enRectanguloEscalar};
+
+#ifdef KD_SIMD_X86
+static const KernelsDistancia KERNELS_SSE = {
+    NivelSimd::SSE, "sse", distanciasSSE, masCercanoSSE, enRectanguloSSE};
+#endif
+
+#ifdef KD_SIMD_AVX2
+static const KernelsDistancia KERNELS_AVX2 = {
+    NivelSimd::AVX2, "avx2", distanciasAVX2, masCercanoAVX2, enRectanguloAVX2};
+#endif
+
+const KernelsDistancia* kernelsPara(NivelSimd nivel) {
+    switch (nivel) {
+    case NivelSimd::Escalar:
+        return &KERNELS_ESCALAR;
+    case NivelSimd::SSE:
+#ifdef KD_SIMD_X86
+        return &KERNELS_SSE;
+#else
+        return nullptr;
+#endif
+    case NivelSimd::AVX2:
+#ifdef KD_SIMD_AVX2
+        return __builtin_cpu_supports("avx2") ? &KERNELS_AVX2 : nullptr;
+#else
+        return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+const KernelsDistancia& kernelsActivos() {
+    static const KernelsDistancia* activos = [] {
+        for (NivelSimd nivel : {NivelSimd::AVX2, NivelSimd::SSE}) {
+            if (const KernelsDistancia* k = kernelsPara(nivel)) return k;
+        }
+        return &KERNELS_ESCALAR;
+    }();
+    return *activos;
+}
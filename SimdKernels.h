@@ -0,0 +1,38 @@
+#pragma once
+#include "KDTree.h"
+#include <cstddef>
+#include <cstdint>
+
+// Kernels vectorizados sobre bloques SoA (x[], y[]) de las hojas de BucketKDTree.
+// Todas las variantes calculan dx*dx + dy*dy con las mismas operaciones que la
+// version escalar (sin FMA), asi que los resultados son identicos bit a bit.
+enum class NivelSimd {
+    Escalar,
+    SSE,
+    AVX2
+};
+
+struct KernelsDistancia {
+    NivelSimd nivel;
+    const char* nombre;
+
+    // salida[i] = distancia al cuadrado de (x[i], y[i]) a (qx, qy)
+    void (*distancias)(const float* x, const float* y, std::size_t n,
+                       float qx, float qy, float* salida);
+
+    // Indice del punto mas cercano a (qx, qy) (el primero en caso de empate);
+    // su distancia al cuadrado queda en *distancia. Requiere n > 0.
+    std::size_t (*masCercano)(const float* x, const float* y, std::size_t n,
+                              float qx, float qy, float* distancia);
+
+    // Escribe en indices[] las posiciones dentro del rectangulo (bordes incluidos)
+    // y devuelve cuantas son. indices debe tener espacio para n elementos.
+    std::size_t (*enRectangulo)(const float* x, const float* y, std::size_t n,
+                                const Rectangulo& rectangulo, std::uint32_t* indices);
+};
+
+// Kernels de un nivel concreto, o nullptr si la CPU/compilador no lo soporta
+const KernelsDistancia* kernelsPara(NivelSimd nivel);
+
+// Mejor nivel disponible en esta CPU (AVX2 > SSE > escalar), detectado una vez
+const KernelsDistancia& kernelsActivos();
@@ -0,0 +1,382 @@
+#include "StaticKDTree.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+using namespace std;
+
+#if defined(__GNUC__) || defined(__clang__)
+#define KD_PREFETCH(direccion) __builtin_prefetch(direccion)
+#else
+#define KD_PREFETCH(direccion) ((void)0)
+#endif
+
+// Altura maxima soportada: la pila explicita nunca supera la altura del arbol
+static constexpr int ALTURA_MAXIMA = 64;
+
+static inline float distanciaCuadrado(const Punto2D& a, const Punto2D& b) {
+    float diferenciaX = a.x - b.x;
+    float diferenciaY = a.y - b.y;
+    return diferenciaX * diferenciaX + diferenciaY * diferenciaY;
+}
+
+static inline float coordenada(const Punto2D& p, int eje) {
+    return (eje == 0) ? p.x : p.y;
+}
+
+// Los 4 nietos de i (4i+3 .. 4i+6) son contiguos: una sola linea de cache
+static inline void prefetchNietos(const Punto2D* nodos, size_t i, size_t n) {
+    size_t nieto = 4 * i + 3;
+    if (nieto < n) KD_PREFETCH(nodos + nieto);
+}
+
+// Tamano del subarbol izquierdo de un arbol completo con m nodos
+static size_t tamanoIzquierdo(size_t m) {
+    if (m <= 1) return 0;
+    int h = 0;
+    while ((size_t(2) << h) <= m) h++;          // h = floor(log2(m))
+    size_t mitad = size_t(1) << (h - 1);        // capacidad del ultimo nivel en la mitad izquierda
+    size_t ultimoNivel = m - ((size_t(1) << h) - 1);
+    return (mitad - 1) + min(ultimoNivel, mitad);
+}
+
+// Punto con su id durante la construccion
+struct Entrada {
+    Punto2D punto;
+    uint32_t id;
+};
+
+// ============ CONSTRUCCION
+// Complejidad: O(n log n). El pivote de cada subarbol se elige para que el
+// arbol sea completo, asi los indices 2i+1 / 2i+2 caen siempre dentro de [0, n).
+static void construirEytzinger(vector<Entrada>& entrada, size_t inicio, size_t fin, size_t indice,
+                               int profundidad, vector<Punto2D>& salida, vector<uint32_t>& ids) {
+    if (inicio >= fin) return;
+
+    int eje = profundidad % 2;
+    size_t pivote = inicio + tamanoIzquierdo(fin - inicio);
+    nth_element(entrada.begin() + inicio, entrada.begin() + pivote, entrada.begin() + fin,
+                [eje](const Entrada& a, const Entrada& b) {
+                    return coordenada(a.punto, eje) < coordenada(b.punto, eje);
+                });
+
+    salida[indice] = entrada[pivote].punto;
+    ids[indice] = entrada[pivote].id;
+    construirEytzinger(entrada, inicio, pivote, 2 * indice + 1, profundidad + 1, salida, ids);
+    construirEytzinger(entrada, pivote + 1, fin, 2 * indice + 2, profundidad + 1, salida, ids);
+}
+
+static void construir(vector<Entrada>& entrada, vector<Punto2D>& nodos, vector<uint32_t>& ids) {
+    nodos.resize(entrada.size());
+    ids.resize(entrada.size());
+    construirEytzinger(entrada, 0, entrada.size(), 0, 0, nodos, ids);
+}
+
+StaticKDTree::StaticKDTree(vector<Punto2D> puntos) : n(puntos.size()) {
+    vector<Entrada> entrada(n);
+    for (size_t i = 0; i < n; i++) entrada[i] = {puntos[i], (uint32_t)i};
+    construir(entrada, nodos, identificadores);
+}
+
+StaticKDTree::StaticKDTree(const KDTree& arbol) {
+    vector<Entrada> entrada;
+    entrada.reserve(arbol.size());
+    const float infinito = numeric_limits<float>::infinity();
+    arbol.forEachInRange({-infinito, infinito, -infinito, infinito},
+                         [&](const Punto2D& p, uint32_t id) { entrada.push_back({p, id}); });
+    n = entrada.size();
+    construir(entrada, nodos, identificadores);
+}
+
+// Rama pendiente de explorar y distancia (al cuadrado) de su plano divisor
+struct Pendiente {
+    size_t indice;
+    int eje;
+    float distanciaPlano;
+};
+
+// ============ VECINO MAS CERCANO
+// Descenso sin saltos: el hijo cercano se elige con aritmetica (2i+1+lado) y la
+// rama lejana se apila solo si el circulo actual cruza el plano divisor.
+size_t StaticKDTree::indiceMasCercano(const Punto2D& objetivo) const {
+    const Punto2D* datos = data();
+    float mejorDistancia = numeric_limits<float>::infinity();
+    size_t mejor = 0;
+
+    Pendiente pila[ALTURA_MAXIMA];
+    int tope = 0;
+    pila[tope++] = {0, 0, 0.f};
+
+    while (tope > 0) {
+        Pendiente actual = pila[--tope];
+        if (actual.distanciaPlano >= mejorDistancia) continue;
+
+        size_t i = actual.indice;
+        int eje = actual.eje;
+        while (i < n) {
+            prefetchNietos(datos, i, n);
+            const Punto2D& p = datos[i];
+
+            float d = distanciaCuadrado(objetivo, p);
+            if (d < mejorDistancia) {
+                mejorDistancia = d;
+                mejor = i;
+            }
+
+            float diff = coordenada(objetivo, eje) - coordenada(p, eje);
+            size_t lado = (diff >= 0.f);
+            size_t lejano = 2 * i + 2 - lado;
+            if (lejano < n && diff * diff < mejorDistancia) {
+                pila[tope++] = {lejano, eje ^ 1, diff * diff};
+            }
+
+            i = 2 * i + 1 + lado;
+            eje ^= 1;
+        }
+    }
+
+    return mejor;
+}
+
+Punto2D StaticKDTree::nearest(const Punto2D& objetivo) const {
+    if (n == 0) return {0.f, 0.f};
+    return data()[indiceMasCercano(objetivo)];
+}
+
+uint32_t StaticKDTree::nearestId(const Punto2D& objetivo) const {
+    if (n == 0) return KDTree::SIN_ID;
+    return ids()[indiceMasCercano(objetivo)];
+}
+
+// ============ K VECINOS MAS CERCANOS
+// Devuelve (distancia, indice) ordenados de menor a mayor distancia
+vector<pair<float, size_t>> StaticKDTree::kIndices(const Punto2D& objetivo, int k) const {
+    vector<pair<float, size_t>> pq;  // max-heap de tamano k
+    if (n == 0 || k <= 0) return pq;
+
+    const Punto2D* datos = data();
+    pq.reserve(k);
+
+    Pendiente pila[ALTURA_MAXIMA];
+    int tope = 0;
+    pila[tope++] = {0, 0, 0.f};
+
+    while (tope > 0) {
+        Pendiente actual = pila[--tope];
+        if (pq.size() == (size_t)k && actual.distanciaPlano >= pq.front().first) continue;
+
+        size_t i = actual.indice;
+        int eje = actual.eje;
+        while (i < n) {
+            prefetchNietos(datos, i, n);
+            const Punto2D& p = datos[i];
+
+            float d = distanciaCuadrado(objetivo, p);
+            if (pq.size() < (size_t)k) {
+                pq.push_back({d, i});
+                push_heap(pq.begin(), pq.end());
+            } else if (d < pq.front().first) {
+                pop_heap(pq.begin(), pq.end());
+                pq.back() = {d, i};
+                push_heap(pq.begin(), pq.end());
+            }
+
+            float diff = coordenada(objetivo, eje) - coordenada(p, eje);
+            size_t lado = (diff >= 0.f);
+            size_t lejano = 2 * i + 2 - lado;
+            if (lejano < n && (pq.size() < (size_t)k || diff * diff < pq.front().first)) {
+                pila[tope++] = {lejano, eje ^ 1, diff * diff};
+            }
+
+            i = 2 * i + 1 + lado;
+            eje ^= 1;
+        }
+    }
+
+    sort_heap(pq.begin(), pq.end());
+    return pq;
+}
+
+vector<Punto2D> StaticKDTree::kNearest(const Punto2D& objetivo, int k) const {
+    vector<Punto2D> resultado;
+    for (const auto& item : kIndices(objetivo, k)) resultado.push_back(data()[item.second]);
+    return resultado;
+}
+
+vector<uint32_t> StaticKDTree::kNearestIds(const Punto2D& objetivo, int k) const {
+    vector<uint32_t> resultado;
+    for (const auto& item : kIndices(objetivo, k)) resultado.push_back(ids()[item.second]);
+    return resultado;
+}
+
+// ============ BUSQUEDA POR RANGO
+vector<Punto2D> StaticKDTree::rangeSearch(const Rectangulo& rectangulo) const {
+    vector<Punto2D> resultado;
+    if (n == 0) return resultado;
+
+    const Punto2D* datos = data();
+    const float minimo[2] = {rectangulo.xmin, rectangulo.ymin};
+    const float maximo[2] = {rectangulo.xmax, rectangulo.ymax};
+
+    Pendiente pila[ALTURA_MAXIMA];
+    int tope = 0;
+    pila[tope++] = {0, 0, 0.f};
+
+    while (tope > 0) {
+        Pendiente actual = pila[--tope];
+        size_t i = actual.indice;
+        int eje = actual.eje;
+
+        while (i < n) {
+            prefetchNietos(datos, i, n);
+            const Punto2D& p = datos[i];
+
+            if (p.x >= rectangulo.xmin && p.x <= rectangulo.xmax &&
+                p.y >= rectangulo.ymin && p.y <= rectangulo.ymax) {
+                resultado.push_back(p);
+            }
+
+            float valor = coordenada(p, eje);
+            bool izquierda = (minimo[eje] <= valor) && (2 * i + 1 < n);
+            bool derecha = (maximo[eje] >= valor) && (2 * i + 2 < n);
+
+            // Si hay que visitar ambos, el derecho queda pendiente en la pila
+            if (izquierda && derecha) pila[tope++] = {2 * i + 2, eje ^ 1, 0.f};
+            if (izquierda) i = 2 * i + 1;
+            else if (derecha) i = 2 * i + 2;
+            else break;
+            eje ^= 1;
+        }
+    }
+
+    return resultado;
+}
+
+// ============ SNAPSHOT EN DISCO
+static constexpr char MAGIA_SNAPSHOT[8] = {'K', 'D', 'S', 'N', 'A', 'P', '0', '1'};
+static constexpr uint32_t VERSION_SNAPSHOT = 1;
+static constexpr uint32_t MARCA_ORDEN = 0x01020304;  // detecta otro orden de bytes
+static constexpr uint64_t ALINEACION_SECCION = 64;
+
+struct CabeceraSnapshot {
+    char magia[8];
+    uint32_t version;
+    uint32_t marcaOrden;
+    uint64_t n;
+    uint64_t desplazamientoPuntos;
+    uint64_t desplazamientoIds;
+    uint64_t longitud;          // tamano total del archivo
+    uint64_t checksumDatos;     // puntos seguidos de ids
+    uint64_t checksumCabecera;  // campos anteriores
+};
+static_assert(sizeof(CabeceraSnapshot) == 64, "cabecera de snapshot de 64 bytes");
+static_assert(sizeof(Punto2D) == 8, "Punto2D se vuelca como dos float");
+
+static constexpr uint64_t FNV_BASE = 14695981039346656037ull;
+
+static uint64_t fnv1a(const void* datos, size_t bytes, uint64_t h = FNV_BASE) {
+    const unsigned char* p = static_cast<const unsigned char*>(datos);
+    for (size_t i = 0; i < bytes; i++) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+static uint64_t alinear(uint64_t valor) {
+    return (valor + ALINEACION_SECCION - 1) / ALINEACION_SECCION * ALINEACION_SECCION;
+}
+
+static uint64_t checksumCabecera(const CabeceraSnapshot& c) {
+    return fnv1a(&c, offsetof(CabeceraSnapshot, checksumCabecera));
+}
+
+// Se escribe en ruta.tmp y se renombra: un proceso que tenga mapeada la
+// version anterior la sigue viendo intacta (reescribirla in situ daria SIGBUS).
+EstadoSnapshot StaticKDTree::saveSnapshot(const string& ruta) const {
+    const Punto2D* puntos = data();
+    const uint32_t* identificadoresDatos = ids();
+
+    CabeceraSnapshot cabecera{};
+    memcpy(cabecera.magia, MAGIA_SNAPSHOT, sizeof(MAGIA_SNAPSHOT));
+    cabecera.version = VERSION_SNAPSHOT;
+    cabecera.marcaOrden = MARCA_ORDEN;
+    cabecera.n = n;
+    cabecera.desplazamientoPuntos = alinear(sizeof(CabeceraSnapshot));
+    cabecera.desplazamientoIds = alinear(cabecera.desplazamientoPuntos + n * sizeof(Punto2D));
+    cabecera.longitud = cabecera.desplazamientoIds + n * sizeof(uint32_t);
+    cabecera.checksumDatos = fnv1a(identificadoresDatos, n * sizeof(uint32_t),
+                                   fnv1a(puntos, n * sizeof(Punto2D)));
+    cabecera.checksumCabecera = checksumCabecera(cabecera);
+
+    string temporal = ruta + ".tmp";
+    FILE* archivo = fopen(temporal.c_str(), "wb");
+    if (!archivo) return EstadoSnapshot::ErrorES;
+
+    static const char relleno[ALINEACION_SECCION] = {};
+    auto escribir = [archivo](const void* datos, size_t bytes) {
+        return bytes == 0 || fwrite(datos, 1, bytes, archivo) == bytes;
+    };
+    uint64_t finPuntos = cabecera.desplazamientoPuntos + n * sizeof(Punto2D);
+    bool ok = escribir(&cabecera, sizeof(cabecera)) &&
+              escribir(relleno, cabecera.desplazamientoPuntos - sizeof(cabecera)) &&
+              escribir(puntos, n * sizeof(Punto2D)) &&
+              escribir(relleno, cabecera.desplazamientoIds - finPuntos) &&
+              escribir(identificadoresDatos, n * sizeof(uint32_t));
+    ok = (fclose(archivo) == 0) && ok;
+
+    if (!ok || rename(temporal.c_str(), ruta.c_str()) != 0) {
+        remove(temporal.c_str());
+        return EstadoSnapshot::ErrorES;
+    }
+    return EstadoSnapshot::Ok;
+}
+
+// Valida la cabecera frente al tamano real del archivo. El checksum FNV-1a
+// detecta corrupcion, no manipulacion: los limites se comprueban restando
+// (c.n * tamano no desborda, c.n esta acotado por la longitud) para que un
+// desplazamiento cercano a 2^64 no de la vuelta y apunte fuera del archivo.
+static EstadoSnapshot validarCabecera(const CabeceraSnapshot& c, uint64_t longitudArchivo) {
+    if (memcmp(c.magia, MAGIA_SNAPSHOT, sizeof(MAGIA_SNAPSHOT)) != 0) return EstadoSnapshot::FormatoInvalido;
+    if (c.version != VERSION_SNAPSHOT || c.marcaOrden != MARCA_ORDEN) return EstadoSnapshot::VersionIncompatible;
+    if (c.checksumCabecera != checksumCabecera(c)) return EstadoSnapshot::ChecksumInvalido;
+
+    bool coherente = c.longitud == longitudArchivo && c.n <= longitudArchivo / sizeof(Punto2D) &&
+                     c.desplazamientoPuntos % ALINEACION_SECCION == 0 &&
+                     c.desplazamientoIds % ALINEACION_SECCION == 0 &&
+                     c.desplazamientoPuntos >= sizeof(CabeceraSnapshot) &&
+                     c.desplazamientoPuntos <= c.longitud && c.desplazamientoIds <= c.longitud &&
+                     c.desplazamientoPuntos <= c.desplazamientoIds &&
+                     c.n * sizeof(Punto2D) <= c.desplazamientoIds - c.desplazamientoPuntos &&
+                     c.n * sizeof(uint32_t) <= c.longitud - c.desplazamientoIds;
+    return coherente ? EstadoSnapshot::Ok : EstadoSnapshot::FormatoInvalido;
+}
+
+EstadoSnapshot StaticKDTree::openSnapshot(const string& ruta, bool verificarDatos) {
+    *this = StaticKDTree();
+
+    MappedFile archivo;
+    if (!archivo.open(ruta)) return EstadoSnapshot::ErrorES;
+    if (archivo.size() < sizeof(CabeceraSnapshot)) return EstadoSnapshot::FormatoInvalido;
+
+    CabeceraSnapshot cabecera;
+    memcpy(&cabecera, archivo.data(), sizeof(cabecera));
+    EstadoSnapshot estado = validarCabecera(cabecera, archivo.size());
+    if (estado != EstadoSnapshot::Ok) return estado;
+
+    const char* puntos = archivo.data() + cabecera.desplazamientoPuntos;
+    const char* identificadoresDatos = archivo.data() + cabecera.desplazamientoIds;
+    if (verificarDatos) {
+        uint64_t h = fnv1a(identificadoresDatos, cabecera.n * sizeof(uint32_t),
+                           fnv1a(puntos, cabecera.n * sizeof(Punto2D)));
+        if (h != cabecera.checksumDatos) return EstadoSnapshot::ChecksumInvalido;
+    }
+
+    n = cabecera.n;
+    puntosMapeados = reinterpret_cast<const Punto2D*>(puntos);
+    idsMapeados = reinterpret_cast<const uint32_t*>(identificadoresDatos);
+    mapeo = move(archivo);
+    return EstadoSnapshot::Ok;
+}
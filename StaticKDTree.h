@@ -0,0 +1,81 @@
+#pragma once
+#include "KDTree.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Resultado de saveSnapshot / openSnapshot
+enum class EstadoSnapshot {
+    Ok,
+    ErrorES,              // no se pudo abrir, escribir o mapear el archivo
+    FormatoInvalido,      // magia, tamanos o desplazamientos incoherentes
+    VersionIncompatible,  // otra version del formato o distinto orden de bytes
+    ChecksumInvalido,     // cabecera o datos corruptos
+};
+
+// Variante congelada (inmutable) del KD-tree para datos de solo lectura.
+//
+// Los puntos se guardan en un unico arreglo contiguo en orden BFS/Eytzinger:
+// el nodo i tiene hijos 2i+1 y 2i+2 y su eje es profundidad % 2, por lo que no
+// hay punteros ni campo de nivel (8 bytes por nodo frente a los 64 de KDNode).
+// El arbol es completo (izquierda-balanceado), altura floor(log2(n)) + 1.
+// Los ids van en un arreglo paralelo que solo leen nearestId / kNearestIds.
+//
+// Misma API de consulta que KDTree: nearest, kNearest, rangeSearch.
+//
+// Al no tener punteros, el arreglo se vuelca tal cual a disco (saveSnapshot)
+// y openSnapshot lo mapea en memoria de solo lectura: las consultas recorren
+// directamente las paginas del archivo, sin deserializar, y los procesos que
+// abren el mismo archivo comparten la cache de paginas.
+class StaticKDTree {
+public:
+    StaticKDTree() = default;
+    // El punto puntos[i] recibe el id i
+    explicit StaticKDTree(std::vector<Punto2D> puntos);
+    // Conserva los ids del arbol
+    explicit StaticKDTree(const KDTree& arbol);
+
+    Punto2D nearest(const Punto2D& objetivo) const;
+    std::vector<Punto2D> kNearest(const Punto2D& objetivo, int k) const;
+    std::vector<Punto2D> rangeSearch(const Rectangulo& rectangulo) const;
+    std::uint32_t nearestId(const Punto2D& objetivo) const;
+    std::vector<std::uint32_t> kNearestIds(const Punto2D& objetivo, int k) const;
+
+    std::size_t size() const { return n; }
+
+    // Puntos en orden Eytzinger (y sus ids en el mismo orden)
+    const Punto2D* data() const { return isMapped() ? puntosMapeados : nodos.data(); }
+    const std::uint32_t* ids() const { return isMapped() ? idsMapeados : identificadores.data(); }
+
+    // Formato de archivo (version 1, orden de bytes nativo):
+    //  - cabecera de 64 bytes: magia "KDSNAP01", version, n, desplazamientos de
+    //    las secciones, checksum de los datos y checksum de la propia cabecera
+    //  - puntos (n x 8 bytes) y ids (n x 4 bytes), cada seccion alineada a 64
+    // Los checksums son FNV-1a de 64 bits.
+    EstadoSnapshot saveSnapshot(const std::string& ruta) const;
+
+    // Sustituye el contenido por el archivo mapeado. La cabecera se valida
+    // siempre (O(1)); verificarDatos recorre ademas todas las paginas para
+    // comprobar el checksum de los datos (O(n), deshace el arranque inmediato).
+    // Si falla, el arbol queda vacio.
+    EstadoSnapshot openSnapshot(const std::string& ruta, bool verificarDatos = false);
+
+    // true si los datos vienen de un archivo mapeado
+    bool isMapped() const { return mapeo.isOpen(); }
+
+private:
+    std::size_t n = 0;
+    std::vector<Punto2D> nodos;
+    std::vector<std::uint32_t> identificadores;
+
+    // Archivo mapeado (compartido entre copias)
+    MappedFile mapeo;
+    const Punto2D* puntosMapeados = nullptr;
+    const std::uint32_t* idsMapeados = nullptr;
+
+    std::size_t indiceMasCercano(const Punto2D& objetivo) const;
+    std::vector<std::pair<float, std::size_t>> kIndices(const Punto2D& objetivo, int k) const;
+};
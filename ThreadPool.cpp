@@ -0,0 +1,102 @@
+#include "ThreadPool.h"
+
+// Identifica el pool y la cola del trabajador que ejecuta el hilo actual
+static thread_local const ThreadPool* poolActual = nullptr;
+static thread_local std::size_t indiceActual = 0;
+
+ThreadPool::ThreadPool(unsigned hilos) {
+    if (hilos == 0) hilos = std::thread::hardware_concurrency();
+    if (hilos == 0) hilos = 1;
+    totalHilos = hilos;
+
+    // hilos - 1 trabajadores + cola de inyeccion (el llamador es el hilo restante)
+    for (unsigned i = 0; i < hilos; i++) colas.push_back(std::make_unique<Cola>());
+    for (unsigned i = 0; i + 1 < hilos; i++) {
+        trabajadores.emplace_back([this, i] { bucleTrabajador(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutexSueno);
+        detener = true;
+    }
+    cvSueno.notify_all();
+    for (auto& t : trabajadores) t.join();
+}
+
+std::size_t ThreadPool::colaPropia() const {
+    return (poolActual == this) ? indiceActual : colas.size() - 1;
+}
+
+void ThreadPool::submit(TaskGroup& grupo, std::function<void()> tarea) {
+    grupo.pendientes.fetch_add(1, std::memory_order_relaxed);
+    auto envuelta = [&grupo, tarea = std::move(tarea)] {
+        tarea();
+        grupo.pendientes.fetch_sub(1, std::memory_order_acq_rel);
+    };
+
+    Cola& cola = *colas[colaPropia()];
+    {
+        std::lock_guard<std::mutex> lock(cola.mutex);
+        cola.tareas.push_back(std::move(envuelta));
+    }
+    tareasEnCola.fetch_add(1, std::memory_order_release);
+    if (!trabajadores.empty()) {
+        // Tomar el mutex evita perder la notificacion frente a un trabajador
+        // que acaba de comprobar tareasEnCola y esta por dormirse
+        { std::lock_guard<std::mutex> lock(mutexSueno); }
+        cvSueno.notify_one();
+    }
+}
+
+bool ThreadPool::ejecutarUna(std::size_t propia) {
+    std::function<void()> tarea;
+
+    // Paso 1: cola propia por el final (LIFO)
+    {
+        Cola& cola = *colas[propia];
+        std::lock_guard<std::mutex> lock(cola.mutex);
+        if (!cola.tareas.empty()) {
+            tarea = std::move(cola.tareas.back());
+            cola.tareas.pop_back();
+        }
+    }
+
+    // Paso 2: robar por el frente (FIFO) de las demas colas
+    for (std::size_t i = 1; !tarea && i <= colas.size(); i++) {
+        Cola& victima = *colas[(propia + i) % colas.size()];
+        std::lock_guard<std::mutex> lock(victima.mutex);
+        if (!victima.tareas.empty()) {
+            tarea = std::move(victima.tareas.front());
+            victima.tareas.pop_front();
+        }
+    }
+
+    if (!tarea) return false;
+    tareasEnCola.fetch_sub(1, std::memory_order_acq_rel);
+    tarea();
+    return true;
+}
+
+void ThreadPool::wait(TaskGroup& grupo) {
+    std::size_t propia = colaPropia();
+    while (grupo.pendientes.load(std::memory_order_acquire) != 0) {
+        if (!ejecutarUna(propia)) std::this_thread::yield();
+    }
+}
+
+void ThreadPool::bucleTrabajador(std::size_t indice) {
+    poolActual = this;
+    indiceActual = indice;
+
+    while (true) {
+        if (ejecutarUna(indice)) continue;
+
+        std::unique_lock<std::mutex> lock(mutexSueno);
+        cvSueno.wait(lock, [this] {
+            return detener || tareasEnCola.load(std::memory_order_acquire) != 0;
+        });
+        if (detener) return;
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Grupo de tareas fork-join: cuenta las tareas pendientes enviadas al pool.
+// Una tarea puede enviar nuevas tareas al mismo grupo (paralelismo anidado).
+struct TaskGroup {
+    std::atomic<std::size_t> pendientes{0};
+};
+
+// Pool de hilos con robo de trabajo (work-stealing).
+// Cada trabajador tiene su propia cola: empuja y saca por el final (LIFO, datos
+// calientes en cache) y los demas le roban por el frente (FIFO, las tareas mas
+// grandes). El hilo que llama a wait() tambien ejecuta tareas mientras espera,
+// por lo que ThreadPool(1) no crea hilos y todo corre en el hilo llamador.
+class ThreadPool {
+public:
+    // hilos = numero total de hilos que participan (incluido el llamador).
+    // 0 = std::thread::hardware_concurrency().
+    explicit ThreadPool(unsigned hilos = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return totalHilos; }
+
+    void submit(TaskGroup& grupo, std::function<void()> tarea);
+
+    // Bloquea hasta que el grupo no tenga tareas pendientes, ejecutando tareas
+    // (propias o robadas) mientras tanto.
+    void wait(TaskGroup& grupo);
+
+    // Ejecuta f(inicio, fin) sobre bloques de [0, n) de tamano <= grano.
+    template <class F>
+    void parallelFor(std::size_t n, std::size_t grano, F&& f) {
+        if (grano == 0) grano = 1;
+        TaskGroup grupo;
+        for (std::size_t inicio = 0; inicio < n; inicio += grano) {
+            std::size_t fin = (n - inicio < grano) ? n : inicio + grano;
+            submit(grupo, [&f, inicio, fin] { f(inicio, fin); });
+        }
+        wait(grupo);
+    }
+
+private:
+    struct Cola {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tareas;
+    };
+
+    unsigned totalHilos;
+    // colas[i] pertenece al trabajador i; la ultima es la cola de inyeccion
+    // usada por los hilos que no pertenecen al pool.
+    std::vector<std::unique_ptr<Cola>> colas;
+    std::vector<std::thread> trabajadores;
+
+    std::atomic<bool> detener{false};
+    std::atomic<std::size_t> tareasEnCola{0};
+    std::mutex mutexSueno;
+    std::condition_variable cvSueno;
+
+    std::size_t colaPropia() const;
+    bool ejecutarUna(std::size_t propia);
+    void bucleTrabajador(std::size_t indice);
+};
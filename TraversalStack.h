@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Pila explicita para recorrer el arbol sin recursion.
+// Las primeras N entradas viven en un arreglo de tamano fijo (sin reservas de
+// memoria en arboles balanceados, cuya pila nunca supera la altura); solo un
+// arbol degenerado mas profundo que N desborda a un std::vector, de modo que
+// la profundidad maxima ya no depende de la pila de llamadas del hilo.
+template <class T, std::size_t N = 64>
+class TraversalStack {
+public:
+    void push(T valor) {
+        if (tope < N) enLinea[tope] = valor;
+        else desborde.push_back(valor);
+        tope++;
+    }
+
+    T pop() {
+        tope--;
+        if (tope < N) return enLinea[tope];
+        T valor = desborde.back();
+        desborde.pop_back();
+        return valor;
+    }
+
+    bool empty() const { return tope == 0; }
+    std::size_t size() const { return tope; }
+
+private:
+    T enLinea[N];
+    std::vector<T> desborde;
+    std::size_t tope = 0;
+};
@@ -1067,9 +1067,13 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
     // Estado demo (hospital)
     bool demoLoaded = false;
     std::vector<float> puntosAge; // edad por punto, alineado con 'puntos'
+    // El id de cada punto en el arbol es su indice en 'puntos': los borrados no
+    // se sacan del vector (los indices siguen siendo validos), solo se marcan
+    std::vector<char> eliminado(puntos.size(), 0);
     std::vector<int> demoNeighbors; // indices de vecinos resaltados
     int selectedIndex = -1;
     int demoK = 5;
+    const float DEMO_RANGO_EDAD = 10.f; // vecinos resaltados: edad +-10 respecto al seleccionado
 
     while (window.isOpen()) {
         // Avance automático de animación
@@ -1170,8 +1174,9 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                             float rx = std::stof(inputX);
                             float ry = std::stof(inputY);
                             Punto2D p{rx, ry};
-                            tree.insert(p);
+                            tree.insert(p, (std::uint32_t)puntos.size());
                             puntos.push_back(p);
+                            eliminado.push_back(0);
                             inputX.clear(); inputY.clear();
                         }
                     } catch(...){}
@@ -1203,16 +1208,10 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                                 
                                 if (deleteMode) {
                                     // Método 2: Eliminar por coordenadas
-                                    bool found = false;
-                                    int foundIdx = -1;
-                                    for (size_t i = 0; i < puntos.size(); ++i) {
-                                        if (std::abs(puntos[i].x - p.x) < 0.01f && 
-                                            std::abs(puntos[i].y - p.y) < 0.01f) {
-                                            found = true;
-                                            foundIdx = i;
-                                            break;
-                                        }
-                                    }
+                                    std::uint32_t foundIdx = tree.nearestId(p);
+                                    bool found = foundIdx != KDTree::SIN_ID &&
+                                                 std::abs(puntos[foundIdx].x - p.x) < 0.01f &&
+                                                 std::abs(puntos[foundIdx].y - p.y) < 0.01f;
                                     
                                     if (found) {
                                         // Eliminar
@@ -1221,11 +1220,8 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                                         animState.stepClock.restart();
                                         animState.paused = false;
                                         
-                                        tree.remove(p);
-                                        puntos.erase(puntos.begin() + foundIdx);
-                                        if (demoLoaded && foundIdx < (int)puntosAge.size()) {
-                                            puntosAge.erase(puntosAge.begin() + foundIdx);
-                                        }
+                                        tree.remove(puntos[foundIdx], foundIdx);
+                                        eliminado[foundIdx] = 1;
                                         
                                         inputX.clear(); inputY.clear();
                                         std::cout << "Punto eliminado (coords): (" << p.x << ", " << p.y << ")\n";
@@ -1244,11 +1240,12 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                                     
                                     // Medir tiempo de inserción
                                     auto start = std::chrono::high_resolution_clock::now();
-                                    tree.insert(p); 
+                                    tree.insert(p, (std::uint32_t)puntos.size());
                                     auto end = std::chrono::high_resolution_clock::now();
                                     animState.executionTimeMicros = std::chrono::duration<double, std::micro>(end - start).count();
                                     
-                                    puntos.push_back(p); 
+                                    puntos.push_back(p);
+                                    eliminado.push_back(0);
                                     inputX.clear(); inputY.clear();
                                     
                                     std::cout << "Tiempo de ejecución insert: " << animState.executionTimeMicros << " us\n";
@@ -1287,9 +1284,7 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                                 try {
                                     // Reducir a 25 puntos para que quepan en el visualizador
                                     const int N = 25;
-                                    puntos.clear(); puntosAge.clear(); demoNeighbors.clear(); selectedIndex = -1;
-                                    // Reiniciar KDTree (nota: posibles fugas de memoria en demo, tolerable aquí)
-                                    tree = KDTree();
+                                    puntos.clear(); puntosAge.clear(); eliminado.clear(); demoNeighbors.clear(); selectedIndex = -1;
                                     std::random_device rd; std::mt19937 gen(rd());
                                     // Generar puntos repartidos uniformemente en todo el rango del plano
                                     // dejar un pequeño margen interior (2% del MAX_COORD)
@@ -1301,8 +1296,10 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                                         Punto2D p{distX(gen), distY(gen)};
                                         puntos.push_back(p);
                                         puntosAge.push_back(distA(gen));
-                                        tree.insert(p);
+                                        eliminado.push_back(0);
                                     }
+                                    // Reconstruir el KDTree balanceado (mediana) con el dataset completo y la edad como atributo
+                                    tree.build(puntos, puntosAge);
                                     demoLoaded = true;
                                     std::cout << "Demo cargado: " << N << " puntos\n";
                                 } catch(...){}
@@ -1342,6 +1339,9 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                     } else {
                         // click in plane
                         int mx = mouse->position.x; int my = mouse->position.y;
+                        // Punto del plano bajo el cursor
+                        float realX = (float)(mx - PLANE_ORIGIN_X) / PLANE_WIDTH * MAX_COORD;
+                        float realY = (1.f - (float)(my - PLANE_ORIGIN_Y) / PLANE_HEIGHT) * MAX_COORD;
                         if (mx >= (int)PLANE_ORIGIN_X && mx <= (int)(PLANE_ORIGIN_X + PLANE_WIDTH)
                             && my >= (int)PLANE_ORIGIN_Y && my <= (int)(PLANE_ORIGIN_Y + PLANE_HEIGHT)) {
                             
@@ -1357,8 +1357,6 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                                 try {
                                     int k = std::stoi(inputK);
                                     if (k > 0 && tree.getRoot() != nullptr) {
-                                        float realX = (float)(mx - PLANE_ORIGIN_X) / PLANE_WIDTH * MAX_COORD;
-                                        float realY = (1.f - (float)(my - PLANE_ORIGIN_Y) / PLANE_HEIGHT) * MAX_COORD;
                                         Punto2D target{realX, realY};
                                         knnState.puntoObjetivo = target;
                                         
@@ -1387,18 +1385,14 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                                 // Método 1: Click directo en punto
                                 if (inputX.empty() && inputY.empty()) {
                                     // Buscar punto más cercano al click
-                                    if (!puntos.empty()) {
-                                        float bestDist2 = 1e12f;
-                                        int bestIdx = -1;
-                                        for (size_t i = 0; i < puntos.size(); ++i) {
-                                            sf::Vector2f sp = mapToPlane(puntos[i]);
-                                            float dx = sp.x - mpos.x;
-                                            float dy = sp.y - mpos.y;
-                                            float d2 = dx*dx + dy*dy;
-                                            if (d2 < bestDist2) { bestDist2 = d2; bestIdx = (int)i; }
-                                        }
+                                    std::uint32_t bestIdx = tree.nearestId({realX, realY});
+                                    if (bestIdx != KDTree::SIN_ID) {
+                                        sf::Vector2f sp = mapToPlane(puntos[bestIdx]);
+                                        float dx = sp.x - mpos.x;
+                                        float dy = sp.y - mpos.y;
+                                        float bestDist2 = dx*dx + dy*dy;
                                         const float PICK_RADIUS = 15.f;
-                                        if (bestIdx >= 0 && bestDist2 <= PICK_RADIUS*PICK_RADIUS) {
+                                        if (bestDist2 <= PICK_RADIUS*PICK_RADIUS) {
                                             Punto2D pToDelete = puntos[bestIdx];
                                             
                                             // Generar animación
@@ -1408,11 +1402,8 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                                             animState.paused = false;
                                             
                                             // Eliminar del árbol y del vector
-                                            tree.remove(pToDelete);
-                                            puntos.erase(puntos.begin() + bestIdx);
-                                            if (demoLoaded && bestIdx < (int)puntosAge.size()) {
-                                                puntosAge.erase(puntosAge.begin() + bestIdx);
-                                            }
+                                            tree.remove(pToDelete, bestIdx);
+                                            eliminado[bestIdx] = 1;
                                             
                                             std::cout << "Punto eliminado (click): (" << pToDelete.x << ", " << pToDelete.y << ")\n";
                                         }
@@ -1420,18 +1411,18 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                                 }
                             } else {
                                 // Si modo demo cargado: seleccionar punto cercano en vez de insertar
-                                if (demoLoaded && !puntos.empty()) {
-                                    float bestDist2 = 1e12f; int bestIdx = -1;
-                                    for (size_t i=0;i<puntos.size();++i) {
-                                        sf::Vector2f sp = mapToPlane(puntos[i]);
+                                if (demoLoaded) {
+                                    std::uint32_t bestIdx = tree.nearestId({realX, realY});
+                                    float bestDist2 = 1e12f;
+                                    if (bestIdx != KDTree::SIN_ID) {
+                                        sf::Vector2f sp = mapToPlane(puntos[bestIdx]);
                                         float dx = sp.x - mpos.x; float dy = sp.y - mpos.y;
-                                        float d2 = dx*dx + dy*dy;
-                                        if (d2 < bestDist2) { bestDist2 = d2; bestIdx = (int)i; }
+                                        bestDist2 = dx*dx + dy*dy;
                                     }
                                     const float PICK_RADIUS = 10.f;
-                                    if (bestIdx >= 0 && bestDist2 <= PICK_RADIUS*PICK_RADIUS) {
+                                    if (bestDist2 <= PICK_RADIUS*PICK_RADIUS) {
                                         // Seleccionado paciente
-                                        selectedIndex = bestIdx;
+                                        selectedIndex = (int)bestIdx;
                                         Punto2D target = puntos[selectedIndex];
 
                                         // Generar animación nearest
@@ -1449,29 +1440,25 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
                                         animState.executionTimeMicros = std::chrono::duration<double, std::micro>(end - start).count();
                                         animState.foundNearest = nn; animState.hasResult = true;
 
-                                        // Calcular k vecinos por fuerza bruta (2D)
+                                        // k vecinos de edad parecida (el primero es el propio paciente): los ids son
+                                        // indices de 'puntos'; el arbol poda los subarboles sin edades en el rango
+                                        float edad = (selectedIndex < (int)puntosAge.size()) ? puntosAge[selectedIndex] : 45.f;
+                                        FiltroAtributo edadParecida{edad - DEMO_RANGO_EDAD, edad + DEMO_RANGO_EDAD};
                                         demoNeighbors.clear();
-                                        std::vector<std::pair<float,int>> tmp;
-                                        for (size_t i=0;i<puntos.size();++i) {
-                                            if ((int)i == selectedIndex) continue;
-                                            float dx = puntos[i].x - target.x; float dy = puntos[i].y - target.y;
-                                            tmp.push_back({dx*dx+dy*dy, (int)i});
+                                        for (std::uint32_t id : tree.kNearestIds(target, demoK + 1, edadParecida)) {
+                                            if ((int)id != selectedIndex && (int)demoNeighbors.size() < demoK) demoNeighbors.push_back((int)id);
                                         }
-                                        std::sort(tmp.begin(), tmp.end());
-                                        for (int k=0;k<demoK && k<(int)tmp.size(); ++k) demoNeighbors.push_back(tmp[k].second);
 
                                         std::cout << "Paciente seleccionado: idx=" << selectedIndex << ", tiempo nearest: " << animState.executionTimeMicros << " us\n";
                                     } else {
                                         // No cercano: insertar nuevo punto
-                                        float realX = (float)(mx - PLANE_ORIGIN_X) / PLANE_WIDTH * MAX_COORD;
-                                        float realY = (1.f - (float)(my - PLANE_ORIGIN_Y) / PLANE_HEIGHT) * MAX_COORD;
-                                        Punto2D p{realX, realY}; tree.insert(p); puntos.push_back(p); puntosAge.push_back(45.f);
+                                        Punto2D p{realX, realY}; tree.insert(p, (std::uint32_t)puntos.size(), 45.f);
+                                        puntos.push_back(p); puntosAge.push_back(45.f); eliminado.push_back(0);
                                     }
                                 } else {
                                     // Insertar punto por coordenadas
-                                    float realX = (float)(mx - PLANE_ORIGIN_X) / PLANE_WIDTH * MAX_COORD;
-                                    float realY = (1.f - (float)(my - PLANE_ORIGIN_Y) / PLANE_HEIGHT) * MAX_COORD;
-                                    Punto2D p{realX, realY}; tree.insert(p); puntos.push_back(p);
+                                    Punto2D p{realX, realY}; tree.insert(p, (std::uint32_t)puntos.size());
+                                    puntos.push_back(p); eliminado.push_back(0);
                                 }
                             }
                         }
@@ -1607,6 +1594,7 @@ void runVisualizer(KDTree& tree, std::vector<Punto2D>& puntos) {
         }
 
         for (size_t i = 0; i < puntos.size(); ++i) {
+            if (eliminado[i]) continue;
             const auto &p = puntos[i];
             sf::Color col = sf::Color::Red;
             float radius = 5.f;
@@ -0,0 +1,125 @@
+// Vecinos aproximados: recall frente a latencia de nearestApprox / kNearestApprox
+// con distintos epsilon y presupuestos de nodos.
+//
+// Uso: kdtree-bench-approx [n_puntos=1000000] [k=8]
+//
+// Datos en 50 cumulos gaussianos y consultas uniformes: muchas consultas caen
+// lejos de todo cumulo, el caso en que la busqueda exacta visita mas nodos.
+// Columnas (una fila por configuracion, lista para graficar recall vs latencia):
+//  - media / p99: ns por consulta
+//  - recall: fraccion de vecinos exactos recuperados (k-NN: sobre los k)
+//  - ratio: distancia devuelta / distancia exacta, media (k-NN: del k-esimo)
+//  - exactas: fraccion de consultas con informe.exacto
+#include "KDTree.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+struct Configuracion {
+    float epsilon;
+    size_t maxNodos;
+};
+
+static const Configuracion CONFIGURACIONES[] = {
+    {0.0f, 0},   {0.1f, 0},   {0.5f, 0},   {1.0f, 0},   {2.0f, 0},
+    {0.0f, 256}, {0.0f, 128}, {0.0f, 64},  {0.0f, 32},  {0.0f, 16},
+    {0.5f, 64},  {0.5f, 32},
+};
+
+static float distancia(const Punto2D& a, const Punto2D& b) {
+    return std::sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
+}
+
+static void imprimirFila(const char* consulta, const Configuracion& c, std::vector<double>& latencias,
+                         double recall, double ratio, size_t exactas) {
+    std::sort(latencias.begin(), latencias.end());
+    double media = 0;
+    for (double l : latencias) media += l;
+    media /= latencias.size();
+    double p99 = latencias[latencias.size() * 99 / 100];
+    std::printf("%-6s %8.2f %9zu %10.0f %10.0f %8.4f %8.4f %8.4f\n", consulta, c.epsilon, c.maxNodos,
+                media, p99, recall / latencias.size(), ratio / latencias.size(),
+                (double)exactas / latencias.size());
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    int k = (argc > 2) ? std::atoi(argv[2]) : 8;
+    const size_t numConsultas = 20000;
+
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<float> uniforme(0.f, 1000.f);
+    std::normal_distribution<float> normal(0.f, 5.f);
+    std::vector<Punto2D> centros(50);
+    for (auto& c : centros) c = {uniforme(gen), uniforme(gen)};
+    std::vector<Punto2D> puntos(n);
+    for (auto& p : puntos) {
+        const Punto2D& c = centros[gen() % centros.size()];
+        p = {c.x + normal(gen), c.y + normal(gen)};
+    }
+    KDTree tree(puntos);
+
+    std::vector<Punto2D> consultas(numConsultas);
+    for (auto& q : consultas) q = {uniforme(gen), uniforme(gen)};
+
+    // Referencia exacta
+    std::vector<Punto2D> exactoNN(numConsultas);
+    std::vector<std::vector<Punto2D>> exactoKNN(numConsultas);
+    for (size_t i = 0; i < numConsultas; i++) {
+        exactoNN[i] = tree.nearest(consultas[i]);
+        exactoKNN[i] = tree.kNearest(consultas[i], k);
+    }
+
+    std::printf("n=%zu k=%d consultas=%zu (50 cumulos gaussianos, consultas uniformes)\n", n, k,
+                numConsultas);
+    std::printf("%-6s %8s %9s %10s %10s %8s %8s %8s\n", "tipo", "epsilon", "maxNodos", "media ns",
+                "p99 ns", "recall", "ratio", "exactas");
+
+    std::vector<double> latencias(numConsultas);
+    for (const Configuracion& c : CONFIGURACIONES) {
+        double recall = 0, ratio = 0;
+        size_t exactas = 0;
+        for (size_t i = 0; i < numConsultas; i++) {
+            InformeAproximado informe;
+            auto inicio = std::chrono::steady_clock::now();
+            Punto2D p = tree.nearestApprox(consultas[i], c.epsilon, c.maxNodos, &informe);
+            auto fin = std::chrono::steady_clock::now();
+            latencias[i] = std::chrono::duration<double, std::nano>(fin - inicio).count();
+
+            float dExacta = distancia(consultas[i], exactoNN[i]);
+            float dAprox = distancia(consultas[i], p);
+            recall += (dAprox <= dExacta) ? 1 : 0;
+            ratio += (dExacta > 0) ? dAprox / dExacta : 1;
+            exactas += informe.exacto;
+        }
+        imprimirFila("nn", c, latencias, recall, ratio, exactas);
+    }
+
+    for (const Configuracion& c : CONFIGURACIONES) {
+        double recall = 0, ratio = 0;
+        size_t exactas = 0;
+        for (size_t i = 0; i < numConsultas; i++) {
+            InformeAproximado informe;
+            auto inicio = std::chrono::steady_clock::now();
+            std::vector<Punto2D> vecinos = tree.kNearestApprox(consultas[i], k, c.epsilon, c.maxNodos, &informe);
+            auto fin = std::chrono::steady_clock::now();
+            latencias[i] = std::chrono::duration<double, std::nano>(fin - inicio).count();
+
+            // Un vecino cuenta como recuperado si no esta mas lejos que el k-esimo exacto
+            const std::vector<Punto2D>& exactos = exactoKNN[i];
+            float radioExacto = distancia(consultas[i], exactos.back());
+            size_t recuperados = 0;
+            for (const Punto2D& v : vecinos) recuperados += distancia(consultas[i], v) <= radioExacto;
+            recall += (double)recuperados / exactos.size();
+            float dAprox = vecinos.empty() ? radioExacto : distancia(consultas[i], vecinos.back());
+            ratio += (radioExacto > 0) ? dAprox / radioExacto : 1;
+            exactas += informe.exacto;
+        }
+        imprimirFila("knn", c, latencias, recall, ratio, exactas);
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Altura del arbol y coste de insert con auto-balanceo (chivo expiatorio) frente
+// a insert sin balanceo y al bosque logaritmico (KDForest), en ordenes de
+// llegada adversos.
+//
+// Uso: kdtree-bench-balance [n_puntos=1000000] [n_max_sin_balanceo=20000]
+//
+// Sin balanceo (alpha = 1) la entrada ordenada degenera en una lista y cada
+// insert cuesta O(n): por encima de n_max_sin_balanceo no se ejecuta.
+#include "KDForest.h"
+#include "KDTree.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// Ordenes de llegada: todos con coordenadas distintas salvo "sensor"
+static std::vector<Punto2D> generar(const char* orden, size_t n, unsigned semilla) {
+    std::mt19937 gen(semilla);
+    std::uniform_real_distribution<float> dist(0.f, 1000.f);
+    std::vector<Punto2D> puntos(n);
+    std::string nombre = orden;
+
+    if (nombre == "uniforme") {
+        for (auto& p : puntos) p = {dist(gen), dist(gen)};
+    } else if (nombre == "ordenado") {
+        for (size_t i = 0; i < n; i++) puntos[i] = {(float)i, (float)i};
+    } else if (nombre == "inverso") {
+        for (size_t i = 0; i < n; i++) puntos[i] = {(float)(n - i), (float)i};
+    } else if (nombre == "rafagas") {
+        // Casi ordenado: rafagas de 64 lecturas desordenadas dentro de una tendencia creciente en x
+        for (size_t i = 0; i < n; i++) puntos[i] = {(float)i + dist(gen) * 0.064f, dist(gen)};
+    } else {
+        // Sensor: marca de tiempo creciente en x, 16 niveles discretos en y
+        for (size_t i = 0; i < n; i++) puntos[i] = {(float)i, (float)(gen() % 16)};
+    }
+    return puntos;
+}
+
+static void medir(const char* orden, const std::vector<Punto2D>& puntos, float alpha) {
+    KDTree tree;
+    tree.setBalanceAlpha(alpha);
+
+    auto inicio = std::chrono::steady_clock::now();
+    for (const Punto2D& p : puntos) tree.insert(p);
+    auto fin = std::chrono::steady_clock::now();
+    double nsInsert = std::chrono::duration<double, std::nano>(fin - inicio).count() / puntos.size();
+
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<size_t> indice(0, puntos.size() - 1);
+    const int consultas = 100000;
+    volatile float sumidero = 0.f;
+    inicio = std::chrono::steady_clock::now();
+    for (int i = 0; i < consultas; i++) sumidero = sumidero + tree.nearest(puntos[indice(gen)]).x;
+    fin = std::chrono::steady_clock::now();
+    double nsNearest = std::chrono::duration<double, std::nano>(fin - inicio).count() / consultas;
+
+    EstadisticasBalance e = tree.balanceStats();
+    double log2n = std::log2((double)puntos.size());
+    std::printf("%-9s %5.2f %9zu %7d %9d %7.2f %8zu %9.2f %10.0f %10.0f\n", orden, alpha, puntos.size(),
+                e.altura, e.alturaPermitida, e.altura / log2n, e.reconstrucciones,
+                (double)e.nodosReconstruidos / puntos.size(), nsInsert, nsNearest);
+}
+
+// Bosque Bentley-Saxe: la altura es la del mayor arbol (perfectamente balanceado)
+static void medirBosque(const char* orden, const std::vector<Punto2D>& puntos) {
+    KDForest bosque;
+
+    auto inicio = std::chrono::steady_clock::now();
+    for (const Punto2D& p : puntos) bosque.insert(p);
+    auto fin = std::chrono::steady_clock::now();
+    double nsInsert = std::chrono::duration<double, std::nano>(fin - inicio).count() / puntos.size();
+
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<size_t> indice(0, puntos.size() - 1);
+    const int consultas = 100000;
+    volatile float sumidero = 0.f;
+    inicio = std::chrono::steady_clock::now();
+    for (int i = 0; i < consultas; i++) sumidero = sumidero + bosque.nearest(puntos[indice(gen)]).x;
+    fin = std::chrono::steady_clock::now();
+    double nsNearest = std::chrono::duration<double, std::nano>(fin - inicio).count() / consultas;
+
+    int altura = 0;
+    for (size_t i = 0; i < bosque.levels(); i++) {
+        if (bosque.tree(i).size() != 0) altura = std::max(altura, bosque.tree(i).balanceStats().altura);
+    }
+    double log2n = std::log2((double)puntos.size());
+    std::printf("%-9s %5s %9zu %7d %9s %7.2f %8zu %9.2f %10.0f %10.0f\n", orden, "bosque", puntos.size(),
+                altura, "-", altura / log2n, bosque.treeCount(), log2n, nsInsert, nsNearest);
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t maxSinBalanceo = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 20000;
+
+    std::printf("altura/log2 = c en altura <= c log2 n; reconstruidos/n = nodos reconstruidos por insert\n");
+    std::printf("bosque: altura del mayor arbol; reconstr = arboles en el bosque; recons/n = log2 n (cota)\n");
+    std::printf("%-9s %5s %9s %7s %9s %7s %8s %9s %10s %10s\n", "orden", "alpha", "n", "altura",
+                "permitida", "c", "reconstr", "recons/n", "ns insert", "ns nn");
+
+    for (const char* orden : {"uniforme", "ordenado", "inverso", "rafagas", "sensor"}) {
+        std::vector<Punto2D> puntos = generar(orden, n, 7);
+        std::vector<Punto2D> pocos(puntos.begin(), puntos.begin() + std::min(n, maxSinBalanceo));
+        medir(orden, pocos, 1.0f);
+        for (float alpha : {0.55f, 0.65f, 0.75f, 0.85f}) medir(orden, puntos, alpha);
+        medirBosque(orden, puntos);
+    }
+    return 0;
+}
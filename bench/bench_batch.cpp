@@ -0,0 +1,82 @@
+// Consultas por lotes: nearestBatch / kNearestBatch con y sin orden de Hilbert,
+// con 1..N hilos.
+//
+// Uso: kdtree-bench-batch [n_puntos=1000000] [consultas=200000] [hilos_max=0 (todos)]
+//
+// Puntos y consultas uniformes (las consultas en orden aleatorio). Para cada
+// numero de hilos (1, 2, 4, ... hasta hilos_max) se mide:
+//  - sin Hilbert: el mismo reparto del pool (bloques de 256 consultas) sobre
+//    las consultas en su orden original, llamando a nearest / kNearest
+//  - Hilbert: nearestBatch / kNearestBatch, que reordenan el lote
+// Columnas: ns por consulta (tiempo total del lote / consultas) de nearest y de
+// kNearest (k = 10). Sin Hilbert, kNearest reserva un vector por consulta y
+// kNearestBatch reutiliza un heap por bloque: parte de esa diferencia no es el orden.
+#include "KDTree.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+static constexpr int K = 10;
+static constexpr std::size_t BLOQUE = 256;  // el mismo bloque que usan los lotes
+
+template <class F>
+static double nsPorConsulta(std::size_t consultas, F&& lote) {
+    auto inicio = Reloj::now();
+    lote();
+    return std::chrono::duration<double, std::nano>(Reloj::now() - inicio).count() / consultas;
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? (size_t)std::strtod(argv[1], nullptr) : 1000000;
+    size_t totalConsultas = (argc > 2) ? (size_t)std::strtod(argv[2], nullptr) : 200000;
+    unsigned hilosMax = (argc > 3) ? (unsigned)std::strtoul(argv[3], nullptr, 10) : 0;
+    if (hilosMax == 0) hilosMax = std::max(1u, std::thread::hardware_concurrency());
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> uniforme(0.f, 1000.f);
+    std::vector<Punto2D> puntos(n), consultas(totalConsultas);
+    for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+    for (auto& q : consultas) q = {uniforme(gen), uniforme(gen)};
+    KDTree arbol(puntos);
+    std::vector<Punto2D> cercanos(totalConsultas), vecinos(totalConsultas * K);
+
+    std::printf("n=%zu consultas=%zu\n", n, totalConsultas);
+    std::printf("%6s %16s %16s %16s %16s\n", "hilos", "nearest sin H", "nearest Hilbert",
+                "kNearest sin H", "kNearest Hilbert");
+
+    std::vector<unsigned> configuraciones;
+    for (unsigned hilos = 1; hilos < hilosMax; hilos *= 2) configuraciones.push_back(hilos);
+    configuraciones.push_back(hilosMax);
+
+    for (unsigned hilos : configuraciones) {
+        ThreadPool pool(hilos);
+        double nnSin = nsPorConsulta(totalConsultas, [&] {
+            pool.parallelFor(totalConsultas, BLOQUE, [&](std::size_t inicio, std::size_t fin) {
+                for (std::size_t i = inicio; i < fin; i++) cercanos[i] = arbol.nearest(consultas[i]);
+            });
+        });
+        double nnHilbert = nsPorConsulta(totalConsultas, [&] {
+            arbol.nearestBatch(consultas.data(), totalConsultas, cercanos.data(), pool);
+        });
+        double knnSin = nsPorConsulta(totalConsultas, [&] {
+            pool.parallelFor(totalConsultas, BLOQUE, [&](std::size_t inicio, std::size_t fin) {
+                for (std::size_t i = inicio; i < fin; i++) {
+                    std::vector<Punto2D> fila = arbol.kNearest(consultas[i], K);
+                    std::copy(fila.begin(), fila.end(), vecinos.begin() + i * K);
+                }
+            });
+        });
+        double knnHilbert = nsPorConsulta(totalConsultas, [&] {
+            arbol.kNearestBatch(consultas.data(), totalConsultas, K, vecinos.data(), pool);
+        });
+        std::printf("%6u %16.1f %16.1f %16.1f %16.1f\n", hilos, nnSin, nnHilbert, knnSin, knnHilbert);
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Hojas agrupadas (BucketKDTree): barrido del tamano de hoja B y del nivel SIMD.
+//
+// Uso: kdtree-bench-bucket [n_puntos=4000000] [consultas=200000]
+//
+// Puntos y consultas uniformes. Para cada nivel de kernels disponible en la CPU
+// (escalar, SSE, AVX2) y cada B = 1, 2, 4, ..., 256 se construye el arbol una
+// vez y se miden nearest, kNearest (k = 10) y rangeSearch (cajas de ~100
+// puntos, un decimo de las consultas). B = 1 es el arbol sin hojas agrupadas.
+// Columnas: ns por consulta y, en nearest, la mejora frente a B = 1 del mismo
+// nivel.
+#include "BucketKDTree.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+static constexpr int K = 10;
+static constexpr float LADO = 1000.f;
+
+// ns por consulta de consultar(q) sobre las consultas dadas
+template <class F>
+static double medirNs(const std::vector<Punto2D>& consultas, F&& consultar) {
+    volatile float sumidero = 0;
+    auto inicio = Reloj::now();
+    for (const Punto2D& q : consultas) sumidero = sumidero + consultar(q);
+    return std::chrono::duration<double, std::nano>(Reloj::now() - inicio).count() / consultas.size();
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? (size_t)std::strtod(argv[1], nullptr) : 4000000;
+    size_t totalConsultas = (argc > 2) ? (size_t)std::strtod(argv[2], nullptr) : 200000;
+    if (n < (size_t)K) n = K;
+
+    std::mt19937 gen(6);
+    std::uniform_real_distribution<float> uniforme(0.f, LADO);
+    std::vector<Punto2D> puntos(n), consultas(totalConsultas), consultasRango(totalConsultas / 10 + 1);
+    for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+    for (auto& q : consultas) q = {uniforme(gen), uniforme(gen)};
+    for (auto& q : consultasRango) q = {uniforme(gen), uniforme(gen)};
+    float mitad = 0.5f * LADO * std::sqrt(100.f / n);
+
+    std::printf("n=%zu consultas=%zu activos=%s\n", n, totalConsultas, kernelsActivos().nombre);
+    std::printf("%-8s %5s %8s %12s %10s %12s %12s\n", "kernels", "B", "hojas", "nearest ns", "vs B=1",
+                "kNearest ns", "rango ns");
+
+    for (NivelSimd nivel : {NivelSimd::Escalar, NivelSimd::SSE, NivelSimd::AVX2}) {
+        const KernelsDistancia* kernels = kernelsPara(nivel);
+        if (kernels == nullptr) {
+            std::printf("%-8s no disponible\n", nivel == NivelSimd::SSE ? "SSE" : "AVX2");
+            continue;
+        }
+        double nearestB1 = 0;
+        for (int hoja = 1; hoja <= BucketKDTree::HOJA_MAXIMA; hoja *= 2) {
+            BucketKDTree arbol(puntos, hoja);
+            arbol.setKernels(*kernels);
+
+            double nn = medirNs(consultas, [&](const Punto2D& q) { return arbol.nearest(q).x; });
+            double knn = medirNs(consultas, [&](const Punto2D& q) { return arbol.kNearest(q, K).back().x; });
+            double rango = medirNs(consultasRango, [&](const Punto2D& q) {
+                return (float)arbol.rangeSearch({q.x - mitad, q.x + mitad, q.y - mitad, q.y + mitad}).size();
+            });
+            if (hoja == 1) nearestB1 = nn;
+            std::printf("%-8s %5d %8zu %12.1f %9.2fx %12.1f %12.1f\n", kernels->nombre, hoja,
+                        arbol.leafCount(), nn, nearestB1 / nn, knn, rango);
+        }
+    }
+    return 0;
+}
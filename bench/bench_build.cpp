@@ -0,0 +1,66 @@
+// Escalabilidad de la construccion en bloque: build() serial frente a
+// buildParallel() con 1..N hilos.
+//
+// Uso: kdtree-bench-build [n_puntos=10000000] [umbral_serial=16384] [repeticiones=3]
+#include "KDTree.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+static std::vector<Punto2D> generarUniforme(size_t n, unsigned semilla) {
+    std::mt19937 gen(semilla);
+    std::uniform_real_distribution<float> dist(0.f, 1000.f);
+    std::vector<Punto2D> puntos(n);
+    for (auto& p : puntos) p = {dist(gen), dist(gen)};
+    return puntos;
+}
+
+// Mejor tiempo (ms) de varias repeticiones; la copia de la entrada no se mide
+template <class F>
+static double medirMs(const std::vector<Punto2D>& puntos, int repeticiones, F&& construir) {
+    double mejor = 1e300;
+    for (int r = 0; r < repeticiones; r++) {
+        std::vector<Punto2D> copia = puntos;
+        KDTree tree;
+        auto inicio = std::chrono::steady_clock::now();
+        construir(tree, std::move(copia));
+        auto fin = std::chrono::steady_clock::now();
+        mejor = std::min(mejor, std::chrono::duration<double, std::milli>(fin - inicio).count());
+    }
+    return mejor;
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    size_t umbral = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : KDTree::UMBRAL_SERIAL;
+    int repeticiones = (argc > 3) ? std::atoi(argv[3]) : 3;
+
+    unsigned maxHilos = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<Punto2D> puntos = generarUniforme(n, 12345);
+
+    std::printf("n=%zu umbral_serial=%zu repeticiones=%d nucleos=%u\n", n, umbral, repeticiones, maxHilos);
+
+    double serialMs = medirMs(puntos, repeticiones, [](KDTree& t, std::vector<Punto2D> p) {
+        t.build(std::move(p));
+    });
+    std::printf("%-8s %10s %10s %10s\n", "hilos", "ms", "speedup", "Mpts/s");
+    std::printf("%-8s %10.1f %10.2f %10.2f\n", "serial", serialMs, 1.0, n / serialMs / 1e3);
+
+    std::vector<unsigned> hilos;
+    for (unsigned h = 1; h < maxHilos; h *= 2) hilos.push_back(h);
+    hilos.push_back(maxHilos);
+
+    for (unsigned h : hilos) {
+        ThreadPool pool(h);
+        double ms = medirMs(puntos, repeticiones, [&](KDTree& t, std::vector<Punto2D> p) {
+            t.buildParallel(std::move(p), pool, umbral);
+        });
+        std::printf("%-8u %10.1f %10.2f %10.2f\n", h, ms, serialMs / ms, n / ms / 1e3);
+    }
+    return 0;
+}
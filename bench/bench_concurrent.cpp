@@ -0,0 +1,113 @@
+// Lectores concurrentes con un escritor: KDTree protegido por un mutex global
+// frente a PersistentKDTree (snapshots sin cerrojo, escrituras con copia de camino).
+//
+// Uso: kdtree-bench-concurrent [n_puntos=1000000] [lectores=4] [segundos=2]
+//
+// Los lectores hacen nearest en bucle; el escritor alterna insert y remove sin
+// pausa. Se reporta el rendimiento de cada lado y la latencia p99 de lectura.
+#include "KDTree.h"
+#include "PersistentKDTree.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+struct Resultado {
+    double lecturasPorSegundo;
+    double escriturasPorSegundo;
+    double p99Ns;
+};
+
+// leer(q) y escribir(i) son las operaciones de cada variante
+template <class Leer, class Escribir>
+static Resultado medir(int lectores, double segundos, Leer&& leer, Escribir&& escribir) {
+    std::atomic<bool> fin{false};
+    std::vector<std::vector<double>> latencias(lectores);
+    std::vector<std::thread> hilos;
+    for (int l = 0; l < lectores; l++) {
+        hilos.emplace_back([&, l] {
+            std::mt19937 gen(l + 1);
+            std::uniform_real_distribution<float> dist(0.f, 1000.f);
+            volatile float sumidero = 0;
+            while (!fin.load(std::memory_order_relaxed)) {
+                Punto2D q{dist(gen), dist(gen)};
+                auto inicio = Reloj::now();
+                sumidero = sumidero + leer(q).x;
+                latencias[l].push_back(std::chrono::duration<double, std::nano>(Reloj::now() - inicio).count());
+            }
+        });
+    }
+
+    std::size_t escrituras = 0;
+    auto inicio = Reloj::now();
+    while (std::chrono::duration<double>(Reloj::now() - inicio).count() < segundos) {
+        escribir(escrituras++);
+    }
+    fin = true;
+    for (auto& h : hilos) h.join();
+    double transcurrido = std::chrono::duration<double>(Reloj::now() - inicio).count();
+
+    std::vector<double> todas;
+    for (auto& l : latencias) todas.insert(todas.end(), l.begin(), l.end());
+    std::sort(todas.begin(), todas.end());
+    double p99 = todas.empty() ? 0 : todas[todas.size() * 99 / 100];
+    return {todas.size() / transcurrido, escrituras / transcurrido, p99};
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    int lectores = (argc > 2) ? std::atoi(argv[2]) : 4;
+    double segundos = (argc > 3) ? std::atof(argv[3]) : 2.0;
+
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<float> dist(0.f, 1000.f);
+    std::vector<Punto2D> puntos(n), nuevos(1 << 20);
+    for (auto& p : puntos) p = {dist(gen), dist(gen)};
+    for (auto& p : nuevos) p = {dist(gen), dist(gen)};
+    std::size_t mascara = nuevos.size() - 1;
+
+    std::printf("n=%zu lectores=%d segundos=%.1f nucleos=%u\n", n, lectores, segundos,
+                std::thread::hardware_concurrency());
+    std::printf("%-14s %14s %14s %12s\n", "variante", "lecturas/s", "escrituras/s", "p99 lect ns");
+
+    {
+        KDTree tree(puntos);
+        tree.setLazyDeletion(true);
+        std::mutex cerrojo;
+        Resultado r = medir(
+            lectores, segundos,
+            [&](const Punto2D& q) {
+                std::lock_guard<std::mutex> guarda(cerrojo);
+                return tree.nearest(q);
+            },
+            [&](std::size_t i) {
+                std::lock_guard<std::mutex> guarda(cerrojo);
+                // Cada punto nuevo se borra al insertar el siguiente: el tamano se mantiene
+                if (i % 2 == 0) tree.insert(nuevos[(i / 2) & mascara]);
+                else tree.remove(nuevos[(i / 2) & mascara]);
+            });
+        std::printf("%-14s %14.0f %14.0f %12.0f\n", "mutex", r.lecturasPorSegundo, r.escriturasPorSegundo,
+                    r.p99Ns);
+    }
+
+    {
+        PersistentKDTree tree(puntos);
+        Resultado r = medir(
+            lectores, segundos,
+            [&](const Punto2D& q) { return tree.snapshot().nearest(q); },
+            [&](std::size_t i) {
+                if (i % 2 == 0) tree.insert(nuevos[(i / 2) & mascara]);
+                else tree.remove(nuevos[(i / 2) & mascara]);
+            });
+        std::printf("%-14s %14.0f %14.0f %12.0f\n", "persistente", r.lecturasPorSegundo,
+                    r.escriturasPorSegundo, r.p99Ns);
+    }
+    return 0;
+}
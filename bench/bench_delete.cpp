@@ -0,0 +1,79 @@
+// Rendimiento de remove: eliminacion inmediata (reemplazo por findMin) frente a
+// borrado perezoso con lapidas y compactacion, con distintos umbrales.
+//
+// Uso: kdtree-bench-delete [n_puntos=1000000] [fraccion_borrada=0.5]
+//
+// Se borra una fraccion de los puntos y despues se miden consultas nearest sobre
+// el arbol resultante (con las lapidas que queden). Dos ordenes de borrado:
+//  - aleatorio: casi todos los nodos borrados estan cerca de las hojas
+//  - por niveles: primero la raiz y los niveles altos, el peor caso de findMin
+//    (cada reemplazo recorre buena parte de un subarbol grande)
+#include "KDTree.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Puntos del arbol en recorrido por niveles (BFS)
+static std::vector<Punto2D> ordenPorNiveles(const KDTree& tree) {
+    std::vector<Punto2D> orden;
+    std::vector<KDNode*> cola;
+    if (tree.getRoot()) cola.push_back(tree.getRoot());
+    for (size_t i = 0; i < cola.size(); i++) {
+        orden.push_back(cola[i]->punto);
+        if (cola[i]->izquierdo) cola.push_back(cola[i]->izquierdo);
+        if (cola[i]->derecho) cola.push_back(cola[i]->derecho);
+    }
+    return orden;
+}
+
+static void medir(const char* nombre, const std::vector<Punto2D>& puntos, size_t borrar,
+                  bool perezoso, float umbral, bool porNiveles) {
+    KDTree tree(puntos);
+    tree.setLazyDeletion(perezoso);
+    tree.setCompactionThreshold(umbral);
+
+    std::vector<Punto2D> orden = puntos;
+    if (porNiveles) orden = ordenPorNiveles(tree);
+    else std::shuffle(orden.begin(), orden.end(), std::mt19937(5));
+
+    auto inicio = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < borrar; i++) tree.remove(orden[i]);
+    auto fin = std::chrono::steady_clock::now();
+    double nsRemove = std::chrono::duration<double, std::nano>(fin - inicio).count() / borrar;
+
+    std::mt19937 gen(9);
+    std::uniform_real_distribution<float> dist(0.f, 1000.f);
+    const int consultas = 200000;
+    volatile float sumidero = 0.f;
+    inicio = std::chrono::steady_clock::now();
+    for (int i = 0; i < consultas; i++) sumidero = sumidero + tree.nearest({dist(gen), dist(gen)}).x;
+    fin = std::chrono::steady_clock::now();
+    double nsNearest = std::chrono::duration<double, std::nano>(fin - inicio).count() / consultas;
+
+    EstadisticasBalance e = tree.balanceStats();
+    std::printf("%-10s %-10s %7.2f %10.0f %10.2f %10zu %8zu %10.0f\n", porNiveles ? "niveles" : "aleatorio", nombre, umbral, nsRemove,
+                1e3 / nsRemove, tree.tombstones(), e.reconstrucciones, nsNearest);
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    double fraccion = (argc > 2) ? std::atof(argv[2]) : 0.5;
+    size_t borrar = std::min(n, (size_t)(n * fraccion));
+
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> dist(0.f, 1000.f);
+    std::vector<Punto2D> puntos(n);
+    for (auto& p : puntos) p = {dist(gen), dist(gen)};
+
+    std::printf("n=%zu borrados=%zu\n", n, borrar);
+    std::printf("%-10s %-10s %7s %10s %10s %10s %8s %10s\n", "orden", "modo", "umbral", "ns remove", "M/s",
+                "lapidas", "reconstr", "ns nn");
+    for (bool porNiveles : {false, true}) {
+        medir("inmediato", puntos, borrar, false, KDTree::UMBRAL_COMPACTACION, porNiveles);
+        for (float umbral : {0.1f, 0.25f, 0.5f}) medir("perezoso", puntos, borrar, true, umbral, porNiveles);
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Consultas filtradas por atributo frente a consultar sin filtro y filtrar despues.
+//
+// Uso: kdtree-bench-filter [n_puntos=1000000] [ancho_filtro=20]
+//
+// Cada punto lleva una "edad" en [20, 90]: independiente de la posicion o
+// correlacionada con x (20 + 70 x / lado, +-5). Filtro [40, 40 + ancho]. Por
+// consulta:
+//  - nearest: nearest(q, filtro) frente a NeighborIterator hasta el primero que cumple
+//  - kNearest (k = 10): kNearest(q, 10, filtro) frente a kNearestIds doblando k
+//    hasta reunir 10 que cumplen
+//  - rangeSearch (cajas de ~1000 puntos): rangeSearchIds(caja, filtro) frente a
+//    rangeSearchIds(caja) y descartar por edad
+// Columnas: us por consulta de cada variante. Filtrar despues puede recorrer
+// medio arbol cuando pocos puntos cercanos cumplen (edad correlada con la
+// posicion): esa variante mide solo las primeras CONSULTAS_DESPUES consultas.
+#include "KDTree.h"
+#include "NeighborIterator.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+static constexpr size_t CONSULTAS = 10000;
+static constexpr size_t CONSULTAS_DESPUES = 500;
+static constexpr float LADO = 1000.f;
+static constexpr int K = 10;
+
+template <class F>
+static double medir(size_t consultas, F&& consulta) {
+    size_t sumidero = 0;
+    auto inicio = Reloj::now();
+    for (size_t i = 0; i < consultas; i++) sumidero += consulta(i);
+    double us = std::chrono::duration<double, std::micro>(Reloj::now() - inicio).count() / consultas;
+    if (sumidero == 1) std::printf(" ");
+    return us;
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? (size_t)std::strtod(argv[1], nullptr) : 1000000;
+    float ancho = (argc > 2) ? (float)std::strtod(argv[2], nullptr) : 20.f;
+    FiltroAtributo filtro{40.f, 40.f + ancho};
+
+    std::mt19937 gen(17);
+    std::uniform_real_distribution<float> uniforme(0.f, LADO);
+    std::uniform_real_distribution<float> edades(20.f, 90.f);
+    std::uniform_real_distribution<float> ruido(-5.f, 5.f);
+    std::vector<Punto2D> puntos(n);
+    for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+    std::vector<Punto2D> consultas(CONSULTAS);
+    for (auto& q : consultas) q = {uniforme(gen), uniforme(gen)};
+    float mitad = 0.5f * LADO * std::sqrt(std::min(1.0f, 1000.0f / n));
+
+    std::printf("n=%zu filtro=[%.0f, %.0f]\n", n, filtro.minimo, filtro.maximo);
+    std::printf("%-14s %-12s %14s %14s\n", "edad", "consulta", "filtro us", "despues us");
+
+    for (bool correlada : {false, true}) {
+        std::vector<float> edad(n);
+        for (size_t i = 0; i < n; i++) {
+            edad[i] = correlada ? 20.f + 70.f * puntos[i].x / LADO + ruido(gen) : edades(gen);
+        }
+        KDTree arbol;
+        arbol.build(puntos, edad);
+        auto cumple = [&](std::uint32_t id) { return edad[id] >= filtro.minimo && edad[id] <= filtro.maximo; };
+        const char* nombre = correlada ? "correlada" : "independiente";
+
+        double nativo = medir(CONSULTAS, [&](size_t i) { return arbol.nearestId(consultas[i], filtro); });
+        double despues = medir(CONSULTAS_DESPUES, [&](size_t i) {
+            NeighborIterator it(arbol, consultas[i]);
+            while (it.next() && !cumple(it.id())) {
+            }
+            return it.count();
+        });
+        std::printf("%-14s %-12s %14.2f %14.2f\n", nombre, "nearest", nativo, despues);
+
+        nativo = medir(CONSULTAS, [&](size_t i) { return arbol.kNearestIds(consultas[i], K, filtro).size(); });
+        despues = medir(CONSULTAS_DESPUES, [&](size_t i) {
+            size_t encontrados = 0;
+            for (int k = 2 * K; encontrados < (size_t)K && (size_t)k / 2 < n; k *= 2) {
+                encontrados = 0;
+                for (std::uint32_t id : arbol.kNearestIds(consultas[i], k)) encontrados += cumple(id);
+            }
+            return encontrados;
+        });
+        std::printf("%-14s %-12s %14.2f %14.2f\n", nombre, "kNearest", nativo, despues);
+
+        auto caja = [&](size_t i) {
+            const Punto2D& q = consultas[i];
+            return Rectangulo{q.x - mitad, q.x + mitad, q.y - mitad, q.y + mitad};
+        };
+        nativo = medir(CONSULTAS, [&](size_t i) { return arbol.rangeSearchIds(caja(i), filtro).size(); });
+        despues = medir(CONSULTAS_DESPUES, [&](size_t i) {
+            size_t encontrados = 0;
+            for (std::uint32_t id : arbol.rangeSearchIds(caja(i))) encontrados += cumple(id);
+            return encontrados;
+        });
+        std::printf("%-14s %-12s %14.2f %14.2f\n", nombre, "rangeSearch", nativo, despues);
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+// Consultas por disco y por poligono convexo: nativas frente a rectangulo
+// envolvente + filtro en el cliente.
+//
+// Uso: kdtree-bench-geofence [n_puntos=1000000] [resultados=1000]
+//
+// Cada consulta es un disco, un hexagono regular o un pasillo diagonal (un
+// rectangulo 20:1 girado 45 grados, cuyo rectangulo envolvente es ~10 veces
+// mayor) de area tal que contiene ~resultados puntos uniformes. Variantes por
+// forma:
+//  - rangeSearch del rectangulo envolvente y filtrado del vector resultante
+//  - radiusSearch / polygonSearch (celdas dentro volcadas, fuera podadas)
+// Columnas: us por consulta y puntos devueltos de media (deben coincidir).
+#include "KDTree.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+static constexpr size_t CONSULTAS = 5000;
+static constexpr float LADO = 1000.f;
+static constexpr double PI = 3.14159265358979323846;
+
+// Dentro o sobre el borde de un poligono convexo antihorario
+static bool dentroPoligono(const Punto2D& p, const std::vector<Punto2D>& poligono) {
+    for (size_t i = 0; i < poligono.size(); i++) {
+        const Punto2D& a = poligono[i];
+        const Punto2D& b = poligono[(i + 1) % poligono.size()];
+        double cruz = (double(b.x) - a.x) * (double(p.y) - a.y) - (double(b.y) - a.y) * (double(p.x) - a.x);
+        if (cruz < 0) return false;
+    }
+    return true;
+}
+
+template <class F>
+static void medir(const char* nombre, F&& consulta) {
+    size_t devueltos = 0;
+    auto inicio = Reloj::now();
+    for (size_t i = 0; i < CONSULTAS; i++) devueltos += consulta(i);
+    double us = std::chrono::duration<double, std::micro>(Reloj::now() - inicio).count();
+    std::printf("%-28s %12.2f %12.1f\n", nombre, us / CONSULTAS, (double)devueltos / CONSULTAS);
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? (size_t)std::strtod(argv[1], nullptr) : 1000000;
+    double resultados = (argc > 2) ? std::strtod(argv[2], nullptr) : 1000;
+
+    std::mt19937 gen(13);
+    std::uniform_real_distribution<float> uniforme(0.f, LADO);
+    std::vector<Punto2D> puntos(n);
+    for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+    std::vector<Punto2D> centros(CONSULTAS);
+    for (auto& c : centros) c = {uniforme(gen), uniforme(gen)};
+    KDTree arbol(puntos);
+
+    // Area objetivo = resultados / densidad
+    double area = resultados * LADO * LADO / (double)n;
+    float radio = (float)std::sqrt(area / PI);
+    float circunradio = (float)std::sqrt(area / (1.5 * std::sqrt(3.0)));  // hexagono regular
+    std::vector<std::vector<Punto2D>> hexagonos(CONSULTAS), pasillos(CONSULTAS);
+    float ancho = (float)std::sqrt(area / 20) / 2, largo = 20 * ancho;  // semiejes
+    float diagonal = (float)std::sqrt(0.5);
+    for (size_t i = 0; i < CONSULTAS; i++) {
+        const Punto2D& c = centros[i];
+        for (int v = 0; v < 6; v++) {
+            double angulo = PI / 3 * v + 0.3;
+            hexagonos[i].push_back({c.x + circunradio * (float)std::cos(angulo),
+                                    c.y + circunradio * (float)std::sin(angulo)});
+        }
+        // Ejes del pasillo: u = (1, 1) / sqrt(2), w = (-1, 1) / sqrt(2)
+        for (auto [su, sw] : {std::pair{-1, -1}, {1, -1}, {1, 1}, {-1, 1}}) {
+            float u = su * largo * diagonal, w = sw * ancho * diagonal;
+            pasillos[i].push_back({c.x + u - w, c.y + u + w});
+        }
+    }
+
+    std::printf("n=%zu resultados~%.0f\n", n, resultados);
+    std::printf("%-28s %12s %12s\n", "variante", "us/consulta", "devueltos");
+
+    medir("disco: rectangulo + filtro", [&](size_t i) {
+        const Punto2D& c = centros[i];
+        std::vector<Punto2D> v = arbol.rangeSearch({c.x - radio, c.x + radio, c.y - radio, c.y + radio});
+        v.erase(std::remove_if(v.begin(), v.end(),
+                               [&](const Punto2D& p) {
+                                   float dx = p.x - c.x, dy = p.y - c.y;
+                                   return dx * dx + dy * dy > radio * radio;
+                               }),
+                v.end());
+        return v.size();
+    });
+    medir("disco: radiusSearch", [&](size_t i) { return arbol.radiusSearch(centros[i], radio).size(); });
+
+    for (auto [forma, poligonos] : {std::pair{"hexagono", &hexagonos}, {"pasillo", &pasillos}}) {
+        char nombre[64];
+        std::snprintf(nombre, sizeof(nombre), "%s: rectangulo + filtro", forma);
+        medir(nombre, [&](size_t i) {
+            const std::vector<Punto2D>& poligono = (*poligonos)[i];
+            Rectangulo r = {poligono[0].x, poligono[0].x, poligono[0].y, poligono[0].y};
+            for (const Punto2D& p : poligono) {
+                r.xmin = std::min(r.xmin, p.x);
+                r.xmax = std::max(r.xmax, p.x);
+                r.ymin = std::min(r.ymin, p.y);
+                r.ymax = std::max(r.ymax, p.y);
+            }
+            std::vector<Punto2D> v = arbol.rangeSearch(r);
+            auto fuera = [&](const Punto2D& p) { return !dentroPoligono(p, poligono); };
+            v.erase(std::remove_if(v.begin(), v.end(), fuera), v.end());
+            return v.size();
+        });
+        std::snprintf(nombre, sizeof(nombre), "%s: polygonSearch", forma);
+        medir(nombre, [&](size_t i) { return arbol.polygonSearch((*poligonos)[i]).size(); });
+    }
+    return 0;
+}
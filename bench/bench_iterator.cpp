@@ -0,0 +1,82 @@
+// Vecinos incrementales: NeighborIterator frente a repetir kNearest con k creciente.
+//
+// Uso: kdtree-bench-iterator [n_puntos=1000000] [selectividad=100]
+//
+// Simula un filtro de negocio: para cada consulta se piden vecinos en orden
+// hasta encontrar uno cuyo id sea multiplo de la selectividad (~selectividad
+// vecinos de media, sin saberlo de antemano). Variantes:
+//  - NeighborIterator: next() hasta que el filtro se cumple
+//  - kNearestIds doblando k (16, 32, 64...) y recorriendo cada vez el arbol
+//  - kNearestIds con el k de una consulta ya conocido (cota inferior
+//    imposible en la practica: exige saber k)
+// Columnas: us por consulta y vecinos examinados de media.
+#include "NeighborIterator.h"
+#include "KDTree.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+static constexpr size_t CONSULTAS = 20000;
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? (size_t)std::strtod(argv[1], nullptr) : 1000000;
+    std::uint32_t selectividad = (argc > 2) ? (std::uint32_t)std::strtoul(argv[2], nullptr, 10) : 100;
+    if (selectividad == 0) selectividad = 1;
+
+    std::mt19937 gen(11);
+    std::uniform_real_distribution<float> uniforme(0.f, 1000.f);
+    std::vector<Punto2D> puntos(n);
+    for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+    std::vector<Punto2D> consultas(CONSULTAS);
+    for (auto& q : consultas) q = {uniforme(gen), uniforme(gen)};
+    KDTree arbol(puntos);
+    auto cumple = [selectividad](std::uint32_t id) { return id % selectividad == 0; };
+
+    std::printf("n=%zu selectividad=%u\n", n, selectividad);
+    std::printf("%-24s %12s %12s\n", "variante", "us/consulta", "examinados");
+
+    // Iterador: tambien anota cuantos vecinos necesito cada consulta
+    std::vector<int> necesarios(CONSULTAS);
+    size_t examinados = 0;
+    auto inicio = Reloj::now();
+    for (size_t i = 0; i < CONSULTAS; i++) {
+        NeighborIterator it(arbol, consultas[i]);
+        while (it.next() && !cumple(it.id())) {
+        }
+        necesarios[i] = (int)it.count();
+        examinados += it.count();
+    }
+    double us = std::chrono::duration<double, std::micro>(Reloj::now() - inicio).count();
+    std::printf("%-24s %12.2f %12.1f\n", "NeighborIterator", us / CONSULTAS, (double)examinados / CONSULTAS);
+
+    examinados = 0;
+    inicio = Reloj::now();
+    for (size_t i = 0; i < CONSULTAS; i++) {
+        bool encontrado = false;
+        for (int k = 16; !encontrado && (size_t)k / 2 < n; k *= 2) {
+            std::vector<std::uint32_t> ids = arbol.kNearestIds(consultas[i], k);
+            examinados += ids.size();
+            for (std::uint32_t id : ids) {
+                if (cumple(id)) {
+                    encontrado = true;
+                    break;
+                }
+            }
+        }
+    }
+    us = std::chrono::duration<double, std::micro>(Reloj::now() - inicio).count();
+    std::printf("%-24s %12.2f %12.1f\n", "kNearest doblando k", us / CONSULTAS, (double)examinados / CONSULTAS);
+
+    examinados = 0;
+    inicio = Reloj::now();
+    for (size_t i = 0; i < CONSULTAS; i++) {
+        examinados += arbol.kNearestIds(consultas[i], necesarios[i]).size();
+    }
+    us = std::chrono::duration<double, std::micro>(Reloj::now() - inicio).count();
+    std::printf("%-24s %12.2f %12.1f\n", "kNearest k conocido", us / CONSULTAS, (double)examinados / CONSULTAS);
+    return 0;
+}
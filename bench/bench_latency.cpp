@@ -0,0 +1,90 @@
+// Histogramas de latencia por arbol: coste de activarlos y percentiles bajo carga.
+//
+// Uso: kdtree-bench-latency [n_puntos=1000000] [hilos=0 (todos)] [salida.json]
+//
+// Lanza 1M consultas nearest y 200k rangeSearch (cajas de ~100 puntos)
+// repartidas en un pool, primero con los histogramas desactivados y despues
+// activados, e imprime el rendimiento de ambas pasadas y el informe del arbol
+// (p50 / p90 / p99 / p999 por operacion, combinando todos los hilos). Con
+// salida.json el informe se escribe tambien en JSON.
+#include "KDTree.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+static constexpr size_t CONSULTAS_NN = 1000000;
+static constexpr size_t CONSULTAS_RANGO = 200000;
+static constexpr float LADO = 1000.f;
+
+// Segundos de una pasada de cada tipo de consulta sobre el pool
+static void pasada(const KDTree& arbol, const std::vector<Punto2D>& consultas, float mitad,
+                   ThreadPool& pool, double& segundosNN, double& segundosRango) {
+    std::atomic<size_t> sumidero{0};
+    auto inicio = Reloj::now();
+    pool.parallelFor(CONSULTAS_NN, 4096, [&](size_t desde, size_t hasta) {
+        float suma = 0;
+        for (size_t i = desde; i < hasta; i++) suma += arbol.nearest(consultas[i % consultas.size()]).x;
+        sumidero += (size_t)suma;
+    });
+    segundosNN = std::chrono::duration<double>(Reloj::now() - inicio).count();
+
+    inicio = Reloj::now();
+    pool.parallelFor(CONSULTAS_RANGO, 1024, [&](size_t desde, size_t hasta) {
+        size_t encontrados = 0;
+        for (size_t i = desde; i < hasta; i++) {
+            const Punto2D& q = consultas[i % consultas.size()];
+            encontrados += arbol.rangeSearch({q.x - mitad, q.x + mitad, q.y - mitad, q.y + mitad}).size();
+        }
+        sumidero += encontrados;
+    });
+    segundosRango = std::chrono::duration<double>(Reloj::now() - inicio).count();
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? (size_t)std::strtod(argv[1], nullptr) : 1000000;
+    unsigned hilos = (argc > 2) ? (unsigned)std::strtoul(argv[2], nullptr, 10) : 0;
+    const char* ruta = (argc > 3) ? argv[3] : nullptr;
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> uniforme(0.f, LADO);
+    std::vector<Punto2D> puntos(n);
+    for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+    std::vector<Punto2D> consultas(100000);
+    for (auto& q : consultas) q = {uniforme(gen), uniforme(gen)};
+
+    KDTree arbol(puntos);
+    ThreadPool pool(hilos);
+    float mitad = 0.5f * LADO * std::sqrt(std::min(1.0f, 100.0f / n));
+    std::printf("n=%zu hilos=%u\n", n, pool.size());
+    std::printf("%-14s %14s %14s\n", "histogramas", "nearest Mop/s", "rango Kop/s");
+
+    double nn, rango;
+    pasada(arbol, consultas, mitad, pool, nn, rango);  // calentamiento
+    pasada(arbol, consultas, mitad, pool, nn, rango);
+    std::printf("%-14s %14.2f %14.1f\n", "desactivados", CONSULTAS_NN / nn / 1e6, CONSULTAS_RANGO / rango / 1e3);
+
+    arbol.setLatencyHistograms(true);
+    pasada(arbol, consultas, mitad, pool, nn, rango);
+    std::printf("%-14s %14.2f %14.1f\n", "activados", CONSULTAS_NN / nn / 1e6, CONSULTAS_RANGO / rango / 1e3);
+
+    const LatencyRecorder* registro = arbol.latencyRecorder();
+    std::printf("\nhilos con muestras: %zu\n%s", registro->threads(), registro->toText().c_str());
+    if (ruta) {
+        std::FILE* salida = std::fopen(ruta, "w");
+        if (!salida) {
+            std::fprintf(stderr, "no se puede escribir %s\n", ruta);
+            return 1;
+        }
+        std::fprintf(salida, "%s\n", registro->toJson().c_str());
+        std::fclose(salida);
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Carga de puntos desde CSV y binario empaquetado: rendimiento en MB/s.
+//
+// Uso: kdtree-bench-load [n_puntos=5000000] [directorio=.]
+//
+// Genera un CSV ("x,y" con 9 cifras) y un binario (float[2]) con los mismos
+// puntos y compara:
+//  - referencia: std::ifstream >> en un vector<Punto2D> y despues build()
+//  - PointLoader con 1 hilo y con todos los nucleos
+// Columnas: lectura (mapeo + parseo + validacion), MB/s de la lectura y
+// construccion del arbol.
+#include "PointLoader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+static double segundos(Reloj::time_point inicio) {
+    return std::chrono::duration<double>(Reloj::now() - inicio).count();
+}
+
+static void imprimirFila(const char* nombre, double bytes, double lectura, double construccion) {
+    std::printf("%-22s %10.1f %10.1f %12.1f\n", nombre, lectura * 1e3, bytes / 1e6 / lectura,
+                construccion * 1e3);
+}
+
+static void imprimirInforme(const char* nombre, const InformeCarga& informe) {
+    if (informe.estado != EstadoCarga::Ok) {
+        std::printf("%-22s fallo (linea %zu)\n", nombre, informe.lineaError);
+        return;
+    }
+    imprimirFila(nombre, (double)informe.bytes, informe.segundosLectura, informe.segundosConstruccion);
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 5000000;
+    std::string directorio = (argc > 2) ? argv[2] : ".";
+    std::string rutaCsv = directorio + "/kdtree-bench-load.csv";
+    std::string rutaBinario = directorio + "/kdtree-bench-load.bin";
+
+    std::mt19937 gen(17);
+    std::uniform_real_distribution<float> dist(-1000.f, 1000.f);
+    long bytesCsv = 0;
+    {
+        std::FILE* csv = std::fopen(rutaCsv.c_str(), "wb");
+        std::FILE* binario = std::fopen(rutaBinario.c_str(), "wb");
+        if (!csv || !binario) {
+            std::printf("no se pueden crear los archivos en %s\n", directorio.c_str());
+            return 1;
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            float p[2] = {dist(gen), dist(gen)};
+            std::fprintf(csv, "%.9g,%.9g\n", p[0], p[1]);
+            std::fwrite(p, sizeof(float), 2, binario);
+        }
+        bytesCsv = std::ftell(csv);
+        std::fclose(csv);
+        std::fclose(binario);
+    }
+
+    unsigned hilos = std::thread::hardware_concurrency();
+    std::printf("n=%zu nucleos=%u\n", n, hilos);
+    std::printf("%-22s %10s %10s %12s\n", "variante", "lectura ms", "MB/s", "build ms");
+
+    {
+        auto inicio = Reloj::now();
+        std::ifstream entrada(rutaCsv);
+        std::vector<Punto2D> puntos;
+        Punto2D p;
+        char coma;
+        while (entrada >> p.x >> coma >> p.y) puntos.push_back(p);
+        double lectura = segundos(inicio);
+        inicio = Reloj::now();
+        KDTree arbol(std::move(puntos));
+        imprimirFila("csv ifstream", (double)bytesCsv, lectura, segundos(inicio));
+    }
+
+    std::vector<unsigned> variantes{1};
+    if (hilos > 1) variantes.push_back(hilos);
+
+    PointLoader::Opciones opciones;
+    for (unsigned h : variantes) {
+        opciones.hilos = h;
+        KDTree arbol;
+        std::string nombre = "csv PointLoader x" + std::to_string(h);
+        imprimirInforme(nombre.c_str(), PointLoader::loadCsv(rutaCsv, arbol, opciones));
+    }
+    for (unsigned h : variantes) {
+        opciones.hilos = h;
+        KDTree arbol;
+        std::string nombre = "bin PointLoader x" + std::to_string(h);
+        imprimirInforme(nombre.c_str(), PointLoader::loadBinary(rutaBinario, arbol, opciones));
+    }
+
+    std::remove(rutaCsv.c_str());
+    std::remove(rutaBinario.c_str());
+    return 0;
+}
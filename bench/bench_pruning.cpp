@@ -0,0 +1,80 @@
+// Poda por cajas envolventes frente a la poda clasica por plano divisor
+// (setBoundingBoxPruning), sobre datos uniformes y en cumulos.
+//
+// Uso: kdtree-bench-pruning [n_puntos=1000000] [consultas=20000]
+//
+// Cumulos: 50 gaussianas (sigma 5) en [0, 1000]^2. Las consultas son uniformes
+// en ambos casos: con cumulos casi todas caen lejos de los datos, donde el
+// plano divisor apenas poda y la caja de cada subarbol si. El mismo arbol se
+// mide con las dos podas. Columnas: us por consulta de nearest, kNearest
+// (k = 10), rangeSearch y rangeCount (cajas de ~100 puntos en el caso uniforme).
+#include "KDTree.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+static constexpr int K = 10;
+static constexpr float LADO = 1000.f;
+
+template <class F>
+static double medirUs(const std::vector<Punto2D>& consultas, F&& consultar) {
+    volatile float sumidero = 0;
+    auto inicio = Reloj::now();
+    for (const Punto2D& q : consultas) sumidero = sumidero + consultar(q);
+    return std::chrono::duration<double, std::micro>(Reloj::now() - inicio).count() / consultas.size();
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? (size_t)std::strtod(argv[1], nullptr) : 1000000;
+    size_t totalConsultas = (argc > 2) ? (size_t)std::strtod(argv[2], nullptr) : 20000;
+    if (n < (size_t)K) n = K;
+
+    std::mt19937 gen(9);
+    std::uniform_real_distribution<float> uniforme(0.f, LADO);
+    std::normal_distribution<float> normal(0.f, 5.f);
+    std::vector<Punto2D> consultas(totalConsultas);
+    for (auto& q : consultas) q = {uniforme(gen), uniforme(gen)};
+    float mitad = 0.5f * LADO * std::sqrt(100.f / n);
+
+    std::printf("n=%zu consultas=%zu\n", n, totalConsultas);
+    std::printf("%-10s %-6s %12s %12s %12s %12s\n", "datos", "poda", "nearest us", "kNearest us",
+                "rango us", "cuenta us");
+
+    for (const char* datos : {"uniforme", "cumulos"}) {
+        std::vector<Punto2D> puntos(n);
+        if (datos[0] == 'u') {
+            for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+        } else {
+            std::vector<Punto2D> centros(50);
+            for (auto& c : centros) c = {uniforme(gen), uniforme(gen)};
+            for (auto& p : puntos) {
+                const Punto2D& c = centros[gen() % centros.size()];
+                p = {c.x + normal(gen), c.y + normal(gen)};
+            }
+        }
+        KDTree arbol(puntos);
+
+        for (bool cajas : {false, true}) {
+            arbol.setBoundingBoxPruning(cajas);
+            double nn = medirUs(consultas, [&](const Punto2D& q) { return arbol.nearest(q).x; });
+            double knn = medirUs(consultas, [&](const Punto2D& q) { return arbol.kNearest(q, K).back().x; });
+            auto caja = [mitad](const Punto2D& q) {
+                return Rectangulo{q.x - mitad, q.x + mitad, q.y - mitad, q.y + mitad};
+            };
+            double rango = medirUs(consultas, [&](const Punto2D& q) {
+                return (float)arbol.rangeSearch(caja(q)).size();
+            });
+            double cuenta = medirUs(consultas, [&](const Punto2D& q) {
+                return (float)arbol.rangeCount(caja(q));
+            });
+            std::printf("%-10s %-6s %12.2f %12.2f %12.2f %12.2f\n", datos, cajas ? "cajas" : "plano", nn,
+                        knn, rango, cuenta);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,81 @@
+// Arranque desde un snapshot mapeado frente a reconstruir el arbol.
+//
+// Uso: kdtree-bench-snapshot [n_puntos=1000000] [ruta=kdtree-bench.kds]
+//
+// Mide: n inserciones, build() por mediana, StaticKDTree desde el KDTree,
+// saveSnapshot, openSnapshot (solo cabecera y con verificacion de datos) y el
+// coste de las consultas sobre las paginas mapeadas frente a memoria propia.
+#include "StaticKDTree.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+static double milisegundos(Reloj::time_point inicio) {
+    return std::chrono::duration<double, std::milli>(Reloj::now() - inicio).count();
+}
+
+// ns por consulta de nearest sobre las consultas dadas
+static double medirConsultas(const StaticKDTree& arbol, const std::vector<Punto2D>& consultas) {
+    volatile float sumidero = 0;
+    auto inicio = Reloj::now();
+    for (const Punto2D& q : consultas) sumidero = sumidero + arbol.nearest(q).x;
+    return milisegundos(inicio) * 1e6 / consultas.size();
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::string ruta = (argc > 2) ? argv[2] : "kdtree-bench.kds";
+
+    std::mt19937 gen(5);
+    std::uniform_real_distribution<float> dist(0.f, 1000.f);
+    std::vector<Punto2D> puntos(n), consultas(200000);
+    for (auto& p : puntos) p = {dist(gen), dist(gen)};
+    for (auto& q : consultas) q = {dist(gen), dist(gen)};
+
+    std::printf("n=%zu archivo=%s\n", n, ruta.c_str());
+
+    auto inicio = Reloj::now();
+    KDTree insertado;
+    for (const Punto2D& p : puntos) insertado.insert(p);
+    std::printf("%-28s %10.1f ms\n", "insert x n", milisegundos(inicio));
+
+    inicio = Reloj::now();
+    KDTree arbol(puntos);
+    std::printf("%-28s %10.1f ms\n", "build (mediana)", milisegundos(inicio));
+
+    inicio = Reloj::now();
+    StaticKDTree estatico(arbol);
+    std::printf("%-28s %10.1f ms\n", "StaticKDTree(KDTree)", milisegundos(inicio));
+
+    inicio = Reloj::now();
+    if (estatico.saveSnapshot(ruta) != EstadoSnapshot::Ok) {
+        std::printf("saveSnapshot fallo\n");
+        return 1;
+    }
+    std::printf("%-28s %10.1f ms\n", "saveSnapshot", milisegundos(inicio));
+
+    StaticKDTree mapeado;
+    inicio = Reloj::now();
+    EstadoSnapshot estado = mapeado.openSnapshot(ruta);
+    std::printf("%-28s %10.3f ms\n", "openSnapshot", milisegundos(inicio));
+
+    StaticKDTree verificado;
+    inicio = Reloj::now();
+    estado = (estado == EstadoSnapshot::Ok) ? verificado.openSnapshot(ruta, true) : estado;
+    std::printf("%-28s %10.1f ms\n", "openSnapshot (verificar)", milisegundos(inicio));
+    if (estado != EstadoSnapshot::Ok) {
+        std::printf("openSnapshot fallo\n");
+        return 1;
+    }
+
+    std::printf("%-28s %10.1f ns\n", "nearest en memoria", medirConsultas(estatico, consultas));
+    std::printf("%-28s %10.1f ns\n", "nearest mapeado", medirConsultas(mapeado, consultas));
+
+    std::remove(ruta.c_str());
+    return 0;
+}
@@ -0,0 +1,70 @@
+// Arbol de punteros (KDTree) frente al arbol estatico en orden Eytzinger
+// (StaticKDTree) sobre los mismos puntos.
+//
+// Uso: kdtree-bench-static [n_puntos=4000000] [consultas=1000000]
+//
+// Puntos y consultas uniformes. KDTree se construye con build() y se mide con
+// la poda clasica por plano divisor (la unica que comparte con StaticKDTree) y
+// con la poda por cajas envolventes. Columnas: ns por consulta de nearest,
+// kNearest (k = 10) y rangeSearch (cajas de ~100 puntos, un decimo de las
+// consultas).
+#include "KDTree.h"
+#include "StaticKDTree.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+static constexpr int K = 10;
+static constexpr float LADO = 1000.f;
+
+// ns por consulta de consultar(q) sobre las consultas dadas
+template <class F>
+static double medirNs(const std::vector<Punto2D>& consultas, F&& consultar) {
+    volatile float sumidero = 0;
+    auto inicio = Reloj::now();
+    for (const Punto2D& q : consultas) sumidero = sumidero + consultar(q);
+    return std::chrono::duration<double, std::nano>(Reloj::now() - inicio).count() / consultas.size();
+}
+
+template <class Arbol>
+static void fila(const char* nombre, const Arbol& arbol, const std::vector<Punto2D>& consultas,
+                 const std::vector<Punto2D>& consultasRango, float mitad) {
+    double nn = medirNs(consultas, [&](const Punto2D& q) { return arbol.nearest(q).x; });
+    double knn = medirNs(consultas, [&](const Punto2D& q) { return arbol.kNearest(q, K).back().x; });
+    double rango = medirNs(consultasRango, [&](const Punto2D& q) {
+        return (float)arbol.rangeSearch({q.x - mitad, q.x + mitad, q.y - mitad, q.y + mitad}).size();
+    });
+    std::printf("%-22s %12.1f %12.1f %12.1f\n", nombre, nn, knn, rango);
+}
+
+int main(int argc, char** argv) {
+    size_t n = (argc > 1) ? (size_t)std::strtod(argv[1], nullptr) : 4000000;
+    size_t totalConsultas = (argc > 2) ? (size_t)std::strtod(argv[2], nullptr) : 1000000;
+    if (n < (size_t)K) n = K;
+
+    std::mt19937 gen(4);
+    std::uniform_real_distribution<float> uniforme(0.f, LADO);
+    std::vector<Punto2D> puntos(n), consultas(totalConsultas), consultasRango(totalConsultas / 10 + 1);
+    for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+    for (auto& q : consultas) q = {uniforme(gen), uniforme(gen)};
+    for (auto& q : consultasRango) q = {uniforme(gen), uniforme(gen)};
+    // Caja de lado l con ~100 puntos esperados: l^2 * n / LADO^2 = 100
+    float mitad = 0.5f * LADO * std::sqrt(100.f / n);
+
+    KDTree arbol(puntos);
+    StaticKDTree estatico(puntos);
+
+    std::printf("n=%zu consultas=%zu\n", n, totalConsultas);
+    std::printf("%-22s %12s %12s %12s\n", "arbol", "nearest ns", "kNearest ns", "rango ns");
+    arbol.setBoundingBoxPruning(false);
+    fila("punteros (plano)", arbol, consultas, consultasRango, mitad);
+    arbol.setBoundingBoxPruning(true);
+    fila("punteros (cajas)", arbol, consultas, consultasRango, mitad);
+    fila("Eytzinger", estatico, consultas, consultasRango, mitad);
+    return 0;
+}
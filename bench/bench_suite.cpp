@@ -0,0 +1,197 @@
+// Suite de rendimiento del KDTree con salida JSON (seguimiento de regresiones).
+//
+// Uso: kdtree-bench [n_maximo=1000000] [semilla=42] [salida.json]
+//
+// Para cada conjunto de datos (uniforme, cumulos gaussianos, ordenado, con
+// muchos duplicados) y cada n = 1e3, 1e4, ... hasta n_maximo (admite 1e8 si
+// hay memoria: ~7 GB) mide:
+//  - insert: n inserciones en un arbol vacio, en el orden del conjunto
+//  - nearest / kNearest (k=10) / rangeSearch: 100k consultas cerca de los datos
+//    (rangeSearch con cajas de ~100 puntos esperados en el caso uniforme)
+//  - remove: n/2 borrados en orden aleatorio
+// Con n pequeno insert y remove se repiten hasta sumar 100k operaciones.
+// Cada resultado lleva ns por operacion, operaciones por segundo y nodos
+// visitados por operacion (QueryStats, de una pasada aparte sin medir tiempo;
+// null en insert); rangeSearch anade los puntos devueltos por consulta. El
+// JSON va a la salida estandar o al archivo indicado; el progreso, a stderr.
+#include "KDTree.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using Reloj = std::chrono::steady_clock;
+
+static constexpr size_t CONSULTAS = 100000;
+static constexpr size_t OPERACIONES_MINIMAS = 100000;
+static constexpr size_t MUESTRA_NODOS = 10000;
+static constexpr int K = 10;
+static constexpr float LADO = 1000.f;
+
+struct Resultado {
+    std::string conjunto;
+    size_t n;
+    std::string operacion;
+    size_t operaciones;
+    double nsPorOp;
+    double nodosVisitados;  // < 0: no disponible
+    double resultadosPorConsulta;  // rangeSearch; < 0 en las demas
+};
+
+static std::vector<Punto2D> generar(const std::string& conjunto, size_t n, unsigned semilla) {
+    std::mt19937 gen(semilla);
+    std::uniform_real_distribution<float> uniforme(0.f, LADO);
+    std::vector<Punto2D> puntos(n);
+
+    if (conjunto == "gaussiano") {
+        std::normal_distribution<float> normal(0.f, 5.f);
+        std::vector<Punto2D> centros(50);
+        for (auto& c : centros) c = {uniforme(gen), uniforme(gen)};
+        for (auto& p : puntos) {
+            const Punto2D& c = centros[gen() % centros.size()];
+            p = {c.x + normal(gen), c.y + normal(gen)};
+        }
+    } else if (conjunto == "duplicados") {
+        // ~100 copias de cada posicion distinta
+        std::vector<Punto2D> distintos(std::max<size_t>(n / 100, 10));
+        for (auto& d : distintos) d = {uniforme(gen), uniforme(gen)};
+        for (auto& p : puntos) p = distintos[gen() % distintos.size()];
+    } else {
+        for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+        if (conjunto == "ordenado") std::sort(puntos.begin(), puntos.end());
+    }
+    return puntos;
+}
+
+// Consultas: puntos del conjunto con un pequeno desplazamiento
+static std::vector<Punto2D> generarConsultas(const std::vector<Punto2D>& puntos, unsigned semilla) {
+    std::mt19937 gen(semilla);
+    std::normal_distribution<float> ruido(0.f, 1.f);
+    std::vector<Punto2D> consultas(CONSULTAS);
+    for (auto& q : consultas) {
+        const Punto2D& p = puntos[gen() % puntos.size()];
+        q = {p.x + ruido(gen), p.y + ruido(gen)};
+    }
+    return consultas;
+}
+
+static double nsDesde(Reloj::time_point inicio) {
+    return std::chrono::duration<double, std::nano>(Reloj::now() - inicio).count();
+}
+
+static void medirConjunto(const std::string& conjunto, size_t n, unsigned semilla,
+                          std::vector<Resultado>& resultados) {
+    std::vector<Punto2D> puntos = generar(conjunto, n, semilla);
+    std::vector<Punto2D> consultas = generarConsultas(puntos, semilla + 1);
+    auto anotar = [&](const char* operacion, size_t operaciones, double ns, double nodos,
+                      double encontrados = -1) {
+        resultados.push_back({conjunto, n, operacion, operaciones, ns / operaciones, nodos, encontrados});
+        std::fprintf(stderr, "%-10s n=%-10zu %-11s %10.1f ns/op\n", conjunto.c_str(), n, operacion,
+                     ns / operaciones);
+    };
+    volatile float sumidero = 0;
+
+    // insert
+    size_t repeticiones = std::max<size_t>(1, OPERACIONES_MINIMAS / n);
+    double ns = 0;
+    for (size_t r = 0; r < repeticiones; r++) {
+        KDTree arbol;
+        auto inicio = Reloj::now();
+        for (const Punto2D& p : puntos) arbol.insert(p);
+        ns += nsDesde(inicio);
+    }
+    anotar("insert", n * repeticiones, ns, -1);
+
+    KDTree arbol(puntos);
+
+    // Nodos visitados: QueryStats sobre una muestra de las consultas, en una
+    // pasada sin cronometrar (la version medida es la que no cuenta)
+    size_t muestra = std::min(MUESTRA_NODOS, consultas.size());
+    float mitad = 0.5f * LADO * std::sqrt(std::min(1.0f, 100.0f / n));
+    auto cajaDe = [mitad](const Punto2D& q) {
+        return Rectangulo{q.x - mitad, q.x + mitad, q.y - mitad, q.y + mitad};
+    };
+    QueryStats statsNN, statsKNN, statsRango;
+    for (size_t i = 0; i < muestra; i++) {
+        arbol.nearest(consultas[i], &statsNN);
+        arbol.kNearest(consultas[i], K, &statsKNN);
+        arbol.rangeSearch(cajaDe(consultas[i]), &statsRango);
+    }
+
+    auto inicio = Reloj::now();
+    for (const Punto2D& q : consultas) sumidero = sumidero + arbol.nearest(q).x;
+    anotar("nearest", consultas.size(), nsDesde(inicio), (double)statsNN.nodosVisitados / muestra);
+
+    inicio = Reloj::now();
+    for (const Punto2D& q : consultas) sumidero = sumidero + (float)arbol.kNearest(q, K).size();
+    anotar("kNearest", consultas.size(), nsDesde(inicio), (double)statsKNN.nodosVisitados / muestra);
+
+    // Cajas de ~100 puntos esperados si los datos fueran uniformes (en los
+    // cumulos salen muchos mas: resultados_por_consulta lo refleja)
+    size_t encontrados = 0;
+    inicio = Reloj::now();
+    for (const Punto2D& q : consultas) encontrados += arbol.rangeSearch(cajaDe(q)).size();
+    anotar("rangeSearch", consultas.size(), nsDesde(inicio), (double)statsRango.nodosVisitados / muestra,
+           (double)encontrados / consultas.size());
+
+    // remove: n/2 puntos al azar (un arbol nuevo por repeticion)
+    std::vector<Punto2D> borrar = puntos;
+    std::shuffle(borrar.begin(), borrar.end(), std::mt19937(semilla + 2));
+    borrar.resize(std::max<size_t>(n / 2, 1));
+    repeticiones = std::max<size_t>(1, OPERACIONES_MINIMAS / borrar.size());
+    ns = 0;
+    for (size_t r = 0; r < repeticiones; r++) {
+        KDTree copia(puntos);
+        inicio = Reloj::now();
+        for (const Punto2D& p : borrar) copia.remove(p);
+        ns += nsDesde(inicio);
+    }
+    QueryStats statsBorrado;
+    {
+        KDTree copia(puntos);
+        for (const Punto2D& p : borrar) copia.remove(p, KDTree::SIN_ID, &statsBorrado);
+    }
+    anotar("remove", borrar.size() * repeticiones, ns, (double)statsBorrado.nodosVisitados / borrar.size());
+}
+
+static void escribirJson(std::FILE* salida, unsigned semilla, const std::vector<Resultado>& resultados) {
+    std::fprintf(salida, "{\n  \"benchmark\": \"kdtree-bench\",\n  \"semilla\": %u,\n", semilla);
+    std::fprintf(salida, "  \"k\": %d,\n  \"resultados\": [\n", K);
+    for (size_t i = 0; i < resultados.size(); i++) {
+        const Resultado& r = resultados[i];
+        std::fprintf(salida,
+                     "    {\"conjunto\": \"%s\", \"n\": %zu, \"operacion\": \"%s\", \"operaciones\": %zu, "
+                     "\"ns_por_op\": %.2f, \"ops_por_segundo\": %.0f, \"nodos_visitados\": ",
+                     r.conjunto.c_str(), r.n, r.operacion.c_str(), r.operaciones, r.nsPorOp, 1e9 / r.nsPorOp);
+        if (r.nodosVisitados < 0) std::fprintf(salida, "null");
+        else std::fprintf(salida, "%.2f", r.nodosVisitados);
+        if (r.resultadosPorConsulta >= 0)
+            std::fprintf(salida, ", \"resultados_por_consulta\": %.2f", r.resultadosPorConsulta);
+        std::fprintf(salida, "}%s\n", (i + 1 < resultados.size()) ? "," : "");
+    }
+    std::fprintf(salida, "  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    size_t nMaximo = (argc > 1) ? (size_t)std::strtod(argv[1], nullptr) : 1000000;
+    unsigned semilla = (argc > 2) ? (unsigned)std::strtoul(argv[2], nullptr, 10) : 42;
+    const char* ruta = (argc > 3) ? argv[3] : nullptr;
+
+    std::vector<Resultado> resultados;
+    for (const char* conjunto : {"uniforme", "gaussiano", "ordenado", "duplicados"}) {
+        for (size_t n = 1000; n <= nMaximo; n *= 10) medirConjunto(conjunto, n, semilla, resultados);
+    }
+
+    std::FILE* salida = ruta ? std::fopen(ruta, "w") : stdout;
+    if (!salida) {
+        std::fprintf(stderr, "no se puede escribir %s\n", ruta);
+        return 1;
+    }
+    escribirJson(salida, semilla, resultados);
+    if (ruta) std::fclose(salida);
+    return 0;
+}
@@ -0,0 +1,187 @@
+// Recorridos iterativos (pila explicita) frente a las versiones recursivas
+// originales, en arboles de profundidad 20 (balanceado) a 100k (degenerado).
+// "rango vis" es la misma consulta que "rango it" con forEachInRange (sin
+// vector de resultados).
+//
+// Uso: kdtree-bench-traversal [profundidad_recursiva_max=20000]
+//
+// Las versiones recursivas de referencia son copia de las que tenia KDTree.cpp;
+// por encima de profundidad_recursiva_max no se ejecutan porque desbordan la
+// pila de llamadas (el motivo del cambio).
+#include "KDTree.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+// ============ REFERENCIA RECURSIVA
+
+static inline float distanciaCuadrado(const Punto2D& a, const Punto2D& b) {
+    float dx = a.x - b.x;
+    float dy = a.y - b.y;
+    return dx * dx + dy * dy;
+}
+
+static KDNode* masCercano(const Punto2D& objetivo, KDNode* temporal, KDNode* actual) {
+    if (!temporal) return actual;
+    if (!actual) return temporal;
+    return (distanciaCuadrado(objetivo, temporal->punto) < distanciaCuadrado(objetivo, actual->punto))
+               ? temporal : actual;
+}
+
+static KDNode* nearestRecursivo(KDNode* raiz, const Punto2D& objetivo, int profundidad) {
+    if (raiz == nullptr) return nullptr;
+
+    int eje = profundidad % 2;
+    float diff = (eje == 0) ? (objetivo.x - raiz->punto.x) : (objetivo.y - raiz->punto.y);
+    KDNode* siguiente = (diff < 0) ? raiz->izquierdo : raiz->derecho;
+    KDNode* opuesta = (diff < 0) ? raiz->derecho : raiz->izquierdo;
+
+    KDNode* mejor = masCercano(objetivo, nearestRecursivo(siguiente, objetivo, profundidad + 1), raiz);
+    if (distanciaCuadrado(objetivo, mejor->punto) >= diff * diff) {
+        mejor = masCercano(objetivo, nearestRecursivo(opuesta, objetivo, profundidad + 1), mejor);
+    }
+    return mejor;
+}
+
+static void kNearestRecursivo(KDNode* nodo, const Punto2D& objetivo, int profundidad, int k,
+                              std::vector<std::pair<float, Punto2D>>& pq) {
+    if (nodo == nullptr) return;
+
+    float d = distanciaCuadrado(objetivo, nodo->punto);
+    if (pq.size() < (size_t)k) {
+        pq.push_back({d, nodo->punto});
+        std::push_heap(pq.begin(), pq.end());
+    } else if (d < pq.front().first) {
+        std::pop_heap(pq.begin(), pq.end());
+        pq.back() = {d, nodo->punto};
+        std::push_heap(pq.begin(), pq.end());
+    }
+
+    int eje = profundidad % 2;
+    float diff = (eje == 0) ? (objetivo.x - nodo->punto.x) : (objetivo.y - nodo->punto.y);
+    kNearestRecursivo((diff < 0) ? nodo->izquierdo : nodo->derecho, objetivo, profundidad + 1, k, pq);
+    if (pq.size() < (size_t)k || diff * diff < pq.front().first) {
+        kNearestRecursivo((diff < 0) ? nodo->derecho : nodo->izquierdo, objetivo, profundidad + 1, k, pq);
+    }
+}
+
+static void rangeRecursivo(KDNode* nodo, const Rectangulo& r, int profundidad,
+                           std::vector<Punto2D>& resultado) {
+    if (nodo == nullptr) return;
+
+    const Punto2D& p = nodo->punto;
+    if (p.x >= r.xmin && p.x <= r.xmax && p.y >= r.ymin && p.y <= r.ymax) resultado.push_back(p);
+
+    int eje = profundidad % 2;
+    float valor = (eje == 0) ? p.x : p.y;
+    if (((eje == 0) ? r.xmin : r.ymin) <= valor) rangeRecursivo(nodo->izquierdo, r, profundidad + 1, resultado);
+    if (((eje == 0) ? r.xmax : r.ymax) >= valor) rangeRecursivo(nodo->derecho, r, profundidad + 1, resultado);
+}
+
+// ============ MEDICION
+
+static int altura(KDNode* raiz) {
+    int maxima = 0;
+    std::vector<std::pair<KDNode*, int>> pila;
+    if (raiz) pila.push_back({raiz, 1});
+    while (!pila.empty()) {
+        auto [nodo, h] = pila.back();
+        pila.pop_back();
+        maxima = std::max(maxima, h);
+        if (nodo->izquierdo) pila.push_back({nodo->izquierdo, h + 1});
+        if (nodo->derecho) pila.push_back({nodo->derecho, h + 1});
+    }
+    return maxima;
+}
+
+// ns por consulta
+template <class F>
+static double medirNs(const std::vector<Punto2D>& consultas, F&& consulta) {
+    volatile float sumidero = 0.f;
+    auto inicio = std::chrono::steady_clock::now();
+    for (const Punto2D& q : consultas) sumidero = sumidero + consulta(q);
+    auto fin = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(fin - inicio).count() / consultas.size();
+}
+
+static void medirArbol(const char* nombre, const KDTree& tree, float extension, int maxRecursivo) {
+    int h = altura(tree.getRoot());
+    size_t numConsultas = std::max<size_t>(20, 2000000 / std::max<size_t>(tree.size(), 1));
+    if (h < 64) numConsultas = 200000;
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> dist(0.f, extension);
+    std::vector<Punto2D> consultas(numConsultas);
+    for (auto& q : consultas) q = {dist(gen), dist(gen)};
+
+    const int k = 8;
+    const float lado = extension * 0.01f;
+    bool recursivo = h <= maxRecursivo;
+
+    double nnIt = medirNs(consultas, [&](const Punto2D& q) { return tree.nearest(q).x; });
+    double knnIt = medirNs(consultas, [&](const Punto2D& q) { return tree.kNearest(q, k).front().x; });
+    double rangoIt = medirNs(consultas, [&](const Punto2D& q) {
+        return (float)tree.rangeSearch({q.x, q.x + lado, q.y, q.y + lado}).size();
+    });
+    double rangoVis = medirNs(consultas, [&](const Punto2D& q) {
+        float suma = 0.f;
+        tree.forEachInRange({q.x, q.x + lado, q.y, q.y + lado}, [&](const Punto2D& p) { suma += p.x; });
+        return suma;
+    });
+
+    std::printf("%-22s %8d %8zu %10.0f %10.0f %10.0f %10.0f", nombre, h, numConsultas, nnIt, knnIt,
+                rangoIt, rangoVis);
+    if (!recursivo) {
+        std::printf("   recursivo omitido (desbordaria la pila)\n");
+        return;
+    }
+
+    double nnRec = medirNs(consultas, [&](const Punto2D& q) {
+        return nearestRecursivo(tree.getRoot(), q, 0)->punto.x;
+    });
+    double knnRec = medirNs(consultas, [&](const Punto2D& q) {
+        std::vector<std::pair<float, Punto2D>> pq;
+        pq.reserve(k);
+        kNearestRecursivo(tree.getRoot(), q, 0, k, pq);
+        return pq.front().second.x;
+    });
+    double rangoRec = medirNs(consultas, [&](const Punto2D& q) {
+        std::vector<Punto2D> r;
+        rangeRecursivo(tree.getRoot(), {q.x, q.x + lado, q.y, q.y + lado}, 0, r);
+        return (float)r.size();
+    });
+    std::printf(" %10.0f %10.0f %10.0f\n", nnRec, knnRec, rangoRec);
+}
+
+int main(int argc, char** argv) {
+    int maxRecursivo = (argc > 1) ? std::atoi(argv[1]) : 20000;
+
+    std::printf("ns/consulta; it = iterativo (pila explicita), rec = recursivo original\n");
+    std::printf("%-22s %8s %8s %10s %10s %10s %10s %10s %10s %10s\n", "arbol", "altura", "consultas",
+                "nn it", "knn it", "rango it", "rango vis", "nn rec", "knn rec", "rango rec");
+
+    // Profundidad 20: arbol balanceado de 2^20 - 1 puntos
+    {
+        std::mt19937 gen(1);
+        std::uniform_real_distribution<float> dist(0.f, 1000.f);
+        std::vector<Punto2D> puntos((1 << 20) - 1);
+        for (auto& p : puntos) p = {dist(gen), dist(gen)};
+        KDTree tree(puntos);
+        medirArbol("balanceado n=1M", tree, 1000.f, maxRecursivo);
+    }
+
+    // Entrada ordenada insertada punto a punto sin auto-balanceo: lista enlazada de profundidad n
+    for (int profundidad : {100, 1000, 10000, 100000}) {
+        KDTree tree;
+        tree.setBalanceAlpha(1.0f);
+        for (int i = 0; i < profundidad; i++) tree.insert({(float)i, (float)i});
+        char nombre[64];
+        std::snprintf(nombre, sizeof(nombre), "ordenado n=%d", profundidad);
+        medirArbol(nombre, tree, (float)profundidad, maxRecursivo);
+    }
+    return 0;
+}
@@ -1,11 +1,59 @@
+#include "BucketKDTree.h"
+#include "KDForest.h"
 #include "KDTree.h"
+#include "NeighborIterator.h"
+#include "PersistentKDTree.h"
+#include "PointLoader.h"
+#include "StaticKDTree.h"
 #include "Visualizer.h"
 #include <vector>
 #include <iostream>
+#include <functional>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+// Comparaciones de las pruebas entre estructuras (o contra fuerza bruta). Con
+// distancias empatadas dos estructuras pueden devolver puntos distintos, asi
+// que los vecinos se comparan por su distancia y los rangos como conjuntos.
+static float distancia2(const Punto2D& a, const Punto2D& b) {
+    return (a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y);
+}
+
+static std::vector<float> distancias(const std::vector<Punto2D>& vecinos, const Punto2D& q) {
+    std::vector<float> resultado;
+    for (const Punto2D& p : vecinos) resultado.push_back(distancia2(p, q));
+    return resultado;
+}
+
+// Distancias de los min(k, n) vecinos de q, de menor a mayor
+static std::vector<float> vecinosFuerzaBruta(const std::vector<Punto2D>& puntos, const Punto2D& q, int k) {
+    std::vector<float> todas = distancias(puntos, q);
+    std::sort(todas.begin(), todas.end());
+    todas.resize(std::min(todas.size(), (size_t)std::max(k, 0)));
+    return todas;
+}
+
+static std::vector<Punto2D> rangoFuerzaBruta(const std::vector<Punto2D>& puntos, const Rectangulo& r) {
+    std::vector<Punto2D> resultado;
+    for (const Punto2D& p : puntos) {
+        if (p.x >= r.xmin && p.x <= r.xmax && p.y >= r.ymin && p.y <= r.ymax) resultado.push_back(p);
+    }
+    return resultado;
+}
+
+static bool mismosPuntos(std::vector<Punto2D> a, std::vector<Punto2D> b) {
+    std::sort(a.begin(), a.end());
+    std::sort(b.begin(), b.end());
+    auto igual = [](const Punto2D& p, const Punto2D& q) { return p.x == q.x && p.y == q.y; };
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), igual);
+}
 
 int main() {
-    // Construimos el KDTree con algunos puntos 
-    KDTree tree;
+    // Construimos el KDTree con algunos puntos (construccion balanceada por mediana)
     std::vector<Punto2D> puntos = {
         {40, 45},
         {15, 70},
@@ -15,7 +63,7 @@ int main() {
         {85, 90}
     };
 
-    for (const auto& p : puntos) tree.insert(p);
+    KDTree tree(puntos);
 
     // Unit test for remove
     {
@@ -79,6 +127,1030 @@ int main() {
         }
     }
 
+    // Unit test for bulk build
+    {
+        std::cout << "\nRunning unit test for bulk build..." << std::endl;
+        // Entrada ordenada: con insert se degeneraria en una lista de profundidad n
+        std::vector<Punto2D> ordenados;
+        for (int i = 0; i < 1023; i++) ordenados.push_back({(float)i, (float)i});
+        KDTree testTree(ordenados);
+
+        std::function<int(KDNode*)> altura = [&](KDNode* n) -> int {
+            return n ? 1 + std::max(altura(n->izquierdo), altura(n->derecho)) : 0;
+        };
+        int h = altura(testTree.getRoot());
+        Punto2D nn = testTree.nearest({500.2f, 499.9f});
+
+        // buildParallel (1 y 4 hilos, umbral pequeno para repartir varios niveles)
+        // construye el mismo arbol que build(): misma forma, mismos puntos e ids
+        std::function<bool(KDNode*, KDNode*)> mismoArbol = [&](KDNode* a, KDNode* b) -> bool {
+            if (!a || !b) return a == b;
+            return a->punto.x == b->punto.x && a->punto.y == b->punto.y && a->id == b->id &&
+                   a->tamano == b->tamano && mismoArbol(a->izquierdo, b->izquierdo) &&
+                   mismoArbol(a->derecho, b->derecho);
+        };
+        std::vector<Punto2D> repetidos;  // 3000 puntos con solo 16 coordenadas distintas
+        for (int i = 0; i < 3000; i++) repetidos.push_back({(float)(i % 4), (float)(i * 7 % 4)});
+        bool paraleloOk = true;
+        for (const std::vector<Punto2D>* entrada : {&ordenados, &repetidos}) {
+            KDTree serie;
+            serie.build(*entrada);
+            for (unsigned hilos : {1u, 4u}) {
+                KDTree paralelo;
+                paralelo.buildParallel(*entrada, hilos, 16);
+                paraleloOk = paraleloOk && mismoArbol(serie.getRoot(), paralelo.getRoot()) &&
+                             altura(paralelo.getRoot()) == altura(serie.getRoot()) &&
+                             paralelo.size() == entrada->size();
+                for (Punto2D q : {Punto2D{1.4f, 2.6f}, Punto2D{700.3f, 12.0f}, Punto2D{-5.0f, 3.0f}}) {
+                    Rectangulo r = {q.x - 50, q.x + 50, q.y - 1, q.y + 600};
+                    paraleloOk = paraleloOk && paralelo.nearestId(q) == serie.nearestId(q) &&
+                                 paralelo.kNearestIds(q, 7) == serie.kNearestIds(q, 7) &&
+                                 paralelo.rangeSearchIds(r) == serie.rangeSearchIds(r);
+                }
+            }
+        }
+
+        if (h == 10 && nn.x == 500 && nn.y == 500 && paraleloOk) {
+            std::cout << "[TEST] Bulk build (n=1023, altura=" << h << "): PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Bulk build: FAILED - altura " << h << std::endl;
+        }
+    }
+
+    // Unit test for duplicate points
+    {
+        std::cout << "\nRunning unit test for duplicate points..." << std::endl;
+        // 200000 copias del mismo punto: el id desempata y el arbol queda balanceado
+        const size_t n = 200000;
+        KDTree iguales(std::vector<Punto2D>(n, {5, 5}));
+        KDTree igualesParalelo;
+        igualesParalelo.buildParallel(std::vector<Punto2D>(n, {5, 5}), 4u, 1024);
+        std::vector<Punto2D> cinco = iguales.kNearest({0, 0}, 5);
+        bool igualesOk = iguales.balanceStats().altura == 18 &&
+                         igualesParalelo.balanceStats().altura == 18 &&
+                         iguales.rangeCount({5, 5, 5, 5}) == n && iguales.nearestId({4, 4}) < n &&
+                         cinco.size() == 5 && cinco[4].x == 5 && cinco[4].y == 5;
+        for (int i = 0; i < 1000; i++) iguales.remove({5, 5}, (i % 2) ? KDTree::SIN_ID : (uint32_t)i);
+        iguales.remove({5, 5}, 0);  // ya no esta
+        igualesOk = igualesOk && iguales.size() == n - 1000 && iguales.rangeCount({5, 5, 5, 5}) == n - 1000;
+
+        // Pocas coordenadas distintas, borrando por punto y por id (normal y
+        // perezoso), contra fuerza bruta
+        std::mt19937 gen(11);
+        for (bool perezoso : {false, true}) {
+            std::vector<Punto2D> datos;
+            for (int i = 0; i < 5000; i++) datos.push_back({(float)(gen() % 6), (float)(gen() % 6)});
+            KDTree arbol(datos);
+            arbol.setLazyDeletion(perezoso);
+            // Primero por id: sin id se borra cualquier copia, tambien una que
+            // despues se pediria por su id
+            std::vector<Punto2D> vivos;
+            for (int i = 0; i < 5000; i += 3) arbol.remove(datos[i], (uint32_t)i);
+            for (int i = 1; i < 5000; i += 3) arbol.remove(datos[i]);
+            for (int i = 2; i < 5000; i += 3) vivos.push_back(datos[i]);
+            for (int i = 0; i < 500; i++) {
+                arbol.insert(datos[i]);
+                vivos.push_back(datos[i]);
+            }
+            igualesOk = igualesOk && arbol.size() == vivos.size() &&
+                        arbol.balanceStats().altura <= arbol.balanceStats().alturaPermitida;
+            for (Punto2D q : {Punto2D{2.5f, 2.5f}, Punto2D{0, 0}, Punto2D{3, 1.2f}, Punto2D{9, 9}}) {
+                Rectangulo r = {q.x - 1, q.x + 1, q.y - 1, q.y};
+                igualesOk = igualesOk &&
+                            distancias(arbol.kNearest(q, 300), q) == vecinosFuerzaBruta(vivos, q, 300) &&
+                            mismosPuntos(arbol.rangeSearch(r), rangoFuerzaBruta(vivos, r)) &&
+                            arbol.rangeCount(r) == rangoFuerzaBruta(vivos, r).size();
+            }
+        }
+
+        if (igualesOk) {
+            std::cout << "[TEST] Duplicate points: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Duplicate points: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for the node arena (move, clear, slot reuse)
+    {
+        std::cout << "\nRunning unit test for the node arena..." << std::endl;
+        std::vector<Punto2D> rejilla;
+        for (int x = 0; x < 16; x++)
+            for (int y = 0; y < 16; y++) rejilla.push_back({(float)x, (float)y});
+
+        // Mover cede los nodos: el destino responde y el origen queda vacio y usable
+        KDTree origen(rejilla);
+        KDTree movido(std::move(origen));
+        bool moverOk = movido.size() == 256 && movido.nearestId({3.1f, 4.2f}) == 3 * 16 + 4 &&
+                       origen.size() == 0 && origen.getRoot() == nullptr;
+        origen.insert({1.0f, 1.0f});
+        moverOk = moverOk && origen.size() == 1 && origen.nearest({0.0f, 0.0f}).x == 1.0f;
+
+        KDTree asignado;
+        asignado.insert({500.0f, 500.0f});  // sus nodos se liberan al asignar
+        asignado = std::move(movido);
+        moverOk = moverOk && asignado.size() == 256 && asignado.rangeCount({0, 3, 0, 3}) == 16 &&
+                  movido.size() == 0 && movido.getRoot() == nullptr &&
+                  asignado.nearest({499.0f, 499.0f}).x == 15.0f;
+        movido.insert({2.0f, 2.0f});
+        moverOk = moverOk && movido.size() == 1;
+
+        // clear() y volver a insertar
+        asignado.clear();
+        bool vacio = asignado.size() == 0 && asignado.getRoot() == nullptr;
+        for (int i = 0; i < 300; i++) asignado.insert({(float)i, 0.0f});
+        bool reinsertado = vacio && asignado.size() == 300 && asignado.nearestId({120.2f, 1.0f}) == 120;
+
+        // Tras remove, el siguiente insert reutiliza la ranura liberada
+        KDTree testTree(rejilla);
+        auto direcciones = [&] {
+            std::vector<KDNode*> nodos, pila;
+            if (testTree.getRoot()) pila.push_back(testTree.getRoot());
+            while (!pila.empty()) {
+                KDNode* n = pila.back();
+                pila.pop_back();
+                nodos.push_back(n);
+                if (n->izquierdo) pila.push_back(n->izquierdo);
+                if (n->derecho) pila.push_back(n->derecho);
+            }
+            std::sort(nodos.begin(), nodos.end());
+            return nodos;
+        };
+        std::vector<KDNode*> antes = direcciones();
+        testTree.remove({7.0f, 7.0f});
+        testTree.insert({7.5f, 7.5f});
+        std::vector<KDNode*> despues = direcciones();
+        bool reutilizada = despues.size() == 256 && antes == despues &&
+                           testTree.nearest({7.4f, 7.6f}).x == 7.5f;
+
+        if (moverOk && reinsertado && reutilizada) {
+            std::cout << "[TEST] Node arena: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Node arena: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for StaticKDTree (Eytzinger)
+    {
+        std::cout << "\nRunning unit test for StaticKDTree..." << std::endl;
+        std::mt19937 gen(4);
+        std::uniform_real_distribution<float> uniforme(0.f, 100.f);
+        std::uniform_int_distribution<int> celda(0, 4);
+        std::vector<Punto2D> consultas;
+        for (int i = 0; i < 50; i++) consultas.push_back({uniforme(gen), uniforme(gen)});
+        std::vector<Rectangulo> rectangulos = {
+            {10, 40, 20, 70}, {0, 100, 0, 100}, {50, 50, 0, 100}, {-9, -1, 0, 5}};
+
+        // 0, 1, 2^k - 1 y 2^k puntos, y 1000 puntos sobre solo 25 coordenadas
+        std::vector<std::vector<Punto2D>> entradas;
+        for (size_t n : {0, 1, 255, 256}) {
+            std::vector<Punto2D> puntos(n);
+            for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+            entradas.push_back(puntos);
+        }
+        std::vector<Punto2D> repetidos(1000);
+        for (auto& p : repetidos) p = {celda(gen) * 25.0f, celda(gen) * 25.0f};
+        entradas.push_back(repetidos);
+
+        bool iguales = true;
+        for (const std::vector<Punto2D>& puntos : entradas) {
+            KDTree arbol(puntos);
+            StaticKDTree estatico(puntos);
+            iguales = iguales && estatico.size() == puntos.size();
+            for (const Punto2D& q : consultas) {
+                iguales = iguales && (puntos.empty() ? estatico.nearestId(q) == KDTree::SIN_ID
+                                                     : distancia2(estatico.nearest(q), q) ==
+                                                           distancia2(arbol.nearest(q), q));
+                for (int k : {1, 7, 300}) {
+                    iguales = iguales && distancias(estatico.kNearest(q, k), q) ==
+                                             distancias(arbol.kNearest(q, k), q);
+                }
+            }
+            for (const Rectangulo& r : rectangulos) {
+                iguales = iguales && mismosPuntos(estatico.rangeSearch(r), arbol.rangeSearch(r));
+            }
+        }
+
+        if (iguales) {
+            std::cout << "[TEST] StaticKDTree: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] StaticKDTree: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for bucket leaves (BucketKDTree con cada nivel SIMD)
+    {
+        std::cout << "\nRunning unit test for bucket leaves..." << std::endl;
+        std::mt19937 gen(5);
+        std::uniform_real_distribution<float> uniforme(0.f, 100.f);
+        std::vector<Punto2D> consultas;
+        for (int i = 0; i < 40; i++) consultas.push_back({uniforme(gen), uniforme(gen)});
+        std::vector<Rectangulo> rectangulos = {
+            {10, 40, 20, 70}, {0, 100, 0, 100}, {30, 30, 0, 100}, {-9, -1, 0, 5}};
+
+        // n menor que B y n que no es multiplo de B (con algunos puntos repetidos)
+        std::vector<std::vector<Punto2D>> entradas;
+        for (size_t n : {100, 1000}) {
+            std::vector<Punto2D> puntos(n);
+            for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+            for (size_t i = 0; i < n / 10; i++) puntos[i] = puntos[n - 1 - i];
+            entradas.push_back(puntos);
+        }
+
+        bool iguales = true;
+        int niveles = 0;
+        for (NivelSimd nivel : {NivelSimd::Escalar, NivelSimd::SSE, NivelSimd::AVX2}) {
+            const KernelsDistancia* kernels = kernelsPara(nivel);
+            if (kernels == nullptr) continue;
+            niveles++;
+            for (const std::vector<Punto2D>& puntos : entradas) {
+                for (int hoja : {1, 256}) {
+                    BucketKDTree arbol(puntos, hoja);
+                    arbol.setKernels(*kernels);
+                    iguales = iguales && arbol.size() == puntos.size() && arbol.leafSize() == hoja;
+                    for (const Punto2D& q : consultas) {
+                        iguales = iguales &&
+                                  distancia2(arbol.nearest(q), q) == vecinosFuerzaBruta(puntos, q, 1)[0];
+                        for (int k : {1, 10, (int)puntos.size() + 5}) {
+                            iguales = iguales && distancias(arbol.kNearest(q, k), q) ==
+                                                     vecinosFuerzaBruta(puntos, q, k);
+                        }
+                    }
+                    for (const Rectangulo& r : rectangulos) {
+                        iguales = iguales && mismosPuntos(arbol.rangeSearch(r), rangoFuerzaBruta(puntos, r));
+                    }
+                }
+            }
+        }
+        BucketKDTree vacio(std::vector<Punto2D>{}, 32);
+        bool vacioOk = vacio.size() == 0 && vacio.kNearest({1, 1}, 3).empty() &&
+                       vacio.rangeSearch({0, 100, 0, 100}).empty();
+
+        if (iguales && vacioOk && niveles > 0) {
+            std::cout << "[TEST] Bucket leaves (" << niveles << " niveles SIMD): PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Bucket leaves: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for batch queries
+    {
+        std::cout << "\nRunning unit test for batch queries..." << std::endl;
+        std::mt19937 gen(6);
+        std::uniform_real_distribution<float> uniforme(0.f, 100.f);
+        std::vector<Punto2D> puntos(2000);
+        for (auto& p : puntos) p = {uniforme(gen), uniforme(gen)};
+        KDTree testTree(puntos);
+        std::vector<Punto2D> pocos = {{1, 1}, {5, 5}, {9, 2}, {3, 7}, {6, 6}};
+        KDTree pequeno(pocos);
+        KDTree vacio;
+        ThreadPool pool(4);
+
+        // 1000 consultas (no multiplo del bloque de 256), 300 consultas identicas
+        // (caja de Hilbert degenerada), un lote vacio y uno con coordenadas NaN e
+        // infinitas mezcladas con finitas
+        std::vector<std::vector<Punto2D>> lotes(4);
+        for (int i = 0; i < 1000; i++) lotes[0].push_back({uniforme(gen) * 1.2f - 10, uniforme(gen)});
+        lotes[1].assign(300, Punto2D{42.5f, 17.25f});
+        const float infinito = std::numeric_limits<float>::infinity();
+        for (int i = 0; i < 600; i++) lotes[3].push_back({uniforme(gen), uniforme(gen)});
+        lotes[3][7] = {infinito, 3};
+        lotes[3][300] = {-infinito, infinito};
+        lotes[3][301] = {std::nanf(""), 50};
+        lotes[3][599] = {20, -infinito};
+
+        // Cada casilla coincide con la consulta individual en su posicion original
+        auto comparar = [&](const KDTree& arbol, const std::vector<Punto2D>& lote, int k) {
+            std::vector<Punto2D> cercanos(lote.size()), vecinos(lote.size() * k);
+            arbol.nearestBatch(lote.data(), lote.size(), cercanos.data(), pool);
+            size_t validos = arbol.kNearestBatch(lote.data(), lote.size(), k, vecinos.data(), pool);
+            bool iguales = validos == std::min(arbol.size(), (size_t)k);
+            for (size_t i = 0; iguales && i < lote.size(); i++) {
+                Punto2D nn = arbol.nearest(lote[i]);
+                std::vector<Punto2D> knn = arbol.kNearest(lote[i], k);
+                iguales = cercanos[i].x == nn.x && cercanos[i].y == nn.y && knn.size() == validos;
+                for (size_t j = 0; iguales && j < validos; j++) {
+                    iguales = vecinos[i * k + j].x == knn[j].x && vecinos[i * k + j].y == knn[j].y;
+                }
+            }
+            return iguales;
+        };
+        bool correcto = true;
+        for (const std::vector<Punto2D>& lote : lotes) {
+            correcto = correcto && comparar(testTree, lote, 6) && comparar(pequeno, lote, 8) &&
+                       comparar(vacio, lote, 3);
+        }
+
+        if (correcto) {
+            std::cout << "[TEST] Batch queries: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Batch queries: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for rangeCount
+    {
+        std::cout << "\nRunning unit test for rangeCount..." << std::endl;
+        std::vector<Punto2D> rejilla;
+        for (int x = 0; x < 32; x++)
+            for (int y = 0; y < 32; y++) rejilla.push_back({(float)x, (float)y});
+        KDTree testTree(rejilla);
+        testTree.remove({5.0f, 5.0f});
+        testTree.insert({5.5f, 5.5f});
+
+        Rectangulo r = {2.0f, 9.0f, 3.0f, 12.0f};  // 8 x 10 puntos de la rejilla
+        size_t cuenta = testTree.rangeCount(r);
+        size_t esperado = testTree.rangeSearch(r).size();
+
+        if (cuenta == 80 && esperado == 80 && testTree.getRoot()->tamano == 1024) {
+            std::cout << "[TEST] Range count: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Range count: FAILED - " << cuenta << " vs " << esperado << std::endl;
+        }
+    }
+
+    // Unit test for bounding-box pruning
+    {
+        std::cout << "\nRunning unit test for bounding-box pruning..." << std::endl;
+        std::mt19937 gen(9);
+        std::uniform_real_distribution<float> uniforme(0.f, 100.f);
+        std::normal_distribution<float> normal(0.f, 2.f);
+        // Cumulos: muchas cajas pequenas y separadas, donde las dos podas difieren
+        std::vector<Punto2D> centros(8), puntos(2000);
+        for (auto& c : centros) c = {uniforme(gen), uniforme(gen)};
+        for (auto& p : puntos) {
+            const Punto2D& c = centros[gen() % centros.size()];
+            p = {c.x + normal(gen), c.y + normal(gen)};
+        }
+        KDTree testTree(puntos);
+
+        // insert y remove intercalados: las cajas se ensanchan y se recalculan
+        for (int i = 0; i < 1500; i++) {
+            if (i % 3 == 2) {
+                std::swap(puntos[gen() % puntos.size()], puntos.back());
+                testTree.remove(puntos.back());
+                puntos.pop_back();
+            } else {
+                Punto2D p = {centros[i % 8].x + normal(gen), uniforme(gen)};
+                testTree.insert(p);
+                puntos.push_back(p);
+            }
+        }
+
+        std::vector<Punto2D> consultas;
+        for (int i = 0; i < 100; i++) consultas.push_back({uniforme(gen) * 1.2f - 10, uniforme(gen)});
+        // Las dos podas responden como la fuerza bruta sobre los puntos vigentes
+        auto responde = [&](bool cajas) {
+            testTree.setBoundingBoxPruning(cajas);
+            bool correcto = testTree.size() == puntos.size();
+            for (const Punto2D& q : consultas) {
+                Rectangulo r = {q.x - 8, q.x + 8, q.y - 5, q.y + 12};
+                std::vector<Punto2D> rango = rangoFuerzaBruta(puntos, r);
+                correcto = correcto &&
+                           distancia2(testTree.nearest(q), q) == vecinosFuerzaBruta(puntos, q, 1)[0] &&
+                           distancias(testTree.kNearest(q, 9), q) == vecinosFuerzaBruta(puntos, q, 9) &&
+                           mismosPuntos(testTree.rangeSearch(r), rango) &&
+                           testTree.rangeCount(r) == rango.size();
+            }
+            return correcto;
+        };
+        bool conCajas = responde(true);
+        bool conPlano = responde(false);
+
+        if (conCajas && conPlano) {
+            std::cout << "[TEST] Bounding-box pruning: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Bounding-box pruning: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for self-balancing insert
+    {
+        std::cout << "\nRunning unit test for self-balancing insert..." << std::endl;
+        KDTree testTree;
+        for (int i = 0; i < 4096; i++) testTree.insert({(float)i, (float)i});
+        EstadisticasBalance e = testTree.balanceStats();
+
+        if (e.altura <= e.alturaPermitida && e.altura < 40 && testTree.nearest({2047.4f, 2047.6f}).x == 2047) {
+            std::cout << "[TEST] Self-balancing insert (altura=" << e.altura << "): PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Self-balancing insert: FAILED - altura " << e.altura << std::endl;
+        }
+    }
+
+    // Unit test for self-balancing insert with repeated points
+    {
+        std::cout << "\nRunning unit test for self-balancing insert with repeated points..." << std::endl;
+        // 4000 veces el mismo punto con alpha por defecto. Con ids automaticos el
+        // id desempata y el arbol se balancea como con datos ordenados; con un
+        // mismo id la cadena es inevitable, pero no debe reconstruirse entera en
+        // cada insercion (O(n^3) en total)
+        KDTree conIds, mismoId;
+        for (int i = 0; i < 4000; i++) {
+            conIds.insert({5, 5});
+            mismoId.insert({5, 5}, 7);
+        }
+        EstadisticasBalance e = conIds.balanceStats();
+        EstadisticasBalance cadena = mismoId.balanceStats();
+        mismoId.remove({5, 5}, 7);
+
+        if (e.altura <= e.alturaPermitida && e.altura < 40 && e.nodosReconstruidos < 100000 &&
+            conIds.rangeCount({5, 5, 5, 5}) == 4000 && cadena.reconstrucciones == 0 &&
+            mismoId.size() == 3999 && mismoId.nearestId({4, 4}) == 7) {
+            std::cout << "[TEST] Self-balancing insert, repeated points (altura=" << e.altura
+                      << "): PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Self-balancing insert, repeated points: FAILED - altura " << e.altura
+                      << ", " << e.nodosReconstruidos << " nodos reconstruidos, " << cadena.reconstrucciones
+                      << " reconstrucciones con un mismo id" << std::endl;
+        }
+    }
+
+    // Unit test for deep trees
+    {
+        std::cout << "\nRunning unit test for deep trees..." << std::endl;
+        // Insercion ordenada sin balanceo: una cadena de 100000 niveles. Con
+        // recursion cualquiera de estos recorridos agotaria la pila de llamadas.
+        const int n = 100000;
+        KDTree cadena;
+        cadena.setBalanceAlpha(1.0f);
+        std::vector<Punto2D> vivos;
+        for (int i = 0; i < n; i++) {
+            cadena.insert({(float)i, (float)i});
+            vivos.push_back({(float)i, (float)i});
+        }
+        bool profundoOk = cadena.balanceStats().altura == n;
+
+        // remove de la raiz: cada donante deja un hueco que llena el siguiente
+        // (findMin en cada nivel) hasta el fondo de la cadena; luego uno del medio
+        // y la hoja
+        for (int i : {0, n / 2, n - 1}) {
+            cadena.remove({(float)i, (float)i});
+            vivos.erase(std::find_if(vivos.begin(), vivos.end(), [i](const Punto2D& p) { return p.x == i; }));
+        }
+        auto comparar = [&] {
+            for (bool cajas : {false, true}) {
+                cadena.setBoundingBoxPruning(cajas);
+                for (Punto2D q : {Punto2D{0.2f, 0.1f}, Punto2D{50000.4f, 50000.3f}, Punto2D{2e5f, 2e5f}}) {
+                    Rectangulo r = {q.x - 700, q.x + 900, -1.f, (float)n};
+                    Punto2D nn = cadena.nearest(q);
+                    profundoOk = profundoOk && distancia2(nn, q) == vecinosFuerzaBruta(vivos, q, 1)[0] &&
+                                 distancias(cadena.kNearest(q, 8), q) == vecinosFuerzaBruta(vivos, q, 8) &&
+                                 mismosPuntos(cadena.rangeSearch(r), rangoFuerzaBruta(vivos, r)) &&
+                                 cadena.rangeCount(r) == rangoFuerzaBruta(vivos, r).size();
+                }
+            }
+        };
+        comparar();
+        profundoOk = profundoOk && cadena.size() == vivos.size() && cadena.balanceStats().altura == n - 3;
+
+        // Lapidas en la cadena y compact(): la reconstruccion la deja balanceada
+        cadena.setLazyDeletion(true);
+        for (int i = 1500; i < n; i += 1000) {
+            cadena.remove({(float)i, (float)i});
+            vivos.erase(std::find_if(vivos.begin(), vivos.end(), [i](const Punto2D& p) { return p.x == i; }));
+        }
+        comparar();
+        profundoOk = profundoOk && cadena.tombstones() > 0;
+        cadena.compact();
+        comparar();
+        int altura = cadena.balanceStats().altura;
+
+        if (profundoOk && cadena.tombstones() == 0 && cadena.size() == vivos.size() && altura == 17) {
+            std::cout << "[TEST] Deep tree (n=" << n << "): PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Deep tree: FAILED - altura " << altura << std::endl;
+        }
+    }
+
+    // Unit test for lazy deletion
+    {
+        std::cout << "\nRunning unit test for lazy deletion..." << std::endl;
+        std::vector<Punto2D> rejilla;
+        for (int x = 0; x < 16; x++)
+            for (int y = 0; y < 16; y++) rejilla.push_back({(float)x, (float)y});
+        KDTree testTree(rejilla);
+        testTree.setLazyDeletion(true);
+        testTree.setCompactionThreshold(1.0f);  // sin compactar: solo lapidas
+        testTree.remove(testTree.getRoot()->punto);
+        testTree.remove({3.0f, 3.0f});
+
+        Punto2D nn = testTree.nearest({3.1f, 3.0f});
+        size_t lapidas = testTree.tombstones();
+        testTree.compact();
+
+        if (testTree.size() == 254 && lapidas > 0 && testTree.tombstones() == 0 &&
+            !(nn.x == 3.0f && nn.y == 3.0f) && testTree.rangeCount({0, 15, 0, 15}) == 254) {
+            std::cout << "[TEST] Lazy deletion: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Lazy deletion: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for the logarithmic forest
+    {
+        std::cout << "\nRunning unit test for KDForest..." << std::endl;
+        std::mt19937 gen(12);
+        std::uniform_real_distribution<float> uniforme(0.f, 100.f);
+        // 1000 = 0b1111101000: seis arboles de 8 a 512 puntos a la vez
+        std::vector<Punto2D> puntos(1000);
+        KDForest bosque;
+        for (auto& p : puntos) {
+            p = {uniforme(gen), uniforme(gen)};
+            bosque.insert(p);
+        }
+        bool niveles = bosque.size() == 1000 && bosque.treeCount() == 6;
+        for (size_t i = 0; i < bosque.levels(); i++) {
+            size_t tamano = bosque.tree(i).size();
+            niveles = niveles && (tamano == 0 || tamano == (size_t(1) << i)) &&
+                      (tamano != 0) == (((1000 >> i) & 1) != 0);
+        }
+
+        // k = 600 supera al arbol mayor (512): los vecinos salen de varios arboles
+        bool iguales = true;
+        for (int i = 0; i < 40; i++) {
+            Punto2D q = {uniforme(gen) * 1.2f - 10, uniforme(gen)};
+            Rectangulo r = {q.x - 15, q.x + 15, q.y - 10, q.y + 20};
+            std::vector<Punto2D> rango = rangoFuerzaBruta(puntos, r);
+            iguales = iguales && distancia2(bosque.nearest(q), q) == vecinosFuerzaBruta(puntos, q, 1)[0] &&
+                      mismosPuntos(bosque.rangeSearch(r), rango) && bosque.rangeCount(r) == rango.size();
+            for (int k : {10, 600, 1200}) {
+                iguales = iguales && distancias(bosque.kNearest(q, k), q) == vecinosFuerzaBruta(puntos, q, k);
+            }
+        }
+
+        KDForest vacio;
+        bool vacioOk = vacio.size() == 0 && vacio.treeCount() == 0 && vacio.kNearest({1, 1}, 5).empty() &&
+                       vacio.rangeSearch({0, 100, 0, 100}).empty() && vacio.rangeCount({0, 100, 0, 100}) == 0;
+
+        if (niveles && iguales && vacioOk) {
+            std::cout << "[TEST] KDForest: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] KDForest: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for KDTreeND (3D, coordenadas enteras)
+    {
+        std::cout << "\nRunning unit test for KDTreeND<int32_t, 3>..." << std::endl;
+        using Punto3i = PuntoND<int32_t, 3>;
+        std::vector<Punto3i> rejilla;
+        for (int x = 0; x < 8; x++)
+            for (int y = 0; y < 8; y++)
+                for (int z = 0; z < 8; z++) rejilla.push_back({{x * 10, y * 10, z * 10}});
+        KDTreeND<int32_t, 3> testTree(rejilla);
+        testTree.remove({{30, 30, 30}});
+
+        Punto3i nn = testTree.nearest({{31, 32, 29}});
+        std::vector<Punto3i> vecinos = testTree.kNearest({{0, 0, 0}}, 4);
+        size_t cuenta = testTree.rangeCount({{10, 10, 10}, {30, 30, 30}});  // 3x3x3 menos uno
+
+        if (testTree.size() == 511 && !(nn[0] == 30 && nn[1] == 30 && nn[2] == 30) &&
+            vecinos.size() == 4 && vecinos[0][0] + vecinos[0][1] + vecinos[0][2] == 0 &&
+            cuenta == 26 && testTree.rangeSearch({{10, 10, 10}, {30, 30, 30}}).size() == 26) {
+            std::cout << "[TEST] KDTreeND<int32_t, 3>: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] KDTreeND<int32_t, 3>: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for point ids
+    {
+        std::cout << "\nRunning unit test for point ids..." << std::endl;
+        std::vector<Punto2D> rejilla;
+        for (int x = 0; x < 16; x++)
+            for (int y = 0; y < 16; y++) rejilla.push_back({(float)x, (float)y});
+        KDTree testTree(rejilla);  // id i = rejilla[i]
+        uint32_t copia = testTree.insert({7.0f, 7.0f});  // coordenadas repetidas, id nuevo
+        testTree.remove({7.0f, 7.0f}, 7 * 16 + 7);       // elimina el original, no la copia
+        for (int i = 0; i < 300; i++) testTree.insert({100.0f + i, 0.0f}, 1000 + i);
+
+        std::vector<uint32_t> vecinos = testTree.kNearestIds({0.1f, 0.2f}, 3);
+        std::vector<uint32_t> dentro = testTree.rangeSearchIds({6.5f, 7.5f, 6.5f, 7.5f});
+        bool idsValidos = vecinos.size() == 3 && vecinos[0] == 0 && dentro.size() == 1 &&
+                          dentro[0] == copia && copia == 256 &&
+                          testTree.nearestId({7.1f, 7.1f}) == copia &&
+                          testTree.nearestId({250.0f, 1.0f}) == 1150;
+        for (uint32_t id : vecinos) idsValidos = idsValidos && id < rejilla.size() &&
+                                                 rejilla[id].x + rejilla[id].y <= 1.0f;
+
+        if (idsValidos) {
+            std::cout << "[TEST] Point ids: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Point ids: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for range / radius visitors
+    {
+        std::cout << "\nRunning unit test for range / radius visitors..." << std::endl;
+        std::vector<Punto2D> rejilla;
+        for (int x = 0; x < 32; x++)
+            for (int y = 0; y < 32; y++) rejilla.push_back({(float)x, (float)y});
+        KDTree testTree(rejilla);
+
+        size_t enRango = 0;
+        testTree.forEachInRange({2.0f, 9.0f, 3.0f, 12.0f}, [&](const Punto2D&) { enRango++; });
+        size_t enRadio = 0;
+        float sumaIds = 0;
+        testTree.forEachInRadius({10.0f, 10.0f}, 1.0f, [&](const Punto2D& p, uint32_t id) {
+            enRadio++;
+            sumaIds += (rejilla[id].x == p.x && rejilla[id].y == p.y) ? 1.0f : -100.0f;
+        });
+        size_t hastaParar = 0;
+        testTree.forEachInRadius({16.0f, 16.0f}, 10.0f, [&](const Punto2D&) { return ++hastaParar < 3; });
+
+        if (enRango == 80 && enRadio == 5 && sumaIds == 5.0f && hastaParar == 3) {
+            std::cout << "[TEST] Range / radius visitors: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Range / radius visitors: FAILED - " << enRango << " " << enRadio
+                      << " " << hastaParar << std::endl;
+        }
+    }
+
+    // Unit test for approximate nearest / k-NN
+    {
+        std::cout << "\nRunning unit test for approximate nearest / k-NN..." << std::endl;
+        std::vector<Punto2D> rejilla;
+        for (int x = 0; x < 64; x++)
+            for (int y = 0; y < 64; y++) rejilla.push_back({(float)x, (float)y});
+        KDTree testTree(rejilla);
+        Punto2D q = {20.3f, 41.6f};
+
+        InformeAproximado exacta, aproximada, acotada;
+        Punto2D nn = testTree.nearestApprox(q, 0.0f, 0, &exacta);
+        Punto2D nnAprox = testTree.nearestApprox(q, 1.0f, 0, &aproximada);
+        std::vector<Punto2D> vecinos = testTree.kNearestApprox(q, 4, 0.0f, 10, &acotada);
+
+        float dx = nnAprox.x - q.x, dy = nnAprox.y - q.y;
+        float dExacta = 0.3f * 0.3f + 0.4f * 0.4f;
+        if (exacta.exacto && nn.x == 20 && nn.y == 42 && dx * dx + dy * dy <= 4.0f * dExacta &&
+            aproximada.nodosVisitados <= exacta.nodosVisitados && !acotada.exacto &&
+            acotada.nodosVisitados == 10 && vecinos.size() == 4) {
+            std::cout << "[TEST] Approximate nearest / k-NN: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Approximate nearest / k-NN: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for persistent snapshots
+    {
+        std::cout << "\nRunning unit test for persistent snapshots..." << std::endl;
+        std::vector<Punto2D> rejilla;
+        for (int x = 0; x < 32; x++)
+            for (int y = 0; y < 32; y++) rejilla.push_back({(float)x, (float)y});
+        PersistentKDTree arbol(rejilla);
+        Rectangulo todo = {-1, 100, -1, 100};
+
+        bool correcto = true;
+        {
+            auto viejo = arbol.snapshot();
+            for (int i = 0; i < 200; i++) arbol.insert({50.0f + i % 20, 50.0f + i / 20});
+            for (int i = 0; i < 300; i++) arbol.remove(rejilla[i]);
+            auto nuevo = arbol.snapshot();
+            // La version vieja no ve ni las inserciones ni los borrados
+            correcto = viejo.size() == 1024 && viejo.rangeCount(todo) == 1024 &&
+                       viejo.nearestId({0.1f, 0.1f}) == 0 && nuevo.size() == 924 &&
+                       nuevo.rangeCount(todo) == 924 && arbol.size() == 924;
+        }
+
+        // Un escritor y un lector a la vez: cada snapshot es coherente consigo mismo
+        std::thread escritor([&] {
+            for (int i = 0; i < 2000; i++) {
+                Punto2D p = {60.0f + i % 40, 10.0f + i / 40};
+                arbol.insert(p);
+                if (i % 2) arbol.remove(p);
+            }
+        });
+        for (int i = 0; i < 2000 && correcto; i++) {
+            auto s = arbol.snapshot();
+            correcto = s.rangeCount(todo) == s.size() && s.rangeSearch(todo).size() == s.size();
+        }
+        escritor.join();
+
+        // El atributo llega al nodo nuevo y al rango de atributo de la raiz
+        arbol.insert({200.0f, 200.0f}, 5000, 42.0f);
+        auto ultimo = arbol.snapshot();
+        const auto* raiz = ultimo.getRoot();
+        correcto = correcto && ultimo.nearestId({200.0f, 200.0f}) == 5000 && raiz->atributoMin == 0.0f &&
+                   raiz->atributoMax == 42.0f;
+
+        if (correcto && arbol.size() == 1925) {
+            std::cout << "[TEST] Persistent snapshots: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Persistent snapshots: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for memory-mapped snapshots
+    {
+        std::cout << "\nRunning unit test for memory-mapped snapshots..." << std::endl;
+        KDTree testTree;
+        for (int i = 0; i < 500; i++) testTree.insert({(float)(i * 37 % 101), (float)(i * 53 % 97)}, 1000 + i);
+        StaticKDTree original(testTree);
+        const char* ruta = "kdtree-test.kds";
+
+        StaticKDTree mapeado, corrupto;
+        EstadoSnapshot guardado = original.saveSnapshot(ruta);
+        EstadoSnapshot abierto = mapeado.openSnapshot(ruta, true);
+        Punto2D q = {50.37f, 20.21f};
+        Rectangulo r = {10, 40, 10, 40};
+        bool iguales = mapeado.isMapped() && mapeado.size() == 500 &&
+                       mapeado.nearestId(q) == testTree.nearestId(q) &&
+                       mapeado.kNearestIds(q, 5) == testTree.kNearestIds(q, 5) &&
+                       mapeado.rangeSearch(r).size() == testTree.rangeCount(r);
+
+        // Un byte cambiado en los datos: la cabecera sigue siendo valida, el checksum no
+        if (FILE* archivo = std::fopen(ruta, "r+b")) {
+            std::fseek(archivo, 100, SEEK_SET);
+            std::fputc(0x5A, archivo);
+            std::fclose(archivo);
+        }
+        EstadoSnapshot verificado = corrupto.openSnapshot(ruta, true);
+
+        // Cabecera manipulada con checksum recalculado (FNV-1a no impide
+        // falsificarlo): un desplazamiento cerca de 2^64 haria desbordar
+        // desplazamiento + n * tamano y apuntar fuera del archivo mapeado
+        auto desplazamientoFalso = [&](long campo) {
+            original.saveSnapshot(ruta);
+            unsigned char cabecera[64];
+            FILE* archivo = std::fopen(ruta, "r+b");
+            if (archivo == nullptr || std::fread(cabecera, 1, 64, archivo) != 64) {
+                if (archivo) std::fclose(archivo);
+                return EstadoSnapshot::ErrorES;
+            }
+            std::uint64_t valor = ~std::uint64_t(63);  // 2^64 - 64, alineado a 64
+            std::memcpy(cabecera + campo, &valor, sizeof(valor));
+            std::uint64_t h = 14695981039346656037ull;  // FNV-1a de los 56 bytes anteriores al checksum
+            for (int i = 0; i < 56; i++) h = (h ^ cabecera[i]) * 1099511628211ull;
+            std::memcpy(cabecera + 56, &h, sizeof(h));
+            std::fseek(archivo, 0, SEEK_SET);
+            std::fwrite(cabecera, 1, 64, archivo);
+            std::fclose(archivo);
+            StaticKDTree manipulado;
+            EstadoSnapshot estado = manipulado.openSnapshot(ruta);
+            return manipulado.size() == 0 ? estado : EstadoSnapshot::Ok;
+        };
+        bool desplazamientos = desplazamientoFalso(24) == EstadoSnapshot::FormatoInvalido &&  // puntos
+                               desplazamientoFalso(32) == EstadoSnapshot::FormatoInvalido;    // ids
+        std::remove(ruta);
+
+        if (guardado == EstadoSnapshot::Ok && abierto == EstadoSnapshot::Ok && iguales &&
+            verificado == EstadoSnapshot::ChecksumInvalido && corrupto.size() == 0 && desplazamientos) {
+            std::cout << "[TEST] Memory-mapped snapshots: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Memory-mapped snapshots: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for the CSV point loader
+    {
+        std::cout << "\nRunning unit test for the CSV point loader..." << std::endl;
+        const char* ruta = "kdtree-test.csv";
+        if (FILE* archivo = std::fopen(ruta, "wb")) {
+            std::fputs("x,y\n10,20\n 30.5 , 40\n\n500,1\n-7,8\r\n", archivo);
+            std::fclose(archivo);
+        }
+        KDTree testTree;
+        PointLoader::Opciones opciones;
+        opciones.cabecera = true;
+        opciones.dominio = {-100, 100, -100, 100};
+        opciones.tamanoBloque = 8;  // varios bloques aun con un archivo diminuto
+        InformeCarga informe = PointLoader::loadCsv(ruta, testTree, opciones);
+
+        // Fila mal formada: error con su numero de linea y el arbol sin tocar
+        if (FILE* archivo = std::fopen(ruta, "wb")) {
+            std::fputs("1,2\n3;4\n", archivo);
+            std::fclose(archivo);
+        }
+        InformeCarga erroneo = PointLoader::loadCsv(ruta, testTree);
+        std::remove(ruta);
+
+        // La linea vacia cuenta como registro y consume su id: (-7, 8) tiene el id 4
+        if (informe.estado == EstadoCarga::Ok && informe.registros == 5 && informe.puntos == 3 &&
+            informe.descartados == 1 &&
+            testTree.size() == 3 && testTree.nearestId({30, 40}) == 1 && testTree.nearestId({-7, 8}) == 4 &&
+            erroneo.estado == EstadoCarga::ErrorFormato && erroneo.lineaError == 2) {
+            std::cout << "[TEST] CSV point loader: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] CSV point loader: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for query statistics
+    {
+        std::cout << "\nRunning unit test for query statistics..." << std::endl;
+        std::vector<Punto2D> rejilla;
+        for (int x = 0; x < 32; x++)
+            for (int y = 0; y < 32; y++) rejilla.push_back({(float)x, (float)y});
+        KDTree testTree(rejilla);  // 1024 puntos: 11 niveles (0 a 10)
+        Punto2D q = {12.3f, 7.6f};
+
+        // nearest recorre exactamente lo mismo que la busqueda aproximada exacta
+        QueryStats cercano;
+        InformeAproximado informe;
+        Punto2D nn = testTree.nearest(q, &cercano);
+        testTree.nearestApprox(q, 0.0f, 0, &informe);
+
+        // Los contadores se acumulan entre llamadas
+        QueryStats doble;
+        testTree.kNearest(q, 5, &doble);
+        testTree.kNearest(q, 5, &doble);
+        QueryStats vecinos;
+        std::vector<Punto2D> knn = testTree.kNearest(q, 5, &vecinos);
+
+        QueryStats rango;
+        std::vector<Punto2D> enRango = testTree.rangeSearch({4.5f, 9.5f, 4.5f, 9.5f}, &rango);
+
+        QueryStats borrado;
+        testTree.remove({31.0f, 31.0f}, KDTree::SIN_ID, &borrado);
+
+        bool nearestOk = nn.x == 12 && nn.y == 8 && cercano.nodosVisitados == informe.nodosVisitados &&
+                         cercano.subarbolesPodados > 0 && cercano.distancias >= cercano.nodosVisitados &&
+                         cercano.profundidadMaxima >= 9 && cercano.profundidadMaxima <= 10;
+        bool kNearestOk = knn.size() == 5 && knn[0].x == 12 && knn[0].y == 8 &&
+                          doble.nodosVisitados == 2 * vecinos.nodosVisitados;
+        bool rangoOk = enRango.size() == 25 && rango.nodosVisitados >= 25 &&
+                       rango.nodosVisitados < 1024 && rango.subarbolesPodados > 0;
+        if (nearestOk && kNearestOk && rangoOk && borrado.nodosVisitados > 0 && testTree.size() == 1023) {
+            std::cout << "[TEST] Query stats: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Query stats: FAILED - " << cercano.nodosVisitados << " "
+                      << informe.nodosVisitados << " " << cercano.profundidadMaxima << " "
+                      << rango.nodosVisitados << std::endl;
+        }
+    }
+
+    // Unit test for latency histograms
+    {
+        std::cout << "\nRunning unit test for latency histograms..." << std::endl;
+        LatencyHistogram h;
+        for (std::uint64_t v = 1; v <= 100000; v++) h.record(v);
+        // Error relativo de una cubeta: <= 1/32
+        bool precision = h.count() == 100000 && h.min() == 1 && h.max() == 100000 &&
+                         std::abs((double)h.percentile(50) - 50000) <= 50000 / 32.0 &&
+                         std::abs((double)h.percentile(99) - 99000) <= 99000 / 32.0 &&
+                         h.percentile(100) == 100000 && LatencyHistogram::cubeta(31) == 31;
+
+        std::vector<Punto2D> rejilla;
+        for (int x = 0; x < 32; x++)
+            for (int y = 0; y < 32; y++) rejilla.push_back({(float)x, (float)y});
+        KDTree testTree(rejilla);
+        testTree.nearest({1, 1});  // desactivados: no se registra
+        testTree.setLatencyHistograms(true);
+        auto consultar = [&] {
+            for (int i = 0; i < 500; i++) {
+                testTree.nearest({i % 32 + 0.3f, 5.1f});
+                testTree.rangeSearch({0, 4, 0, 4});
+            }
+        };
+        std::thread otro(consultar);
+        consultar();
+        otro.join();
+        testTree.remove({3, 3});
+
+        const LatencyRecorder* registro = testTree.latencyRecorder();
+        LatencyHistogram cercanos = registro->snapshot(OperacionConsulta::Nearest);
+        bool arbolOk = registro->threads() == 2 && cercanos.count() == 1000 &&
+                       cercanos.percentile(50) <= cercanos.percentile(99) &&
+                       registro->snapshot(OperacionConsulta::RangeSearch).count() == 1000 &&
+                       registro->snapshot(OperacionConsulta::Remove).count() == 1 &&
+                       registro->snapshot(OperacionConsulta::Insert).count() == 0 &&
+                       registro->toJson().find("\"p999_ns\"") != std::string::npos;
+        testTree.setLatencyHistograms(false);
+
+        // Las sobrecargas con QueryStats y las consultas sobre un arbol vacio
+        // tambien se registran: una por llamada, sin contarse dos veces
+        testTree.setLatencyHistograms(true);
+        QueryStats stats;
+        testTree.nearest({1, 1}, &stats);
+        testTree.nearest({1, 1}, nullptr);
+        testTree.kNearest({1, 1}, 3, &stats);
+        testTree.rangeSearch({0, 2, 0, 2}, &stats);
+        testTree.remove({4, 4}, KDTree::SIN_ID, &stats);
+        KDTree vacio;
+        vacio.setLatencyHistograms(true);
+        vacio.nearest({1, 1});
+        vacio.kNearest({1, 1}, 3);
+        vacio.kNearest({1, 1}, 3, &stats);
+        const LatencyRecorder* conStats = testTree.latencyRecorder();
+        arbolOk = arbolOk && conStats->snapshot(OperacionConsulta::Nearest).count() == 2 &&
+                  conStats->snapshot(OperacionConsulta::KNearest).count() == 1 &&
+                  conStats->snapshot(OperacionConsulta::RangeSearch).count() == 1 &&
+                  conStats->snapshot(OperacionConsulta::Remove).count() == 1 &&
+                  vacio.latencyRecorder()->snapshot(OperacionConsulta::Nearest).count() == 1 &&
+                  vacio.latencyRecorder()->snapshot(OperacionConsulta::KNearest).count() == 2;
+        testTree.setLatencyHistograms(false);
+
+        if (precision && arbolOk && testTree.latencyRecorder() == nullptr) {
+            std::cout << "[TEST] Latency histograms: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Latency histograms: FAILED" << std::endl;
+        }
+    }
+
+    // Unit test for the incremental neighbor iterator
+    {
+        std::cout << "\nRunning unit test for the neighbor iterator..." << std::endl;
+        std::vector<Punto2D> rejilla;
+        for (int x = 0; x < 32; x++)
+            for (int y = 0; y < 32; y++) rejilla.push_back({(float)x, (float)y});
+        KDTree testTree(rejilla);
+        testTree.setLazyDeletion(true);
+        testTree.remove({10.0f, 10.0f});  // lapida: el iterador no la entrega
+        Punto2D q = {10.2f, 10.1f};
+
+        // Los primeros 9 coinciden con kNearest(9) y el recorrido sigue sin repetirse
+        NeighborIterator it(testTree, q);
+        std::vector<Punto2D> primeros;
+        while (primeros.size() < 9 && it.next()) primeros.push_back(it.point());
+        std::vector<Punto2D> knn = testTree.kNearest(q, 9);
+        bool iguales = primeros.size() == 9;
+        for (size_t i = 0; iguales && i < 9; i++) {
+            iguales = primeros[i].x == knn[i].x && primeros[i].y == knn[i].y;
+        }
+
+        bool ordenado = true, lapida = false;
+        float anterior = 0;
+        size_t total = primeros.size();
+        while (it.next()) {
+            ordenado = ordenado && it.distanceSquared() >= anterior;
+            anterior = it.distanceSquared();
+            lapida = lapida || (it.point().x == 10.0f && it.point().y == 10.0f);
+            total++;
+        }
+
+        if (iguales && ordenado && !lapida && total == 1023 && it.count() == 1023 && !it.next()) {
+            std::cout << "[TEST] Neighbor iterator: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Neighbor iterator: FAILED - " << total << std::endl;
+        }
+    }
+
+    // Unit test for disk and convex-polygon queries
+    {
+        std::cout << "\nRunning unit test for disk / polygon queries..." << std::endl;
+        std::vector<Punto2D> rejilla;
+        for (int x = 0; x < 20; x++)
+            for (int y = 0; y < 20; y++) rejilla.push_back({(float)x, (float)y});
+        KDTree testTree(rejilla);
+
+        // Rombo |x - 10| + |y - 10| <= 3 (horario): 25 puntos de la rejilla, incluidos los del borde
+        std::vector<Punto2D> rombo = {{10, 13}, {13, 10}, {10, 7}, {7, 10}};
+        std::vector<Punto2D> dentro = testTree.polygonSearch(rombo);
+        bool romboOk = dentro.size() == 25;
+        for (const Punto2D& p : dentro) romboOk = romboOk && std::fabs(p.x - 10) + std::fabs(p.y - 10) <= 3;
+        std::reverse(rombo.begin(), rombo.end());
+        romboOk = romboOk && testTree.polygonSearchIds(rombo).size() == 25;
+
+        // Disco de radio 2 en (5, 5): 13 puntos; sin poda por cajas, el mismo resultado
+        size_t disco = testTree.radiusSearch({5, 5}, 2.0f).size();
+        testTree.setBoundingBoxPruning(false);
+        size_t discoPlano = testTree.radiusSearchIds({5, 5}, 2.0f).size();
+        size_t romboPlano = testTree.polygonSearch(rombo).size();
+        bool degenerado = testTree.polygonSearch({{0, 0}, {5, 5}}).empty();
+
+        if (romboOk && disco == 13 && discoPlano == 13 && romboPlano == 25 && degenerado) {
+            std::cout << "[TEST] Disk / polygon queries: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Disk / polygon queries: FAILED - " << dentro.size() << " " << disco << std::endl;
+        }
+    }
+
+    // Unit test for attribute-filtered queries
+    {
+        std::cout << "\nRunning unit test for attribute filters..." << std::endl;
+        // Rejilla 16x16 con atributo = x: el filtro [4, 6] deja las columnas 4, 5 y 6
+        std::vector<Punto2D> rejilla;
+        std::vector<float> atributos;
+        for (int x = 0; x < 16; x++) {
+            for (int y = 0; y < 16; y++) {
+                rejilla.push_back({(float)x, (float)y});
+                atributos.push_back((float)x);
+            }
+        }
+        KDTree testTree;
+        testTree.build(rejilla, atributos);
+        FiltroAtributo columnas{4.0f, 6.0f};
+
+        Punto2D cercano = testTree.nearest({0.2f, 8.0f}, columnas);
+        std::vector<std::uint32_t> vecinos = testTree.kNearestIds({0.0f, 8.0f}, 5, columnas);
+        bool vecinosOk = vecinos.size() == 5;
+        for (std::uint32_t id : vecinos) vecinosOk = vecinosOk && atributos[id] >= 4.0f && atributos[id] <= 6.0f;
+        size_t enRango = testTree.rangeSearch({0.0f, 15.0f, 0.0f, 3.0f}, columnas).size();  // 3 x 4
+
+        // Un insert con atributo entra en el filtro; un filtro sin puntos no devuelve nada
+        testTree.insert({1.0f, 1.0f}, 1000, 5.0f);
+        std::uint32_t nuevo = testTree.nearestId({0.0f, 0.0f}, columnas);
+        bool vacio = testTree.nearestId({0.0f, 0.0f}, FiltroAtributo{100.0f, 200.0f}) == KDTree::SIN_ID &&
+                     testTree.kNearest({0.0f, 0.0f}, 3, FiltroAtributo{100.0f, 200.0f}).empty();
+
+        if (cercano.x == 4.0f && cercano.y == 8.0f && vecinosOk && enRango == 12 && nuevo == 1000 && vacio) {
+            std::cout << "[TEST] Attribute filters: PASSED" << std::endl;
+        } else {
+            std::cout << "[TEST] Attribute filters: FAILED - " << enRango << " " << nuevo << std::endl;
+        }
+    }
+
     // Llamamos al visualizador (todo lo relacionado con SFML está en Visualizer.cpp)
     runVisualizer(tree, puntos);
 